@@ -0,0 +1,206 @@
+// JS 接口的基准测试，结果以 JSON 输出到标准输出
+// 用法: node bench/api.js [--filter 名称] [--rounds N]
+const sharedMemory = require('../build/sharedMemory.node');
+const { fork } = require('child_process');
+
+const args = process.argv.slice(2);
+const option = (name, fallback) => {
+    const index = args.indexOf(name);
+    return index >= 0 ? args[index + 1] : fallback;
+};
+const filter = option('--filter', '');
+const rounds = Number(option('--rounds', 20000));
+const prefix = `bench_api_${process.pid}`;
+
+function now() {
+    return process.hrtime.bigint();
+}
+
+// 重复执行直到达到次数，返回每次调用的耗时分位数（纳秒）
+function measure(name, iterations, fn, extra = {}) {
+    for (let i = 0; i < Math.min(iterations, 100); i++) {
+        fn(i);
+    }
+    const samples = new Float64Array(iterations);
+    for (let i = 0; i < iterations; i++) {
+        const start = now();
+        fn(i);
+        samples[i] = Number(now() - start);
+    }
+    return summarize(name, samples, extra);
+}
+
+function summarize(name, samples, extra) {
+    samples.sort();
+    const at = q => samples[Math.min(samples.length - 1, Math.floor(samples.length * q))];
+    let total = 0;
+    for (const value of samples) {
+        total += value;
+    }
+    return { name, iterations: samples.length, meanNs: total / samples.length, p50Ns: at(0.5), p99Ns: at(0.99), maxNs: samples[samples.length - 1], ...extra };
+}
+
+// 打开开销：首次 getMemory 建立映射，之后命中进程内缓存
+function benchOpen(results) {
+    for (const size of [4096, 1 << 20, 64 << 20]) {
+        const key = `${prefix}_open_${size}`;
+        sharedMemory.setMemory(key, size);
+        results.push(measure(`getMemory/${size}`, rounds, () => sharedMemory.getMemory(key), { bytes: size }));
+        results.push(measure(`setMemory/${size}`, Math.min(rounds, 2000), () => sharedMemory.setMemory(key, size), { bytes: size }));
+        sharedMemory.removeMemory(key);
+    }
+}
+
+// 经 Buffer 写入共享内存的带宽
+function benchCopy(results) {
+    for (const size of [4096, 1 << 20, 64 << 20]) {
+        const key = `${prefix}_copy_${size}`;
+        const target = new Uint8Array(sharedMemory.setMemory(key, size));
+        const source = new Uint8Array(size).fill(0x5a);
+        const iterations = Math.max(10, Math.min(rounds, Math.floor((1 << 30) / size)));
+        const result = measure(`copy/${size}`, iterations, () => target.set(source), { bytes: size });
+        result.bytesPerSecond = size / (result.meanNs / 1e9);
+        results.push(result);
+        sharedMemory.removeMemory(key);
+    }
+}
+
+// 批量操作与 JS 循环的对比：复制、比较和校验和
+function benchBulk(results) {
+    const size = 64 << 20;
+    const first = `${prefix}_bulk_a`;
+    const second = `${prefix}_bulk_b`;
+    const a = new Uint8Array(sharedMemory.setMemory(first, size));
+    const b = new Uint8Array(sharedMemory.setMemory(second, size));
+    a.fill(0x5a);
+    b.fill(0x5a);
+    const iterations = Math.max(10, Math.min(rounds, 50));
+    const bandwidth = (name, fn) => {
+        const result = measure(`${name}/${size}`, iterations, fn, { bytes: size, kernels: sharedMemory.bulkKernels() });
+        result.bytesPerSecond = size / (result.meanNs / 1e9);
+        results.push(result);
+    };
+    bandwidth('copyRegion', () => sharedMemory.copyRegion(first, 0, second, 0, size));
+    bandwidth('compareRegions', () => sharedMemory.compareRegions(first, 0, second, 0, size));
+    bandwidth('compareLoop', () => {
+        for (let i = 0; i < size; i++) {
+            if (a[i] !== b[i]) {
+                return i;
+            }
+        }
+        return -1;
+    });
+    bandwidth('checksum/crc32c', () => sharedMemory.checksum(first, 0, size));
+    bandwidth('checksum/xxh3', () => sharedMemory.checksum(first, 0, size, 'xxh3'));
+    sharedMemory.removeMemory(first);
+    sharedMemory.removeMemory(second);
+}
+
+// 增量同步与整段复制的对比：每轮在 64 MiB 中分散修改 16 个块，只同步变更的块
+function benchDelta(results) {
+    const size = 64 << 20;
+    const source = `${prefix}_delta_a`;
+    const replica = `${prefix}_delta_b`;
+    const view = new Uint8Array(sharedMemory.setMemory(source, size, { trackDirty: true }));
+    sharedMemory.setMemory(replica, size);
+    // 第一次收集得到全部内容，之后只有变更
+    let epoch = sharedMemory.collectDelta(source, 0).epoch;
+    sharedMemory.copyRegion(source, 0, replica, 0, size);
+    const iterations = Math.max(10, Math.min(rounds, 2000));
+    const touch = i => {
+        for (let j = 0; j < 16; j++) {
+            const offset = ((i * 16 + j) * 7919 * 4096) % size;
+            view[offset] = i;
+            sharedMemory.markDirty(source, offset, 1);
+        }
+    };
+    results.push(measure(`collectDelta+applyDelta/${size}`, iterations, i => {
+        touch(i);
+        const delta = sharedMemory.collectDelta(source, epoch);
+        epoch = delta.epoch;
+        sharedMemory.applyDelta(replica, delta);
+    }, { bytes: size, changedBlocks: 16 }));
+    results.push(measure(`copyRegion/${size}`, Math.max(10, Math.min(rounds, 50)), i => {
+        touch(i);
+        sharedMemory.copyRegion(source, 0, replica, 0, size);
+    }, { bytes: size, changedBlocks: 16 }));
+    sharedMemory.removeMemory(source);
+    sharedMemory.removeMemory(replica);
+}
+
+// 子进程 index 等待令牌等于自己的序号，再传给下一个，最后一个传回 0
+function pingPongChild(key, index, processes) {
+    const view = new Int32Array(sharedMemory.getMemory(key));
+    const next = index === processes ? 0 : index + 1;
+    // 确认消息发出后再进入阻塞循环
+    process.send('ready', () => {
+        for (;;) {
+            const value = Atomics.load(view, 0);
+            if (Atomics.load(view, 16)) {
+                process.exit(0);
+            }
+            if (value !== index) {
+                sharedMemory.wait(key, 0, value, 100);
+                continue;
+            }
+            Atomics.store(view, 0, next);
+            sharedMemory.notify(key, 0);
+        }
+    });
+}
+
+// 跨进程往返：一次迭代令牌经过所有子进程回到本进程
+async function benchPingPong(results) {
+    for (const processes of [1, 2, 4, 8, 16]) {
+        const key = `${prefix}_pingpong_${processes}`;
+        // 令牌与停止标志分处不同缓存行
+        const view = new Int32Array(sharedMemory.setMemory(key, 128));
+        view.fill(0);
+        const children = [];
+        for (let i = 1; i <= processes; i++) {
+            const child = fork(__filename, ['--child', key, String(i), String(processes)]);
+            children.push(new Promise(resolve => child.once('message', resolve)).then(() => child));
+        }
+        const started = await Promise.all(children);
+        const exited = started.map(child => new Promise(resolve => child.once('exit', resolve)));
+
+        const iterations = Math.max(100, Math.floor(rounds / (processes * 10)));
+        const round = () => {
+            Atomics.store(view, 0, 1);
+            sharedMemory.notify(key, 0);
+            let value;
+            while ((value = Atomics.load(view, 0)) !== 0) {
+                sharedMemory.wait(key, 0, value, 100);
+            }
+        };
+        results.push(measure(`pingPong/${processes}`, iterations, round, { processes }));
+
+        Atomics.store(view, 16, 1);
+        sharedMemory.notify(key, 0);
+        await Promise.all(exited);
+        sharedMemory.removeMemory(key);
+    }
+}
+
+async function main() {
+    const results = [];
+    const suites = { open: benchOpen, copy: benchCopy, bulk: benchBulk, delta: benchDelta, pingPong: benchPingPong };
+    for (const [name, run] of Object.entries(suites)) {
+        if (!filter || name.includes(filter)) {
+            await run(results);
+        }
+    }
+    console.log(JSON.stringify({
+        context: { date: new Date().toISOString(), node: process.version, platform: process.platform, arch: process.arch, rounds },
+        benchmarks: results,
+    }, null, 2));
+}
+
+if (args[0] === '--child') {
+    pingPongChild(args[1], Number(args[2]), Number(args[3]));
+} else {
+    main().catch(error => {
+        console.error('基准测试失败:', error);
+        process.exit(1);
+    });
+}
@@ -0,0 +1,213 @@
+// 原生核心的基准测试，使用 --benchmark_format=json 输出机器可读的结果
+#include "shared_memory.hh"
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#endif
+
+using namespace SharedMemory;
+
+namespace {
+    std::string bench_key(const char* name) {
+#ifdef _WIN32
+        return std::string("bench_") + name + "_" + std::to_string(GetCurrentProcessId());
+#else
+        return std::string("bench_") + name + "_" + std::to_string(getpid());
+#endif
+    }
+
+    // 删除基准测试创建的共享内存对象
+    void unlink_segment(const std::string& key) {
+#ifndef _WIN32
+        shm_unlink(("/skyline_" + key + ".dat").c_str());
+#else
+        remove_segment(key);
+#endif
+    }
+
+    // 创建新的共享内存（每次迭代删除后重建，对象和页面都是新的）
+    void BM_CreateCold(benchmark::State& state) {
+        std::string key = bench_key("create");
+        size_t size = static_cast<size_t>(state.range(0));
+        for (auto _ : state) {
+            SharedMemoryManager manager(key, true, size);
+            benchmark::DoNotOptimize(manager.get_data());
+            state.PauseTiming();
+            unlink_segment(key);
+            state.ResumeTiming();
+        }
+    }
+    BENCHMARK(BM_CreateCold)->RangeMultiplier(64)->Range(4 << 10, 256 << 20)->Unit(benchmark::kMicrosecond);
+
+    // 不经缓存打开已有的共享内存：shm_open、加锁、读取头部和 mmap
+    void BM_OpenCold(benchmark::State& state) {
+        std::string key = bench_key("open");
+        size_t size = static_cast<size_t>(state.range(0));
+        auto owner = create_manager(key, size);
+        for (auto _ : state) {
+            SharedMemoryManager manager(key, false);
+            benchmark::DoNotOptimize(manager.get_data());
+        }
+        owner.reset();
+        evict_manager(key);
+        unlink_segment(key);
+    }
+    BENCHMARK(BM_OpenCold)->RangeMultiplier(64)->Range(4 << 10, 256 << 20)->Unit(benchmark::kMicrosecond);
+
+    // 映射缓存命中：getMemory 的常见路径
+    void BM_OpenWarm(benchmark::State& state) {
+        std::string key = bench_key("warm");
+        auto owner = create_manager(key, 4 << 10);
+        for (auto _ : state) {
+            auto manager = acquire_manager(key);
+            manager->refresh();
+            benchmark::DoNotOptimize(manager.get());
+        }
+        owner.reset();
+        evict_manager(key);
+        unlink_segment(key);
+    }
+    BENCHMARK(BM_OpenWarm);
+
+    // 写入已映射数据区的带宽，首轮之后页面均已建立
+    void BM_MemcpyInto(benchmark::State& state) {
+        std::string key = bench_key("memcpy");
+        size_t size = static_cast<size_t>(state.range(0));
+        auto manager = create_manager(key, size);
+        std::vector<uint8_t> source(size, 0x5a);
+        manager->prefault(0);
+        for (auto _ : state) {
+            memcpy(manager->get_data(), source.data(), size);
+            benchmark::ClobberMemory();
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(size));
+        manager.reset();
+        evict_manager(key);
+        unlink_segment(key);
+    }
+    BENCHMARK(BM_MemcpyInto)->RangeMultiplier(16)->Range(4 << 10, 64 << 20);
+
+    // 批量操作的带宽，参数为数据长度，依次测试 CPU 支持的每种实现
+    template <typename Operation>
+    void run_bulk(benchmark::State& state, Operation operation) {
+        size_t size = static_cast<size_t>(state.range(0));
+        std::vector<uint8_t> first(size, 0x5a);
+        std::vector<uint8_t> second(size, 0x5a);
+        for (auto _ : state) {
+            operation(first.data(), second.data(), size);
+            benchmark::ClobberMemory();
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(size));
+        state.SetLabel(bulk_kernels());
+    }
+
+    void BM_CopyBytes(benchmark::State& state, const char* kernels) {
+        if (!select_bulk_kernels(kernels)) {
+            state.SkipWithError("kernels not supported");
+            return;
+        }
+        run_bulk(state, [](uint8_t* first, uint8_t* second, size_t size) { copy_bytes(first, second, size); });
+        select_bulk_kernels("auto");
+    }
+
+    void BM_CompareBytes(benchmark::State& state, const char* kernels) {
+        if (!select_bulk_kernels(kernels)) {
+            state.SkipWithError("kernels not supported");
+            return;
+        }
+        run_bulk(state, [](uint8_t* first, uint8_t* second, size_t size) {
+            benchmark::DoNotOptimize(compare_bytes(first, second, size));
+        });
+        select_bulk_kernels("auto");
+    }
+
+    void BM_Crc32c(benchmark::State& state, const char* kernels) {
+        if (!select_bulk_kernels(kernels)) {
+            state.SkipWithError("kernels not supported");
+            return;
+        }
+        run_bulk(state, [](uint8_t* first, uint8_t*, size_t size) { benchmark::DoNotOptimize(crc32c(first, size)); });
+        select_bulk_kernels("auto");
+    }
+
+    void BM_Xxh3(benchmark::State& state, const char* kernels) {
+        if (!select_bulk_kernels(kernels)) {
+            state.SkipWithError("kernels not supported");
+            return;
+        }
+        run_bulk(state, [](uint8_t* first, uint8_t*, size_t size) { benchmark::DoNotOptimize(xxh3_64(first, size)); });
+        select_bulk_kernels("auto");
+    }
+
+#define BULK_BENCHMARK(name) \
+    BENCHMARK_CAPTURE(name, scalar, "scalar")->RangeMultiplier(64)->Range(64 << 10, 256 << 20); \
+    BENCHMARK_CAPTURE(name, sse42, "sse4.2")->RangeMultiplier(64)->Range(64 << 10, 256 << 20); \
+    BENCHMARK_CAPTURE(name, avx2, "avx2")->RangeMultiplier(64)->Range(64 << 10, 256 << 20)
+
+    BULK_BENCHMARK(BM_CopyBytes);
+    BULK_BENCHMARK(BM_CompareBytes);
+    BULK_BENCHMARK(BM_Crc32c);
+    BULK_BENCHMARK(BM_Xxh3);
+
+#ifndef _WIN32
+    // 跨进程往返：令牌依次经过每个子进程再回到本进程，每次迭代为一整圈
+    void BM_PingPong(benchmark::State& state) {
+        std::string key = bench_key("pingpong");
+        int processes = static_cast<int>(state.range(0));
+        // 令牌和停止标志各占一个缓存行
+        auto manager = create_manager(key, 2 * CACHE_LINE_SIZE);
+        auto* token = reinterpret_cast<std::atomic<uint32_t>*>(manager->get_data());
+        auto* stop = reinterpret_cast<std::atomic<uint32_t>*>(manager->get_data() + CACHE_LINE_SIZE);
+        token->store(0);
+        stop->store(0);
+
+        std::vector<pid_t> children;
+        for (int i = 1; i <= processes; i++) {
+            pid_t pid = fork();
+            if (pid == 0) {
+                // 子进程 i 等待令牌为 i，传给下一个（最后一个传回 0）
+                uint32_t mine = static_cast<uint32_t>(i);
+                uint32_t next = i == processes ? 0 : mine + 1;
+                for (;;) {
+                    uint32_t value = token->load(std::memory_order_acquire);
+                    if (stop->load(std::memory_order_acquire)) {
+                        _exit(0);
+                    }
+                    if (value != mine) {
+                        futex_wait(token, value, 100);
+                        continue;
+                    }
+                    token->store(next, std::memory_order_release);
+                    futex_wake(token, INT32_MAX);
+                }
+            }
+            children.push_back(pid);
+        }
+
+        for (auto _ : state) {
+            token->store(1, std::memory_order_release);
+            futex_wake(token, INT32_MAX);
+            uint32_t value;
+            while ((value = token->load(std::memory_order_acquire)) != 0) {
+                futex_wait(token, value, 100);
+            }
+        }
+
+        stop->store(1, std::memory_order_release);
+        futex_wake(token, INT32_MAX);
+        for (pid_t pid : children) {
+            waitpid(pid, nullptr, 0);
+        }
+        manager.reset();
+        evict_manager(key);
+        unlink_segment(key);
+    }
+    BENCHMARK(BM_PingPong)->RangeMultiplier(2)->Range(1, 16)->UseRealTime()->Unit(benchmark::kMicrosecond);
+#endif
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,252 @@
+#include "shared_memory.hh"
+#include "bulk.hh"
+#include "logging.hh"
+#include <cstring>
+
+// 只使用头文件中的内联实现，各指令集文件各自编译一份
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
+namespace SharedMemory {
+    // CRC32C（Castagnoli）多项式，按位反转
+    static const uint32_t CRC32C_POLY = 0x82f63b78;
+
+    // 按 8 字节切分的查表法，以及追加 CRC32C_BLOCK 个零字节的移位表
+    struct Crc32cTables {
+        uint32_t bytes[8][256];
+        uint32_t shift[4][256];
+
+        Crc32cTables() {
+            for (uint32_t n = 0; n < 256; n++) {
+                uint32_t crc = n;
+                for (int bit = 0; bit < 8; bit++) {
+                    crc = crc & 1 ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+                }
+                bytes[0][n] = crc;
+            }
+            for (uint32_t n = 0; n < 256; n++) {
+                for (int k = 1; k < 8; k++) {
+                    bytes[k][n] = (bytes[k - 1][n] >> 8) ^ bytes[0][bytes[k - 1][n] & 0xff];
+                }
+            }
+
+            // 零字节的追加对寄存器是线性变换，逐位求出每一位的像再按字节组合
+            uint32_t image[32];
+            for (int bit = 0; bit < 32; bit++) {
+                uint32_t crc = 1u << bit;
+                for (size_t i = 0; i < CRC32C_BLOCK; i++) {
+                    crc = bytes[0][crc & 0xff] ^ (crc >> 8);
+                }
+                image[bit] = crc;
+            }
+            for (int k = 0; k < 4; k++) {
+                for (uint32_t n = 0; n < 256; n++) {
+                    uint32_t crc = 0;
+                    for (int bit = 0; bit < 8; bit++) {
+                        if (n & (1u << bit)) {
+                            crc ^= image[k * 8 + bit];
+                        }
+                    }
+                    shift[k][n] = crc;
+                }
+            }
+        }
+    };
+
+    static const Crc32cTables& crc32c_tables() {
+        static const Crc32cTables tables;
+        return tables;
+    }
+
+    uint32_t crc32c_shift(uint32_t crc) {
+        const Crc32cTables& tables = crc32c_tables();
+        return tables.shift[0][crc & 0xff] ^ tables.shift[1][(crc >> 8) & 0xff] ^
+               tables.shift[2][(crc >> 16) & 0xff] ^ tables.shift[3][crc >> 24];
+    }
+
+    uint32_t crc32c_generic(uint32_t crc, const uint8_t* data, size_t length) {
+        const Crc32cTables& tables = crc32c_tables();
+        const uint32_t (*t)[256] = tables.bytes;
+        // 按小端读取 8 字节
+        while (length >= 8) {
+            uint64_t word;
+            memcpy(&word, data, 8);
+            word ^= crc;
+            crc = t[7][word & 0xff] ^ t[6][(word >> 8) & 0xff] ^ t[5][(word >> 16) & 0xff] ^ t[4][(word >> 24) & 0xff] ^
+                  t[3][(word >> 32) & 0xff] ^ t[2][(word >> 40) & 0xff] ^ t[1][(word >> 48) & 0xff] ^ t[0][word >> 56];
+            data += 8;
+            length -= 8;
+        }
+        while (length--) {
+            crc = t[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+        }
+        return crc;
+    }
+
+    size_t compare_generic(const uint8_t* a, const uint8_t* b, size_t length) {
+        size_t i = 0;
+        for (; i + 8 <= length; i += 8) {
+            uint64_t x, y;
+            memcpy(&x, a + i, 8);
+            memcpy(&y, b + i, 8);
+            if (x != y) {
+                return i + lowest_bit(x ^ y) / 8;
+            }
+        }
+        for (; i < length; i++) {
+            if (a[i] != b[i]) {
+                return i;
+            }
+        }
+        return length;
+    }
+
+    size_t find_generic(const uint8_t* data, size_t length, uint8_t value) {
+        const void* found = memchr(data, value, length);
+        return found ? static_cast<size_t>(static_cast<const uint8_t*>(found) - data) : length;
+    }
+
+    uint64_t xxh3_generic(const void* data, size_t length, uint64_t seed) {
+        return XXH3_64bits_withSeed(data, length, seed);
+    }
+
+    // 标量实现的大块复制和填充交给 C 库，C 库自身也会在足够大时使用非临时存储
+    static void copy_generic(void* dst, const void* src, size_t length) {
+        memcpy(dst, src, length);
+    }
+
+    static void fill_generic(void* dst, uint8_t value, size_t length) {
+        memset(dst, value, length);
+    }
+
+    const BulkKernels scalar_kernels = {
+        "scalar", copy_generic, fill_generic, compare_generic, find_generic, crc32c_generic, xxh3_generic
+    };
+
+    // 按 CPU 支持的指令集选择实现，AVX 还需要操作系统保存 YMM 寄存器
+    static bool cpu_supports(const BulkKernels* kernels) {
+        if (kernels == &scalar_kernels) {
+            return true;
+        }
+#ifdef SHARED_MEMORY_X86_KERNELS
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        bool sse42 = (info[2] & (1 << 20)) != 0;
+        bool avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        bool avx2 = avx && (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        bool sse42 = __builtin_cpu_supports("sse4.2");
+        bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+        if (kernels == &sse42_kernels) {
+            return sse42;
+        }
+        if (kernels == &avx2_kernels) {
+            return avx2 && sse42;
+        }
+#endif
+        return false;
+    }
+
+    // 按优先级排列
+    static const BulkKernels* const all_kernels[] = {
+#ifdef SHARED_MEMORY_X86_KERNELS
+        &avx2_kernels,
+        &sse42_kernels,
+#endif
+        &scalar_kernels
+    };
+
+    static const BulkKernels* detect_kernels() {
+        for (const BulkKernels* kernels : all_kernels) {
+            if (cpu_supports(kernels)) {
+                LOG_DEBUG("Bulk kernels: %s", kernels->name);
+                return kernels;
+            }
+        }
+        return &scalar_kernels;
+    }
+
+    // 检测只执行一次；select_bulk_kernels 选择的实现优先
+    static std::atomic<const BulkKernels*> selected_kernels{nullptr};
+
+    static const BulkKernels& kernels() {
+        const BulkKernels* selected = selected_kernels.load(std::memory_order_relaxed);
+        if (selected) {
+            return *selected;
+        }
+        static const BulkKernels* detected = detect_kernels();
+        return *detected;
+    }
+
+    const char* bulk_kernels() {
+        return kernels().name;
+    }
+
+    bool select_bulk_kernels(const std::string& name) {
+        if (name.empty() || name == "auto") {
+            selected_kernels.store(nullptr, std::memory_order_relaxed);
+            return true;
+        }
+        for (const BulkKernels* candidate : all_kernels) {
+            if (name == candidate->name && cpu_supports(candidate)) {
+                selected_kernels.store(candidate, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void copy_bytes(void* dst, const void* src, size_t length) {
+        // 重叠或较小的复制交给 memmove，结果仍留在缓存中供随后读取
+        uintptr_t target = reinterpret_cast<uintptr_t>(dst);
+        uintptr_t source = reinterpret_cast<uintptr_t>(src);
+        if (length < NON_TEMPORAL_THRESHOLD || (target < source + length && source < target + length)) {
+            memmove(dst, src, length);
+            return;
+        }
+        kernels().copy(dst, src, length);
+    }
+
+    void fill_bytes(void* dst, uint8_t value, size_t length) {
+        if (length < NON_TEMPORAL_THRESHOLD) {
+            memset(dst, value, length);
+            return;
+        }
+        kernels().fill(dst, value, length);
+    }
+
+    size_t compare_bytes(const void* a, const void* b, size_t length) {
+        return kernels().compare(static_cast<const uint8_t*>(a), static_cast<const uint8_t*>(b), length);
+    }
+
+    size_t find_byte(const void* data, size_t length, uint8_t value) {
+        return kernels().find(static_cast<const uint8_t*>(data), length, value);
+    }
+
+    uint32_t crc32c(const void* data, size_t length, uint32_t crc) {
+        return ~kernels().crc32c(~crc, static_cast<const uint8_t*>(data), length);
+    }
+
+    uint64_t xxh3_64(const void* data, size_t length, uint64_t seed) {
+        return kernels().xxh3(data, length, seed);
+    }
+
+    const char* checksum_name(ChecksumAlgorithm algorithm) {
+        return algorithm == ChecksumAlgorithm::Xxh3 ? "xxh3" : "crc32c";
+    }
+
+    bool parse_checksum(const std::string& name, ChecksumAlgorithm& algorithm) {
+        if (name == "crc32c") {
+            algorithm = ChecksumAlgorithm::Crc32c;
+        } else if (name == "xxh3") {
+            algorithm = ChecksumAlgorithm::Xxh3;
+        } else {
+            return false;
+        }
+        return true;
+    }
+}
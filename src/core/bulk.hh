@@ -0,0 +1,72 @@
+#pragma once
+
+#ifndef BULK_HH
+#define BULK_HH
+// 批量操作内核的内部接口。各指令集的实现分别以 -msse4.2 / -mavx2 编译，
+// 这些文件中只能使用 C 头文件和内部链接的函数，避免带指令集的内联函数被链接器合并到通用代码中
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace SharedMemory {
+    // 不小于此长度且源和目标不重叠的复制、填充使用非临时存储，绕过缓存直接写回内存
+    const size_t NON_TEMPORAL_THRESHOLD = 4 * 1024 * 1024;
+
+    // CRC32C 三路交错计算时每路的长度，合并时一次追加这么多零字节
+    const size_t CRC32C_BLOCK = 8192;
+
+    // 一组批量操作的实现
+    struct BulkKernels {
+        const char* name;
+        // 非临时复制，调用方保证不重叠且不小于 NON_TEMPORAL_THRESHOLD
+        void (*copy)(void* dst, const void* src, size_t length);
+        // 非临时填充，调用方保证不小于 NON_TEMPORAL_THRESHOLD
+        void (*fill)(void* dst, uint8_t value, size_t length);
+        // 第一个不同字节的下标，相同时返回 length
+        size_t (*compare)(const uint8_t* a, const uint8_t* b, size_t length);
+        // 第一个等于 value 的字节的下标，没有时返回 length
+        size_t (*find)(const uint8_t* data, size_t length, uint8_t value);
+        // 未取反的 CRC32C 寄存器值
+        uint32_t (*crc32c)(uint32_t crc, const uint8_t* data, size_t length);
+        uint64_t (*xxh3)(const void* data, size_t length, uint64_t seed);
+    };
+
+    // 标量实现，任何平台都可用
+    extern const BulkKernels scalar_kernels;
+
+#ifdef SHARED_MEMORY_X86_KERNELS
+    // SSE4.2：crc32 指令，比较和非临时存储使用 SSE2
+    extern const BulkKernels sse42_kernels;
+
+    // AVX2：32 字节的比较、查找和非临时存储，CRC32C 沿用 SSE4.2
+    extern const BulkKernels avx2_kernels;
+
+    // crc32 指令实现，两组内核共用
+    uint32_t crc32c_sse42(uint32_t crc, const uint8_t* data, size_t length);
+#endif
+
+    // 标量实现，各指令集处理剩余的尾部时调用
+    size_t compare_generic(const uint8_t* a, const uint8_t* b, size_t length);
+    size_t find_generic(const uint8_t* data, size_t length, uint8_t value);
+    uint32_t crc32c_generic(uint32_t crc, const uint8_t* data, size_t length);
+    uint64_t xxh3_generic(const void* data, size_t length, uint64_t seed);
+
+    // CRC32C 寄存器值追加 CRC32C_BLOCK 个零字节
+    uint32_t crc32c_shift(uint32_t crc);
+
+    // 最低的置位位置，value 不能为 0
+    static inline unsigned lowest_bit(uint64_t value) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctzll(value));
+#endif
+    }
+}
+
+#endif
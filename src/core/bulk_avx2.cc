@@ -0,0 +1,92 @@
+// AVX2 批量操作内核，以 -mavx2 编译，只在 CPU 支持时经 bulk.cc 调用
+#include "bulk.hh"
+
+#ifdef SHARED_MEMORY_X86_KERNELS
+#include <string.h>
+#include <immintrin.h>
+
+// 以 AVX2 编译的 XXH3，内部函数均为静态，不与 bulk.cc 中的通用版本冲突
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
+namespace SharedMemory {
+    static size_t compare_avx2(const uint8_t* a, const uint8_t* b, size_t length) {
+        size_t i = 0;
+        for (; i + 64 <= length; i += 64) {
+            __m256i x0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            __m256i y0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            __m256i x1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i + 32));
+            __m256i y1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i + 32));
+            uint64_t equal = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x0, y0))) |
+                             static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x1, y1)))) << 32;
+            if (~equal) {
+                return i + lowest_bit(~equal);
+            }
+        }
+        return i + compare_generic(a + i, b + i, length - i);
+    }
+
+    static size_t find_avx2(const uint8_t* data, size_t length, uint8_t value) {
+        __m256i needle = _mm256_set1_epi8(static_cast<char>(value));
+        size_t i = 0;
+        for (; i + 64 <= length; i += 64) {
+            __m256i x0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            __m256i x1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 32));
+            uint64_t found = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x0, needle))) |
+                             static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x1, needle)))) << 32;
+            if (found) {
+                return i + lowest_bit(found);
+            }
+        }
+        return i + find_generic(data + i, length - i, value);
+    }
+
+    // 目标按 32 字节对齐后以 _mm256_stream_si256 写入，每次 128 字节
+    static void copy_avx2(void* dst, const void* src, size_t length) {
+        uint8_t* target = static_cast<uint8_t*>(dst);
+        const uint8_t* source = static_cast<const uint8_t*>(src);
+        size_t head = (32 - (reinterpret_cast<uintptr_t>(target) & 31)) & 31;
+        memcpy(target, source, head);
+        target += head;
+        source += head;
+        length -= head;
+        for (; length >= 128; length -= 128, target += 128, source += 128) {
+            __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source));
+            __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + 32));
+            __m256i v2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + 64));
+            __m256i v3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + 96));
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(target), v0);
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(target + 32), v1);
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(target + 64), v2);
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(target + 96), v3);
+        }
+        _mm_sfence();
+        memcpy(target, source, length);
+    }
+
+    static void fill_avx2(void* dst, uint8_t value, size_t length) {
+        uint8_t* target = static_cast<uint8_t*>(dst);
+        size_t head = (32 - (reinterpret_cast<uintptr_t>(target) & 31)) & 31;
+        memset(target, value, head);
+        target += head;
+        length -= head;
+        __m256i v = _mm256_set1_epi8(static_cast<char>(value));
+        for (; length >= 128; length -= 128, target += 128) {
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(target), v);
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(target + 32), v);
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(target + 64), v);
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(target + 96), v);
+        }
+        _mm_sfence();
+        memset(target, value, length);
+    }
+
+    static uint64_t xxh3_avx2(const void* data, size_t length, uint64_t seed) {
+        return XXH3_64bits_withSeed(data, length, seed);
+    }
+
+    const BulkKernels avx2_kernels = {
+        "avx2", copy_avx2, fill_avx2, compare_avx2, find_avx2, crc32c_sse42, xxh3_avx2
+    };
+}
+#endif
@@ -0,0 +1,107 @@
+// SSE4.2 批量操作内核，以 -msse4.2 编译，只在 CPU 支持时经 bulk.cc 调用
+#include "bulk.hh"
+
+#ifdef SHARED_MEMORY_X86_KERNELS
+#include <string.h>
+#include <nmmintrin.h>
+
+namespace SharedMemory {
+    // crc32 指令延迟 3 个周期、每周期可发射一条，三路独立的依赖链交错计算，最后按长度移位合并
+    uint32_t crc32c_sse42(uint32_t crc, const uint8_t* data, size_t length) {
+        while (length && (reinterpret_cast<uintptr_t>(data) & 7)) {
+            crc = _mm_crc32_u8(crc, *data++);
+            length--;
+        }
+        while (length >= 3 * CRC32C_BLOCK) {
+            uint64_t crc0 = crc, crc1 = 0, crc2 = 0;
+            const uint8_t* end = data + CRC32C_BLOCK;
+            do {
+                uint64_t word0, word1, word2;
+                memcpy(&word0, data, 8);
+                memcpy(&word1, data + CRC32C_BLOCK, 8);
+                memcpy(&word2, data + 2 * CRC32C_BLOCK, 8);
+                crc0 = _mm_crc32_u64(crc0, word0);
+                crc1 = _mm_crc32_u64(crc1, word1);
+                crc2 = _mm_crc32_u64(crc2, word2);
+                data += 8;
+            } while (data < end);
+            crc = crc32c_shift(crc32c_shift(static_cast<uint32_t>(crc0)) ^ static_cast<uint32_t>(crc1)) ^
+                  static_cast<uint32_t>(crc2);
+            data += 2 * CRC32C_BLOCK;
+            length -= 3 * CRC32C_BLOCK;
+        }
+        uint64_t crc64 = crc;
+        while (length >= 8) {
+            uint64_t word;
+            memcpy(&word, data, 8);
+            crc64 = _mm_crc32_u64(crc64, word);
+            data += 8;
+            length -= 8;
+        }
+        crc = static_cast<uint32_t>(crc64);
+        while (length--) {
+            crc = _mm_crc32_u8(crc, *data++);
+        }
+        return crc;
+    }
+
+    static size_t compare_sse2(const uint8_t* a, const uint8_t* b, size_t length) {
+        size_t i = 0;
+        for (; i + 16 <= length; i += 16) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            uint32_t diff = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y))) ^ 0xffff;
+            if (diff) {
+                return i + lowest_bit(diff);
+            }
+        }
+        return i + compare_generic(a + i, b + i, length - i);
+    }
+
+    // 目标按 16 字节对齐后以 _mm_stream_si128 写入，源可不对齐
+    static void copy_sse2(void* dst, const void* src, size_t length) {
+        uint8_t* target = static_cast<uint8_t*>(dst);
+        const uint8_t* source = static_cast<const uint8_t*>(src);
+        size_t head = (16 - (reinterpret_cast<uintptr_t>(target) & 15)) & 15;
+        memcpy(target, source, head);
+        target += head;
+        source += head;
+        length -= head;
+        for (; length >= 64; length -= 64, target += 64, source += 64) {
+            __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+            __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 16));
+            __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 32));
+            __m128i v3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 48));
+            _mm_stream_si128(reinterpret_cast<__m128i*>(target), v0);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(target + 16), v1);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(target + 32), v2);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(target + 48), v3);
+        }
+        // 非临时存储是弱序的，返回前排空，之后的普通写入和其他进程看到的顺序与程序顺序一致
+        _mm_sfence();
+        memcpy(target, source, length);
+    }
+
+    static void fill_sse2(void* dst, uint8_t value, size_t length) {
+        uint8_t* target = static_cast<uint8_t*>(dst);
+        size_t head = (16 - (reinterpret_cast<uintptr_t>(target) & 15)) & 15;
+        memset(target, value, head);
+        target += head;
+        length -= head;
+        __m128i v = _mm_set1_epi8(static_cast<char>(value));
+        for (; length >= 64; length -= 64, target += 64) {
+            _mm_stream_si128(reinterpret_cast<__m128i*>(target), v);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(target + 16), v);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(target + 32), v);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(target + 48), v);
+        }
+        _mm_sfence();
+        memset(target, value, length);
+    }
+
+    // 查找交给 C 库的 memchr，它本身已按 CPU 选择向量实现
+    const BulkKernels sse42_kernels = {
+        "sse4.2", copy_sse2, fill_sse2, compare_sse2, find_generic, crc32c_sse42, xxh3_generic
+    };
+}
+#endif
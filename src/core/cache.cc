@@ -0,0 +1,177 @@
+#include "shared_memory.hh"
+#include <atomic>
+#include <map>
+#include <mutex>
+
+namespace SharedMemory {
+    typedef std::map<std::string, std::weak_ptr<SharedMemoryManager>> ManagerCache;
+
+    // 进程内映射缓存：只保存弱引用，映射的生命周期由引用它的 ArrayBuffer 决定；只读映射单独保存
+    static std::mutex cache_mutex;
+    static ManagerCache manager_cache;
+    static ManagerCache read_only_cache;
+    static std::atomic<uint64_t> cache_hits{0};
+    static std::atomic<uint64_t> cache_misses{0};
+
+    // 已固定、等待其他环境取出的映射
+    static std::map<uint32_t, std::shared_ptr<SharedMemoryManager>> pinned_managers;
+    static uint32_t next_pin = 1;
+
+    // 清理已失效的缓存项，调用方需持有 cache_mutex
+    static void sweep_expired(ManagerCache& cache) {
+        for (auto it = cache.begin(); it != cache.end();) {
+            if (it->second.expired()) {
+                it = cache.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    // memfd 没有名称，只读和私有映射从缓存中的映射复制描述符打开
+    static std::shared_ptr<SharedMemoryManager> open_manager(const std::string& key, int timeout_ms, const MapOptions& options) {
+        if (options.mode != MapMode::ReadWrite) {
+            std::shared_ptr<SharedMemoryManager> source;
+            {
+                std::lock_guard<std::mutex> lock(cache_mutex);
+                auto it = manager_cache.find(key);
+                if (it != manager_cache.end()) {
+                    source = it->second.lock();
+                }
+            }
+            if (source && source->get_backend() == Backend::Memfd) {
+                return std::make_shared<SharedMemoryManager>(source->export_fd(), key, false, 0, timeout_ms, options);
+            }
+        }
+        return std::make_shared<SharedMemoryManager>(key, false, 0, timeout_ms, options);
+    }
+
+    std::shared_ptr<SharedMemoryManager> acquire_manager(const std::string& key, int timeout_ms, const MapOptions& options) {
+        // 私有映射各自独立，每次都建立新的写时复制映射
+        if (options.mode == MapMode::Private) {
+            cache_misses.fetch_add(1, std::memory_order_relaxed);
+            return open_manager(key, timeout_ms, options);
+        }
+        ManagerCache& cache = options.mode == MapMode::ReadOnly ? read_only_cache : manager_cache;
+
+        std::shared_ptr<SharedMemoryManager> cached;
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            auto it = cache.find(key);
+            if (it != cache.end()) {
+                cached = it->second.lock();
+            }
+        }
+        if (cached) {
+            cache_hits.fetch_add(1, std::memory_order_relaxed);
+            // 预取和锁定可能耗时较长，不在持锁期间执行
+            cached->apply_options(options);
+            return cached;
+        }
+
+        cache_misses.fetch_add(1, std::memory_order_relaxed);
+
+        // 打开共享内存涉及信号量和系统调用，不在持锁期间执行
+        auto manager = open_manager(key, timeout_ms, options);
+
+        std::shared_ptr<SharedMemoryManager> existing;
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            auto& slot = cache[key];
+            existing = slot.lock();
+            if (!existing) {
+                slot = manager;
+                sweep_expired(cache);
+                return manager;
+            }
+        }
+        // 其他调用已抢先完成映射，复用已有映射
+        existing->apply_options(options);
+        return existing;
+    }
+
+    std::shared_ptr<SharedMemoryManager> create_manager(const std::string& key, size_t size, int timeout_ms,
+                                                        const MapOptions& options, Backend backend) {
+        auto manager = backend == Backend::Memfd ? create_memfd(key, size, timeout_ms, options) :
+                       std::make_shared<SharedMemoryManager>(key, true, size, timeout_ms, options);
+        cache_manager(key, manager);
+        return manager;
+    }
+
+    void cache_manager(const std::string& key, const std::shared_ptr<SharedMemoryManager>& manager) {
+        // 新建的映射替换缓存项，旧映射在其 ArrayBuffer 被回收后释放
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        manager_cache[key] = manager;
+        sweep_expired(manager_cache);
+    }
+
+    bool cache_new_manager(const std::string& key, const std::shared_ptr<SharedMemoryManager>& manager) {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto& slot = manager_cache[key];
+        if (!slot.expired()) {
+            return false;
+        }
+        slot = manager;
+        sweep_expired(manager_cache);
+        return true;
+    }
+
+    bool manager_cached(const std::string& key) {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = manager_cache.find(key);
+        return it != manager_cache.end() && !it->second.expired();
+    }
+
+    void evict_manager(const std::string& key) {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        manager_cache.erase(key);
+        read_only_cache.erase(key);
+    }
+
+    CacheStats get_cache_stats() {
+        CacheStats stats;
+        stats.hits = cache_hits.load(std::memory_order_relaxed);
+        stats.misses = cache_misses.load(std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        stats.entries = 0;
+        for (const auto& item : manager_cache) {
+            if (!item.second.expired()) {
+                stats.entries++;
+            }
+        }
+        return stats;
+    }
+
+    std::vector<std::pair<std::string, std::shared_ptr<SharedMemoryManager>>> cached_managers() {
+        std::vector<std::pair<std::string, std::shared_ptr<SharedMemoryManager>>> managers;
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        for (const auto& item : manager_cache) {
+            if (auto manager = item.second.lock()) {
+                managers.emplace_back(item.first, std::move(manager));
+            }
+        }
+        return managers;
+    }
+
+    uint32_t pin_manager(std::shared_ptr<SharedMemoryManager> manager) {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        uint32_t handle = next_pin++;
+        if (next_pin == 0) {
+            next_pin = 1;
+        }
+        pinned_managers[handle] = std::move(manager);
+        return handle;
+    }
+
+    std::shared_ptr<SharedMemoryManager> take_pinned(uint32_t handle) {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = pinned_managers.find(handle);
+        if (it == pinned_managers.end()) {
+            return nullptr;
+        }
+        auto manager = std::move(it->second);
+        pinned_managers.erase(it);
+        return manager;
+    }
+}
@@ -0,0 +1,237 @@
+#include "shared_memory.hh"
+#include "logging.hh"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace SharedMemory {
+    static_assert(sizeof(DirtyTracker) == CACHE_LINE_SIZE, "dirty tracker control block is one cache line");
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "epochs are stored as plain 32-bit words");
+
+    static size_t align_line(size_t value) {
+        return (value + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1);
+    }
+
+    static size_t group_count(uint64_t blocks) {
+        return static_cast<size_t>((blocks + DIRTY_GROUP_BLOCKS - 1) / DIRTY_GROUP_BLOCKS);
+    }
+
+    // 控制块之后的组纪元与块纪元两个数组
+    static size_t tracker_layout_bytes(uint64_t blocks) {
+        return sizeof(DirtyTracker) + align_line(group_count(blocks) * sizeof(uint32_t)) +
+               static_cast<size_t>(blocks) * sizeof(uint32_t);
+    }
+
+    static std::atomic<uint32_t>* group_epochs(DirtyTracker* tracker) {
+        return reinterpret_cast<std::atomic<uint32_t>*>(reinterpret_cast<uint8_t*>(tracker) + sizeof(DirtyTracker));
+    }
+
+    static std::atomic<uint32_t>* block_epochs(DirtyTracker* tracker) {
+        return group_epochs(tracker) + align_line(group_count(tracker->blocks) * sizeof(uint32_t)) / sizeof(uint32_t);
+    }
+
+    // 纪元是 32 位计数，回绕时跳过 0（0 表示从未标记），按差值比较：a 比 b 新当且仅当 a - b 解释为有符号数大于 0。
+    // 超过 2^31 次收集没有再标记的块会被当作新标记，只会多返回区间，不会漏掉变更
+    static bool epoch_after(uint32_t a, uint32_t b) {
+        return static_cast<int32_t>(a - b) > 0;
+    }
+
+    // 纪元只前进不后退，已不早于 epoch 时不写入，反复标记同一块不会让缓存行在进程间来回迁移
+    static void raise_epoch(std::atomic<uint32_t>& slot, uint32_t epoch) {
+        uint32_t current = slot.load(std::memory_order_relaxed);
+        while ((current == 0 || epoch_after(epoch, current)) &&
+               !slot.compare_exchange_weak(current, epoch, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        }
+    }
+
+    bool valid_dirty_block(size_t block_size) {
+        return block_size >= DIRTY_BLOCK_MIN && block_size <= DIRTY_BLOCK_MAX && (block_size & (block_size - 1)) == 0;
+    }
+
+    size_t dirty_tracker_bytes(size_t size, size_t block_size) {
+        return tracker_layout_bytes((size + block_size - 1) / block_size);
+    }
+
+    DirtyTracker* SharedMemoryManager::dirty_tracker() const {
+        if (!address_ || legacy_ || mode_ != MapMode::ReadWrite || data_offset_ < sizeof(SharedMemoryHeader) + sizeof(DirtyTracker)) {
+            return nullptr;
+        }
+        SharedMemoryHeader* header = static_cast<SharedMemoryHeader*>(address_);
+        if (!(header->flags & HEADER_FLAG_DIRTY_TRACKING)) {
+            return nullptr;
+        }
+        // 跟踪区由其他进程写入，块数超出数据区偏移时视为损坏，不访问
+        DirtyTracker* tracker = reinterpret_cast<DirtyTracker*>(header + 1);
+        size_t block_size = size_t(1) << std::min<uint32_t>(tracker->block_shift, 63);
+        if (!valid_dirty_block(block_size) ||
+            tracker->blocks > (data_offset_ - sizeof(SharedMemoryHeader)) / sizeof(uint32_t) ||
+            sizeof(SharedMemoryHeader) + tracker_layout_bytes(tracker->blocks) > data_offset_) {
+            return nullptr;
+        }
+        return tracker;
+    }
+
+    size_t SharedMemoryManager::get_dirty_block_size() const {
+        DirtyTracker* tracker = dirty_tracker();
+        return tracker ? size_t(1) << tracker->block_shift : 0;
+    }
+
+    bool SharedMemoryManager::mark_dirty(size_t offset, size_t length) {
+        MappingLock mapping = lock_mapping();
+        DirtyTracker* tracker = dirty_tracker();
+        if (!tracker) {
+            return false;
+        }
+        if (length == 0) {
+            return true;
+        }
+        uint64_t first = offset >> tracker->block_shift;
+        uint64_t last = (static_cast<uint64_t>(offset) + length - 1) >> tracker->block_shift;
+        std::atomic<uint32_t>* groups = group_epochs(tracker);
+        std::atomic<uint32_t>* blocks = block_epochs(tracker);
+
+        // 先写块纪元再写组纪元，收集者看到组纪元时块纪元已可见。
+        // 收集者在两次读取纪元之间推进过纪元时，标记可能落在它已扫描过的位置，以新纪元重新标记留给下一次收集
+        uint32_t epoch = tracker->epoch.load(std::memory_order_seq_cst);
+        for (;;) {
+            uint64_t end = std::min(last + 1, tracker->blocks);
+            for (uint64_t block = first; block < end; block++) {
+                raise_epoch(blocks[block], epoch);
+            }
+            if (first < end) {
+                for (uint64_t group = first / DIRTY_GROUP_BLOCKS; group <= (end - 1) / DIRTY_GROUP_BLOCKS; group++) {
+                    raise_epoch(groups[group], epoch);
+                }
+            }
+            // 扩展后超出跟踪范围的部分只记录一个纪元，收集时整段返回
+            if (last >= tracker->blocks) {
+                raise_epoch(tracker->tail_epoch, epoch);
+            }
+            uint32_t current = tracker->epoch.load(std::memory_order_seq_cst);
+            if (current == epoch) {
+                return true;
+            }
+            epoch = current;
+        }
+    }
+
+    uint32_t SharedMemoryManager::collect_dirty(uint32_t since, std::vector<DirtyRange>& ranges) {
+        ranges.clear();
+        MappingLock mapping = lock_mapping();
+        DirtyTracker* tracker = dirty_tracker();
+        if (!tracker) {
+            throw std::runtime_error("Shared memory is not tracking dirty blocks");
+        }
+        // 推进纪元，之后的标记属于下一次收集；返回推进前的纪元，纪元不晚于它的标记都已在本次或之前收集
+        uint32_t epoch = tracker->epoch.load(std::memory_order_seq_cst);
+        while (!tracker->epoch.compare_exchange_weak(epoch, epoch + 1 == 0 ? 1 : epoch + 1, std::memory_order_seq_cst)) {
+        }
+        uint32_t shift = tracker->block_shift;
+        std::atomic<uint32_t>* groups = group_epochs(tracker);
+        std::atomic<uint32_t>* blocks = block_epochs(tracker);
+
+        // since 为 0 表示收集所有标记过的块，回绕后的纪元也算在内
+        auto changed = [since](uint32_t marked) {
+            return marked != 0 && (since == 0 || epoch_after(marked, since));
+        };
+
+        auto append = [&](uint64_t offset, uint64_t end) {
+            end = std::min<uint64_t>(end, size_);
+            if (offset >= end) {
+                return;
+            }
+            if (!ranges.empty() && ranges.back().offset + ranges.back().length == offset) {
+                ranges.back().length += end - offset;
+            }
+            else {
+                ranges.push_back({offset, end - offset});
+            }
+        };
+
+        // 只扫描组纪元晚于 since 的组，代价与变更的组数成正比
+        size_t group_total = group_count(tracker->blocks);
+        for (size_t group = 0; group < group_total; group++) {
+            if (!changed(groups[group].load(std::memory_order_acquire))) {
+                continue;
+            }
+            uint64_t begin = static_cast<uint64_t>(group) * DIRTY_GROUP_BLOCKS;
+            uint64_t end = std::min<uint64_t>(begin + DIRTY_GROUP_BLOCKS, tracker->blocks);
+            for (uint64_t block = begin; block < end; block++) {
+                if (changed(blocks[block].load(std::memory_order_acquire))) {
+                    append(block << shift, (block + 1) << shift);
+                }
+            }
+        }
+        if (changed(tracker->tail_epoch.load(std::memory_order_acquire))) {
+            append(tracker->blocks << shift, size_);
+        }
+        LOG_DEBUG("Collected dirty ranges: key=%s, since=%u, epoch=%u, ranges=%zu", key_.c_str(), since, epoch,
+            ranges.size());
+        return epoch;
+    }
+
+    // 目标不小于 end，较小时扩展；扩展要获取头部互斥锁，在取映射锁之前完成
+    static void reserve_target(const std::shared_ptr<SharedMemoryManager>& target, uint64_t end) {
+        if (target->is_read_only()) {
+            throw std::runtime_error("Shared memory is mapped read-only");
+        }
+        size_t size;
+        {
+            MappingLock mapping = target->lock_mapping();
+            size = target->get_size();
+        }
+        if (end > size) {
+            target->resize(static_cast<size_t>(end));
+        }
+    }
+
+    uint64_t apply_delta(const std::shared_ptr<SharedMemoryManager>& target,
+                         const std::shared_ptr<SharedMemoryManager>& source, const std::vector<DirtyRange>& ranges) {
+        uint64_t end = 0;
+        {
+            MappingLock mapping = source->lock_mapping();
+            for (const DirtyRange& range : ranges) {
+                if (range.offset > source->get_size() || range.length > source->get_size() - range.offset) {
+                    throw std::out_of_range("Dirty range exceeds the source shared memory");
+                }
+                end = std::max(end, range.offset + range.length);
+            }
+        }
+        reserve_target(target, end);
+
+        // 共享内存只扩展不缩小，加锁后区间仍在两边的范围内
+        MappingLock target_lock(target->mapping_mutex(), std::defer_lock);
+        MappingLock source_lock(source->mapping_mutex(), std::defer_lock);
+        std::lock(target_lock, source_lock);
+        uint64_t applied = 0;
+        for (const DirtyRange& range : ranges) {
+            copy_bytes(target->get_data() + range.offset, source->get_data() + range.offset,
+                       static_cast<size_t>(range.length));
+            target->mark_dirty(static_cast<size_t>(range.offset), static_cast<size_t>(range.length));
+            applied += range.length;
+        }
+        return applied;
+    }
+
+    uint64_t apply_delta(const std::shared_ptr<SharedMemoryManager>& target, const uint8_t* data, size_t length,
+                         const std::vector<DirtyRange>& ranges) {
+        uint64_t end = 0;
+        uint64_t total = 0;
+        for (const DirtyRange& range : ranges) {
+            if (range.offset > UINT64_MAX - range.length || range.length > length - total) {
+                throw std::out_of_range("Delta data is shorter than its ranges");
+            }
+            end = std::max(end, range.offset + range.length);
+            total += range.length;
+        }
+        reserve_target(target, end);
+
+        MappingLock mapping = target->lock_mapping();
+        for (const DirtyRange& range : ranges) {
+            copy_bytes(target->get_data() + range.offset, data, static_cast<size_t>(range.length));
+            target->mark_dirty(static_cast<size_t>(range.offset), static_cast<size_t>(range.length));
+            data += range.length;
+        }
+        return total;
+    }
+}
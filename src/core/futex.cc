@@ -0,0 +1,110 @@
+#include "shared_memory.hh"
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace SharedMemory {
+#ifndef _WIN32
+    static long futex(std::atomic<uint32_t>* addr, int op, uint32_t value, const struct timespec* timeout, int wake) {
+        // 不使用 FUTEX_PRIVATE_FLAG，等待者和唤醒者位于不同进程
+        return syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), op, op == FUTEX_WAKE ? wake : value, timeout, nullptr, 0);
+    }
+
+    static int64_t monotonic_ns() {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+    }
+#endif
+
+    WaitResult futex_wait(std::atomic<uint32_t>* addr, uint32_t expected, double timeout_ms) {
+        static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be 32 bits");
+
+        if (addr->load(std::memory_order_acquire) != expected) {
+            return WaitResult::NotEqual;
+        }
+        bool infinite = timeout_ms < 0 || std::isinf(timeout_ms);
+
+#ifdef _WIN32
+        // Windows 没有跨进程的地址等待原语，退化为短间隔轮询
+        ULONGLONG deadline = infinite ? 0 : GetTickCount64() + static_cast<ULONGLONG>(timeout_ms);
+        while (addr->load(std::memory_order_acquire) == expected) {
+            if (!infinite && GetTickCount64() >= deadline) {
+                return WaitResult::TimedOut;
+            }
+            Sleep(1);
+        }
+        return WaitResult::Ok;
+#else
+        int64_t deadline = infinite ? 0 : monotonic_ns() + static_cast<int64_t>(timeout_ms * 1e6);
+        for (;;) {
+            struct timespec timeout;
+            struct timespec* timeout_ptr = nullptr;
+            if (!infinite) {
+                int64_t remaining = deadline - monotonic_ns();
+                if (remaining <= 0) {
+                    return WaitResult::TimedOut;
+                }
+                timeout.tv_sec = remaining / 1000000000LL;
+                timeout.tv_nsec = remaining % 1000000000LL;
+                timeout_ptr = &timeout;
+            }
+
+            if (futex(addr, FUTEX_WAIT, expected, timeout_ptr, 0) == 0) {
+                return WaitResult::Ok;
+            }
+            switch (errno) {
+                case EAGAIN:
+                    return WaitResult::NotEqual;
+                case ETIMEDOUT:
+                    return WaitResult::TimedOut;
+                case EINTR:
+                    // 被信号中断，按剩余时间继续等待
+                    if (addr->load(std::memory_order_acquire) != expected) {
+                        return WaitResult::Ok;
+                    }
+                    continue;
+                default:
+                    throw std::runtime_error(std::string("futex wait failed: ") + strerror(errno));
+            }
+        }
+#endif
+    }
+
+    int futex_wake(std::atomic<uint32_t>* addr, int count) {
+#ifdef _WIN32
+        // 轮询等待者会自行发现值的变化
+        (void)addr;
+        (void)count;
+        return 0;
+#else
+        long woken = futex(addr, FUTEX_WAKE, 0, nullptr, count);
+        if (woken < 0) {
+            throw std::runtime_error(std::string("futex wake failed: ") + strerror(errno));
+        }
+        return static_cast<int>(woken);
+#endif
+    }
+
+    const char* wait_result_name(WaitResult result) {
+        switch (result) {
+            case WaitResult::Ok:
+                return "ok";
+            case WaitResult::NotEqual:
+                return "not-equal";
+            case WaitResult::TimedOut:
+                return "timed-out";
+        }
+        return "ok";
+    }
+}
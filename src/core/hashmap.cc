@@ -0,0 +1,504 @@
+#include "shared_memory.hh"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace SharedMemory {
+    static const uint32_t MAP_MAGIC = 0x484d4150;           // "HMAP"
+    static const uint32_t SLOT_EMPTY = 0;
+    static const uint32_t SLOT_FULL = 1;
+    static const uint32_t SLOT_TOMBSTONE = 2;
+    static const size_t MAP_ALIGNMENT = 64;
+    static const int SPIN_LIMIT = 64;
+    static const int READ_TIMEOUT_MS = 1000;
+    static const int LOCK_TIMEOUT_MS = 5000;
+
+    // 桶头，version 为奇数时表示正在写入，读者据此校验读到的内容是否完整
+    struct MapSlot {
+        std::atomic<uint32_t> version;
+        std::atomic<uint32_t> state;
+        uint64_t hash;
+        uint32_t key_length;
+        uint32_t value_length;
+    };
+
+    // 哈希表控制块放在数据区内第一个缓存行对齐的位置
+    static size_t map_header_offset(void* data_addr) {
+        uintptr_t addr = reinterpret_cast<uintptr_t>(data_addr);
+        return ((addr + MAP_ALIGNMENT - 1) & ~(MAP_ALIGNMENT - 1)) - addr;
+    }
+
+    static size_t slot_size_of(size_t key_size, size_t value_size) {
+        return (sizeof(MapSlot) + key_size + value_size + 7) & ~static_cast<size_t>(7);
+    }
+
+    // 桶数取不小于容量两倍的 2 的幂，装载率不超过一半
+    static uint64_t bucket_count_of(size_t capacity) {
+        uint64_t buckets = 1;
+        while (buckets < static_cast<uint64_t>(capacity) * 2) {
+            buckets <<= 1;
+        }
+        return buckets;
+    }
+
+    // FNV-1a 后再做一次混合，保证低位（桶号）和高位（分段号）都分布均匀
+    static uint64_t hash_key(const uint8_t* key, size_t length) {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (size_t i = 0; i < length; i++) {
+            hash = (hash ^ key[i]) * 0x100000001b3ULL;
+        }
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    // 同一分段的写入者互斥，相同的键总是落在同一分段；持有者退出时由等待者接管
+    class StripeLock {
+    public:
+        StripeLock(std::atomic<uint32_t>& lock, bool local) : lock_(lock) { lock_spin(lock_, local, LOCK_TIMEOUT_MS); }
+        ~StripeLock() { unlock_spin(lock_); }
+
+    private:
+        std::atomic<uint32_t>& lock_;
+    };
+
+    static size_t stripe_of(uint64_t hash) {
+        return static_cast<size_t>(hash >> (64 - MAP_STRIPE_BITS));
+    }
+
+    // 锁定单个桶：版本号由偶数变为奇数。桶锁只在分段锁内短暂持有，不记录持有者，等待超时抛出异常
+    static uint32_t lock_slot(MapSlot* slot) {
+        std::chrono::steady_clock::time_point deadline;
+        int spins = 0;
+        uint32_t version = slot->version.load(std::memory_order_relaxed);
+        for (;;) {
+            if ((version & 1) == 0 &&
+                slot->version.compare_exchange_weak(version, version + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                break;
+            }
+            if (++spins > SPIN_LIMIT) {
+                if (spins == SPIN_LIMIT + 1) {
+                    deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(LOCK_TIMEOUT_MS);
+                }
+                else if (std::chrono::steady_clock::now() >= deadline) {
+                    throw std::runtime_error("Timed out waiting for a locked bucket");
+                }
+                std::this_thread::yield();
+            }
+            version = slot->version.load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        return version + 1;
+    }
+
+    static void unlock_slot(MapSlot* slot, uint32_t version) {
+        slot->version.store(version + 1, std::memory_order_release);
+    }
+
+    size_t SharedMap::segment_size(size_t capacity, size_t key_size, size_t value_size) {
+        return MAP_ALIGNMENT + sizeof(MapHeader) + bucket_count_of(capacity) * slot_size_of(key_size, value_size);
+    }
+
+    SharedMap::SharedMap(std::shared_ptr<SharedMemoryManager> manager, bool create,
+                         size_t capacity, size_t key_size, size_t value_size)
+        : manager_(std::move(manager)), header_(nullptr), slots_(nullptr)
+    {
+        uint8_t* data = manager_->get_data();
+        size_t header_offset = map_header_offset(data);
+        header_ = reinterpret_cast<MapHeader*>(data + header_offset);
+        slots_ = data + header_offset + sizeof(MapHeader);
+
+        if (create) {
+            if (capacity == 0 || key_size == 0 || key_size > UINT32_MAX || value_size > UINT32_MAX) {
+                throw std::invalid_argument("Invalid hash map geometry");
+            }
+            header_->capacity = capacity;
+            header_->buckets = bucket_count_of(capacity);
+            header_->key_size = static_cast<uint32_t>(key_size);
+            header_->value_size = static_cast<uint32_t>(value_size);
+            header_->slot_size = slot_size_of(key_size, value_size);
+            header_->count.store(0, std::memory_order_relaxed);
+            header_->relocations.store(0, std::memory_order_relaxed);
+            header_->inserts.store(0, std::memory_order_relaxed);
+            for (size_t i = 0; i < MAP_STRIPE_COUNT; i++) {
+                header_->stripes[i].lock.store(0, std::memory_order_relaxed);
+            }
+            // 重新创建时共享内存不会截断，需清空旧的桶
+            memset(slots_, 0, header_->buckets * header_->slot_size);
+            std::atomic_thread_fence(std::memory_order_release);
+            header_->magic = MAP_MAGIC;
+        }
+        else {
+            if (header_->magic != MAP_MAGIC) {
+                throw std::runtime_error("Shared memory is not a hash map");
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (header_->slot_size != slot_size_of(header_->key_size, header_->value_size) ||
+                header_offset + sizeof(MapHeader) + header_->buckets * header_->slot_size > manager_->get_size()) {
+                throw std::runtime_error("Hash map header is corrupted");
+            }
+        }
+        mask_ = header_->buckets - 1;
+    }
+
+    MapSlot* SharedMap::slot_at(uint64_t index) const {
+        return reinterpret_cast<MapSlot*>(slots_ + index * header_->slot_size);
+    }
+
+    // 无锁读取一个桶：按版本号校验，桶正在写入或读取期间被修改时重读
+    SharedMap::Probe SharedMap::read_slot(MapSlot* slot, uint64_t hash, const uint8_t* key, size_t key_length,
+                                          void* value, size_t* value_length) const {
+        const uint8_t* slot_key = reinterpret_cast<const uint8_t*>(slot + 1);
+        std::chrono::steady_clock::time_point deadline;
+        int spins = 0;
+        for (;;) {
+            uint32_t before = slot->version.load(std::memory_order_acquire);
+            if ((before & 1) == 0) {
+                uint32_t state = slot->state.load(std::memory_order_relaxed);
+                bool match = state == SLOT_FULL && slot->hash == hash && slot->key_length == key_length &&
+                             memcmp(slot_key, key, key_length) == 0;
+                size_t length = 0;
+                if (match && value_length) {
+                    length = std::min<size_t>(slot->value_length, header_->value_size);
+                    memcpy(value, slot_key + header_->key_size, length);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot->version.load(std::memory_order_relaxed) == before) {
+                    if (state == SLOT_EMPTY) {
+                        return Probe::Empty;
+                    }
+                    if (!match) {
+                        return Probe::Other;
+                    }
+                    if (value_length) {
+                        *value_length = length;
+                    }
+                    return Probe::Match;
+                }
+            }
+
+            if (++spins > SPIN_LIMIT) {
+                // 写入者可能已退出而未解锁桶，超时后放弃；只在开始让出 CPU 后才计时
+                if (spins == SPIN_LIMIT + 1) {
+                    deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(READ_TIMEOUT_MS);
+                }
+                else if (std::chrono::steady_clock::now() >= deadline) {
+                    throw std::runtime_error("Timed out waiting for a consistent bucket");
+                }
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    bool SharedMap::get(const void* key, size_t key_length, void* value, size_t& value_length) const {
+        if (key_length > header_->key_size) {
+            return false;
+        }
+        const uint8_t* bytes = static_cast<const uint8_t*>(key);
+        uint64_t hash = hash_key(bytes, key_length);
+        // 删除时键会前移到探测链中更早的桶，探测期间发生过前移时未命中可能是错过了正在移动的键，重新探测
+        for (;;) {
+            uint32_t relocations = header_->relocations.load(std::memory_order_seq_cst);
+            uint64_t index = hash & mask_;
+            for (uint64_t probe = 0; probe <= mask_; probe++, index = (index + 1) & mask_) {
+                Probe result = read_slot(slot_at(index), hash, bytes, key_length, value, &value_length);
+                if (result == Probe::Match) {
+                    return true;
+                }
+                if (result == Probe::Empty) {
+                    break;
+                }
+            }
+            if (header_->relocations.load(std::memory_order_seq_cst) == relocations) {
+                return false;
+            }
+        }
+    }
+
+    bool SharedMap::put(const void* key, size_t key_length, const void* value, size_t value_length) {
+        if (manager_->is_read_only()) {
+            throw std::runtime_error("Shared memory is mapped read-only");
+        }
+        if (key_length > header_->key_size) {
+            throw std::length_error("Key is longer than the hash map key size");
+        }
+        if (value_length > header_->value_size) {
+            throw std::length_error("Value is longer than the hash map value size");
+        }
+        const uint8_t* bytes = static_cast<const uint8_t*>(key);
+        uint64_t hash = hash_key(bytes, key_length);
+        StripeLock lock(header_->stripes[stripe_of(hash)].lock, manager_->local_pids());
+
+        for (;;) {
+            // 查找期间有墓碑被改回空桶时，选中的桶之前的探测链可能已断开，需重新查找
+            uint32_t relocations = header_->relocations.load(std::memory_order_seq_cst);
+            MapSlot* free_slot = nullptr;
+            uint64_t index = hash & mask_;
+            for (uint64_t probe = 0; probe <= mask_; probe++, index = (index + 1) & mask_) {
+                MapSlot* slot = slot_at(index);
+                Probe result = read_slot(slot, hash, bytes, key_length, nullptr, nullptr);
+                if (result == Probe::Match) {
+                    // 已存在的键只会被持有本分段锁的写入者修改，原地更新值
+                    uint32_t version = lock_slot(slot);
+                    memcpy(reinterpret_cast<uint8_t*>(slot + 1) + header_->key_size, value, value_length);
+                    slot->value_length = static_cast<uint32_t>(value_length);
+                    unlock_slot(slot, version);
+                    return true;
+                }
+                if (!free_slot && slot->state.load(std::memory_order_relaxed) != SLOT_FULL) {
+                    free_slot = slot;
+                }
+                if (result == Probe::Empty) {
+                    break;
+                }
+            }
+
+            if (!free_slot || header_->count.load(std::memory_order_relaxed) >= header_->capacity) {
+                return false;
+            }
+
+            // 空桶可能同时被其他分段的写入者占用，锁定后确认仍然空闲，否则重新查找
+            // 先登记插入再检查 relocations，与删除者“先登记改回空桶再检查 inserts”配对，双方至少有一方看到对方
+            uint32_t version = lock_slot(free_slot);
+            header_->inserts.fetch_add(1, std::memory_order_seq_cst);
+            if (free_slot->state.load(std::memory_order_relaxed) == SLOT_FULL ||
+                header_->relocations.load(std::memory_order_seq_cst) != relocations) {
+                unlock_slot(free_slot, version);
+                continue;
+            }
+            uint8_t* slot_key = reinterpret_cast<uint8_t*>(free_slot + 1);
+            memcpy(slot_key, key, key_length);
+            memcpy(slot_key + header_->key_size, value, value_length);
+            free_slot->hash = hash;
+            free_slot->key_length = static_cast<uint32_t>(key_length);
+            free_slot->value_length = static_cast<uint32_t>(value_length);
+            free_slot->state.store(SLOT_FULL, std::memory_order_relaxed);
+            unlock_slot(free_slot, version);
+            header_->count.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    bool SharedMap::remove(const void* key, size_t key_length) {
+        if (manager_->is_read_only()) {
+            throw std::runtime_error("Shared memory is mapped read-only");
+        }
+        if (key_length > header_->key_size) {
+            return false;
+        }
+        const uint8_t* bytes = static_cast<const uint8_t*>(key);
+        uint64_t hash = hash_key(bytes, key_length);
+        size_t stripe = stripe_of(hash);
+        StripeLock lock(header_->stripes[stripe].lock, manager_->local_pids());
+
+        uint64_t index = hash & mask_;
+        for (uint64_t probe = 0; probe <= mask_; probe++, index = (index + 1) & mask_) {
+            MapSlot* slot = slot_at(index);
+            Probe result = read_slot(slot, hash, bytes, key_length, nullptr, nullptr);
+            if (result == Probe::Empty) {
+                return false;
+            }
+            if (result == Probe::Match) {
+                // 先留下墓碑，保证探测链不断开，再把之后的键前移填补
+                uint32_t version = lock_slot(slot);
+                slot->state.store(SLOT_TOMBSTONE, std::memory_order_relaxed);
+                unlock_slot(slot, version);
+                header_->count.fetch_sub(1, std::memory_order_relaxed);
+                try {
+                    close_gap(index, stripe);
+                }
+                catch (const std::runtime_error&) {
+                    // 桶锁等待超时只放弃前移，键已删除，墓碑留给之后的删除处理
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 向后移位删除：删除留下的墓碑之后、同一簇中起始桶不在 (hole, index] 内的键前移到墓碑处，
+    // 前移后原位置成为新的墓碑；扫描到簇末尾的空桶时已没有键的探测链经过最后的墓碑，把它和之前连续的墓碑改回空桶。
+    // 反复插入删除后簇不会因墓碑越连越长，未命中的查找仍在第一个空桶处结束。
+    // 前移其他分段的键需要它的分段锁，拿不到或遇到正在写入的桶时停止，墓碑留给之后的删除处理
+    void SharedMap::close_gap(uint64_t hole, size_t stripe) {
+        uint32_t inserts = header_->inserts.load(std::memory_order_seq_cst);
+        uint64_t index = (hole + 1) & mask_;
+        for (uint64_t probe = 0; probe < mask_; probe++, index = (index + 1) & mask_) {
+            MapSlot* slot = slot_at(index);
+            uint32_t version = slot->version.load(std::memory_order_acquire);
+            uint32_t state = slot->state.load(std::memory_order_relaxed);
+            uint64_t hash = slot->hash;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if ((version & 1) != 0 || slot->version.load(std::memory_order_relaxed) != version) {
+                return;
+            }
+            if (state == SLOT_EMPTY) {
+                break;
+            }
+            if (state != SLOT_FULL || ((index - (hash & mask_)) & mask_) < ((index - hole) & mask_)) {
+                continue;
+            }
+            size_t owner = stripe_of(hash);
+            bool foreign = owner != stripe;
+            if (foreign && !try_lock_spin(header_->stripes[owner].lock, manager_->local_pids())) {
+                return;
+            }
+            bool moved = false;
+            try {
+                moved = move_slot(index, hole, hash);
+            }
+            catch (...) {
+                if (foreign) {
+                    unlock_spin(header_->stripes[owner].lock);
+                }
+                throw;
+            }
+            if (foreign) {
+                unlock_spin(header_->stripes[owner].lock);
+            }
+            if (!moved) {
+                return;
+            }
+            hole = index;
+        }
+
+        MapSlot* slot = slot_at(hole);
+        uint32_t version = lock_slot(slot);
+        bool emptied = false;
+        if (slot->state.load(std::memory_order_relaxed) == SLOT_TOMBSTONE) {
+            header_->relocations.fetch_add(1, std::memory_order_seq_cst);
+            if (header_->inserts.load(std::memory_order_seq_cst) == inserts) {
+                slot->state.store(SLOT_EMPTY, std::memory_order_relaxed);
+                emptied = true;
+            }
+        }
+        unlock_slot(slot, version);
+        if (emptied) {
+            reclaim_tombstones((hole - 1) & mask_);
+        }
+        reclaim_tombstones((index - 1) & mask_);
+    }
+
+    // 把 from 中的键复制到墓碑 to 后把 from 改为墓碑；复制期间键在两处都能找到。
+    // 按探测顺序先锁 to 再锁 from，墓碑已被插入者占用或键已变化时返回 false
+    bool SharedMap::move_slot(uint64_t from, uint64_t to, uint64_t hash) {
+        MapSlot* source = slot_at(from);
+        MapSlot* target = slot_at(to);
+        uint32_t target_version = lock_slot(target);
+        if (target->state.load(std::memory_order_relaxed) != SLOT_TOMBSTONE) {
+            unlock_slot(target, target_version);
+            return false;
+        }
+        uint32_t source_version = 0;
+        try {
+            source_version = lock_slot(source);
+        }
+        catch (...) {
+            unlock_slot(target, target_version);
+            throw;
+        }
+        bool moved = source->state.load(std::memory_order_relaxed) == SLOT_FULL && source->hash == hash;
+        if (moved) {
+            memcpy(reinterpret_cast<uint8_t*>(target + 1), reinterpret_cast<const uint8_t*>(source + 1),
+                   header_->key_size + header_->value_size);
+            target->hash = source->hash;
+            target->key_length = source->key_length;
+            target->value_length = source->value_length;
+            target->state.store(SLOT_FULL, std::memory_order_relaxed);
+            header_->relocations.fetch_add(1, std::memory_order_seq_cst);
+            source->state.store(SLOT_TOMBSTONE, std::memory_order_relaxed);
+        }
+        unlock_slot(source, source_version);
+        unlock_slot(target, target_version);
+        return moved;
+    }
+
+    // 下一个桶为空时，没有键的探测链经过这个墓碑，可以改回空桶；随后向前回收连续的墓碑。
+    // 墓碑和下一个桶都锁定后再确认，插入者锁定空桶后检查 relocations，不会把键放在断开的探测链之后
+    void SharedMap::reclaim_tombstones(uint64_t index) {
+        for (uint64_t reclaimed = 0; reclaimed < mask_; reclaimed++, index = (index - 1) & mask_) {
+            MapSlot* slot = slot_at(index);
+            MapSlot* next = slot_at((index + 1) & mask_);
+            if (slot->state.load(std::memory_order_relaxed) != SLOT_TOMBSTONE ||
+                next->state.load(std::memory_order_relaxed) != SLOT_EMPTY) {
+                return;
+            }
+            uint32_t version = lock_slot(slot);
+            uint32_t next_version = 0;
+            try {
+                next_version = lock_slot(next);
+            }
+            catch (...) {
+                unlock_slot(slot, version);
+                throw;
+            }
+            bool reclaim = slot->state.load(std::memory_order_relaxed) == SLOT_TOMBSTONE &&
+                           next->state.load(std::memory_order_relaxed) == SLOT_EMPTY;
+            if (reclaim) {
+                header_->relocations.fetch_add(1, std::memory_order_seq_cst);
+                slot->state.store(SLOT_EMPTY, std::memory_order_relaxed);
+            }
+            unlock_slot(next, next_version);
+            unlock_slot(slot, version);
+            if (!reclaim) {
+                return;
+            }
+        }
+    }
+
+    void SharedMap::iterate(const std::function<bool(const uint8_t*, size_t, const uint8_t*, size_t)>& visit) const {
+        std::vector<uint8_t> entry(header_->key_size + header_->value_size);
+        for (uint64_t index = 0; index <= mask_; index++) {
+            MapSlot* slot = slot_at(index);
+            const uint8_t* slot_key = reinterpret_cast<const uint8_t*>(slot + 1);
+            std::chrono::steady_clock::time_point deadline;
+            int spins = 0;
+            for (;;) {
+                uint32_t before = slot->version.load(std::memory_order_acquire);
+                if ((before & 1) == 0) {
+                    bool full = slot->state.load(std::memory_order_relaxed) == SLOT_FULL;
+                    size_t key_length = std::min<size_t>(slot->key_length, header_->key_size);
+                    size_t value_length = std::min<size_t>(slot->value_length, header_->value_size);
+                    if (full) {
+                        memcpy(entry.data(), slot_key, entry.size());
+                    }
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (slot->version.load(std::memory_order_relaxed) == before) {
+                        if (full && !visit(entry.data(), key_length, entry.data() + header_->key_size, value_length)) {
+                            return;
+                        }
+                        break;
+                    }
+                }
+                if (++spins > SPIN_LIMIT) {
+                    if (spins == SPIN_LIMIT + 1) {
+                        deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(READ_TIMEOUT_MS);
+                    }
+                    else if (std::chrono::steady_clock::now() >= deadline) {
+                        throw std::runtime_error("Timed out waiting for a consistent bucket");
+                    }
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    size_t SharedMap::size() const {
+        return static_cast<size_t>(header_->count.load(std::memory_order_relaxed));
+    }
+
+    size_t SharedMap::capacity() const {
+        return static_cast<size_t>(header_->capacity);
+    }
+
+    size_t SharedMap::key_size() const {
+        return header_->key_size;
+    }
+
+    size_t SharedMap::value_size() const {
+        return header_->value_size;
+    }
+}
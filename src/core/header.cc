@@ -0,0 +1,60 @@
+#include "shared_memory.hh"
+#include <stdexcept>
+
+namespace SharedMemory {
+    static_assert(sizeof(SharedMemoryHeader) % CACHE_LINE_SIZE == 0, "header must end on a cache line");
+    static_assert(sizeof(SharedMemoryHeader) <= PAGE_SIZE_BYTES, "header must fit in one page");
+    static_assert(sizeof(LegacyHeader) == 16, "legacy header is 16 bytes");
+
+    size_t data_offset_for(size_t size, size_t dirty_block) {
+        // 跟踪区随数据区大小增长，数据区仍从页边界开始
+        if (dirty_block) {
+            size_t used = sizeof(SharedMemoryHeader) + dirty_tracker_bytes(size, dirty_block);
+            return (used + PAGE_SIZE_BYTES - 1) & ~(PAGE_SIZE_BYTES - 1);
+        }
+        if (size >= PAGE_SIZE_BYTES) {
+            return PAGE_SIZE_BYTES;
+        }
+        return (sizeof(SharedMemoryHeader) + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1);
+    }
+
+    bool is_legacy_header(const void* address, uint64_t object_size) {
+        // 新版头部写入魔数之前全为 0，旧版头部的大小字段非 0 且与对象大小吻合
+        const SharedMemoryHeader* header = static_cast<const SharedMemoryHeader*>(address);
+        if (header->magic == HEADER_MAGIC) {
+            return false;
+        }
+        const LegacyHeader* legacy = static_cast<const LegacyHeader*>(address);
+        return legacy->size != 0 && legacy->size <= object_size - sizeof(LegacyHeader) &&
+               object_size >= sizeof(LegacyHeader);
+    }
+
+    SharedMemoryHeader* SharedMemoryManager::header() const {
+        if (!address_) {
+            throw std::runtime_error("Shared memory is not mapped");
+        }
+        if (legacy_) {
+            throw std::runtime_error("Legacy shared memory has no header lock, recreate it with this version");
+        }
+        // 只读映射不能写入头部，私有映射中的锁只在本映射内有效
+        if (mode_ != MapMode::ReadWrite) {
+            throw std::runtime_error(mode_ == MapMode::ReadOnly ? "Shared memory is mapped read-only" :
+                                                                  "Shared memory is mapped privately");
+        }
+        return static_cast<SharedMemoryHeader*>(address_);
+    }
+
+    size_t SharedMemoryManager::header_data_offset() const {
+        if (!address_) {
+            throw std::runtime_error("Shared memory is not mapped");
+        }
+        if (legacy_) {
+            return sizeof(LegacyHeader);
+        }
+        uint64_t data_offset = static_cast<const SharedMemoryHeader*>(address_)->data_offset;
+        if (data_offset < HEADER_BASE_SIZE || data_offset % CACHE_LINE_SIZE != 0 || data_offset > SIZE_MAX / 2) {
+            throw std::runtime_error("Shared memory header has an invalid data offset");
+        }
+        return static_cast<size_t>(data_offset);
+    }
+}
@@ -0,0 +1,147 @@
+#include "shared_memory.hh"
+#include <stdexcept>
+
+namespace SharedMemory {
+    static const uint32_t HEAP_MAGIC = 0x48454150;          // "HEAP"
+    static const uint32_t BLOCK_USED = 0x55534544;          // "USED"
+    static const uint32_t BLOCK_FREE = 0x46524545;          // "FREE"
+    static const size_t HEAP_ALIGNMENT = 64;
+    static const size_t MIN_CLASS_SHIFT = 5;                // 最小块 32 字节（16 字节块头 + 16 字节数据）
+    static const int LOCK_TIMEOUT_MS = 5000;
+
+    // 每个块前的块头，释放后 next_free 串成空闲链表；state 由释放者以 CAS 从 USED 改为 FREE，重复释放只有一方成功
+    struct HeapBlock {
+        std::atomic<uint32_t> state;
+        uint32_t size_class;
+        uint64_t next_free;
+    };
+    static_assert(sizeof(HeapBlock) == 16, "block header must keep payload 16-byte aligned");
+
+    // 堆控制块放在数据区内第一个缓存行对齐的位置
+    static size_t heap_header_offset(void* data_addr) {
+        uintptr_t addr = reinterpret_cast<uintptr_t>(data_addr);
+        return ((addr + HEAP_ALIGNMENT - 1) & ~(HEAP_ALIGNMENT - 1)) - addr;
+    }
+
+    // 按尺寸类的自旋锁，只保护对应的空闲链表；持有者退出时由等待者接管
+    class ClassLock {
+    public:
+        ClassLock(std::atomic<uint32_t>& lock, bool local) : lock_(lock) { lock_spin(lock_, local, LOCK_TIMEOUT_MS); }
+        ~ClassLock() { unlock_spin(lock_); }
+
+    private:
+        std::atomic<uint32_t>& lock_;
+    };
+
+    size_t SharedHeap::segment_size(size_t size) {
+        return HEAP_ALIGNMENT + sizeof(HeapHeader) + size;
+    }
+
+    SharedHeap::SharedHeap(std::shared_ptr<SharedMemoryManager> manager, bool create)
+        : manager_(std::move(manager)), data_(nullptr), header_(nullptr)
+    {
+        if (manager_->is_read_only()) {
+            throw std::invalid_argument("Shared heap requires a writable mapping");
+        }
+        data_ = manager_->get_data();
+        size_t header_offset = heap_header_offset(data_);
+        header_ = reinterpret_cast<HeapHeader*>(data_ + header_offset);
+
+        if (create) {
+            header_->arena_begin = header_offset + sizeof(HeapHeader);
+            header_->arena_end = manager_->get_size();
+            header_->bump.store(header_->arena_begin, std::memory_order_relaxed);
+            for (size_t i = 0; i < HEAP_CLASS_COUNT; i++) {
+                header_->classes[i].lock.store(0, std::memory_order_relaxed);
+                header_->classes[i].free_head = 0;
+                header_->classes[i].free_count = 0;
+            }
+            std::atomic_thread_fence(std::memory_order_release);
+            header_->magic = HEAP_MAGIC;
+        }
+        else {
+            if (header_->magic != HEAP_MAGIC) {
+                throw std::runtime_error("Shared memory is not a heap");
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (header_->arena_end > manager_->get_size() || header_->arena_begin > header_->arena_end) {
+                throw std::runtime_error("Heap header is corrupted");
+            }
+        }
+    }
+
+    uint64_t SharedHeap::alloc(size_t size) {
+        // 选择能容纳块头和数据的最小 2 的幂尺寸类
+        size_t size_class = 0;
+        while (size_class < HEAP_CLASS_COUNT &&
+               (static_cast<size_t>(1) << (size_class + MIN_CLASS_SHIFT)) - sizeof(HeapBlock) < size) {
+            size_class++;
+        }
+        if (size_class == HEAP_CLASS_COUNT) {
+            throw std::length_error("Allocation is larger than the largest size class");
+        }
+        uint64_t block_size = static_cast<uint64_t>(1) << (size_class + MIN_CLASS_SHIFT);
+
+        uint64_t block = 0;
+        {
+            // 优先复用空闲链表中的块
+            ClassLock lock(header_->classes[size_class].lock, manager_->local_pids());
+            block = header_->classes[size_class].free_head;
+            if (block) {
+                HeapBlock* free_block = reinterpret_cast<HeapBlock*>(data_ + block);
+                header_->classes[size_class].free_head = free_block->next_free;
+                header_->classes[size_class].free_count--;
+            }
+        }
+
+        if (!block) {
+            // 从未分配区域切出新块
+            uint64_t bump = header_->bump.load(std::memory_order_relaxed);
+            do {
+                if (bump + block_size > header_->arena_end) {
+                    return 0;
+                }
+            } while (!header_->bump.compare_exchange_weak(bump, bump + block_size, std::memory_order_relaxed));
+            block = bump;
+        }
+
+        HeapBlock* block_header = reinterpret_cast<HeapBlock*>(data_ + block);
+        block_header->size_class = static_cast<uint32_t>(size_class);
+        block_header->next_free = 0;
+        block_header->state.store(BLOCK_USED, std::memory_order_release);
+        return block + sizeof(HeapBlock);
+    }
+
+    HeapBlock* SharedHeap::used_block(uint64_t offset) const {
+        if (offset < header_->arena_begin + sizeof(HeapBlock) || offset >= header_->arena_end ||
+            offset % sizeof(HeapBlock) != 0) {
+            throw std::out_of_range("Offset is not inside the heap");
+        }
+        HeapBlock* block = reinterpret_cast<HeapBlock*>(data_ + offset - sizeof(HeapBlock));
+        uint32_t state = block->state.load(std::memory_order_acquire);
+        if (state != BLOCK_USED || block->size_class >= HEAP_CLASS_COUNT) {
+            throw std::invalid_argument(state == BLOCK_FREE ? "Block is already freed" : "Offset is not an allocated block");
+        }
+        return block;
+    }
+
+    void SharedHeap::free(uint64_t offset) {
+        HeapBlock* block = used_block(offset);
+        // 检查与加锁之间其他线程或进程可能已释放同一块，只有把状态从 USED 改为 FREE 的一方把块放回链表
+        uint32_t expected = BLOCK_USED;
+        if (!block->state.compare_exchange_strong(expected, BLOCK_FREE, std::memory_order_acq_rel)) {
+            throw std::invalid_argument(expected == BLOCK_FREE ? "Block is already freed" : "Offset is not an allocated block");
+        }
+        uint32_t size_class = block->size_class;
+
+        ClassLock lock(header_->classes[size_class].lock, manager_->local_pids());
+        block->next_free = header_->classes[size_class].free_head;
+        header_->classes[size_class].free_head = offset - sizeof(HeapBlock);
+        header_->classes[size_class].free_count++;
+    }
+
+    size_t SharedHeap::usable_size(uint64_t offset) const {
+        HeapBlock* block = used_block(offset);
+        return (static_cast<size_t>(1) << (block->size_class + MIN_CLASS_SHIFT)) - sizeof(HeapBlock);
+    }
+}
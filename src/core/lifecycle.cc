@@ -0,0 +1,378 @@
+#include "shared_memory.hh"
+#include "logging.hh"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#endif
+
+namespace SharedMemory {
+    static uint32_t current_pid() {
+#ifdef _WIN32
+        return static_cast<uint32_t>(GetCurrentProcessId());
+#else
+        return static_cast<uint32_t>(getpid());
+#endif
+    }
+
+    void SharedMemoryManager::attach_owner() {
+        SegmentOwners* record = owners();
+        if (!record || attached_) {
+            return;
+        }
+        record->attached.fetch_add(1, std::memory_order_acq_rel);
+        attached_ = true;
+
+        // 其他 PID 命名空间中的进程号在回收者看来没有意义，只计数不登记，回收者因此保守地不回收
+        if (header()->pid_namespace != pid_namespace()) {
+            LOG_DEBUG("Attached from another PID namespace, attachment is counted but not recorded: key=%s",
+                key_.c_str());
+            return;
+        }
+
+        // 每个映射占一个槽，同一进程的多个映射互不影响
+        uint32_t pid = current_pid();
+        for (size_t i = 0; i < OWNER_SLOT_COUNT; i++) {
+            uint32_t expected = 0;
+            if (record->pids[i].load(std::memory_order_relaxed) == 0 &&
+                record->pids[i].compare_exchange_strong(expected, pid, std::memory_order_acq_rel)) {
+                owner_slot_ = static_cast<int>(i);
+                return;
+            }
+        }
+        LOG_WARN("Owner slots are full, attachment is counted but not recorded: key=%s", key_.c_str());
+    }
+
+    void SharedMemoryManager::detach_owner() {
+        SegmentOwners* record = owners();
+        if (!record || !attached_) {
+            return;
+        }
+        if (owner_slot_ >= 0) {
+            record->pids[owner_slot_].store(0, std::memory_order_release);
+            owner_slot_ = -1;
+        }
+        record->attached.fetch_sub(1, std::memory_order_acq_rel);
+        attached_ = false;
+    }
+
+    // 写入者和锁持有者的进程号只在与创建者同一 PID 命名空间时有意义，其他命名空间的进程不记录也不据此恢复
+    bool SharedMemoryManager::local_pids() const {
+        if (legacy_) {
+            return false;
+        }
+#ifdef _WIN32
+        return true;
+#else
+        uint32_t ours = pid_namespace();
+        return ours != 0 && ours == header()->pid_namespace;
+#endif
+    }
+
+    // 其他 PID 命名空间中的持有者写入的锁字，不是有效的进程号，永远不会被判为已退出
+    static const uint32_t UNKNOWN_HOLDER = UINT32_MAX;
+    static const int SPIN_LIMIT = 64;
+
+    bool try_lock_spin(std::atomic<uint32_t>& lock, bool local) {
+        uint32_t expected = 0;
+        return lock.compare_exchange_strong(expected, local ? current_pid() : UNKNOWN_HOLDER,
+                                            std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void lock_spin(std::atomic<uint32_t>& lock, bool local, int timeout_ms) {
+        uint32_t self = local ? current_pid() : UNKNOWN_HOLDER;
+        std::chrono::steady_clock::time_point deadline;
+        int spins = 0;
+        uint32_t holder = 0;
+        while (!lock.compare_exchange_weak(holder, self, std::memory_order_acquire, std::memory_order_relaxed)) {
+            if (holder == 0) {
+                continue;
+            }
+            if (++spins > SPIN_LIMIT) {
+                // 持有者退出而未释放：以 CAS 换入自己的进程号，多个等待者中只有一个接管
+                if (local && holder != UNKNOWN_HOLDER && holder != self && !process_alive(holder)) {
+                    if (lock.compare_exchange_strong(holder, self, std::memory_order_acquire, std::memory_order_relaxed)) {
+                        LOG_WARN("Recovered spin lock abandoned by process %u", holder);
+                        return;
+                    }
+                }
+                if (spins == SPIN_LIMIT + 1) {
+                    deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+                }
+                else if (std::chrono::steady_clock::now() >= deadline) {
+                    LOG_ERROR("Timed out waiting for spin lock held by process %u", holder);
+                    throw std::runtime_error("Timed out waiting for a shared spin lock");
+                }
+                std::this_thread::yield();
+            }
+            holder = 0;
+        }
+    }
+
+#ifdef _WIN32
+    uint32_t pid_namespace() {
+        return 0;
+    }
+
+    bool process_alive(uint32_t pid) {
+        HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, pid);
+        if (!process) {
+            return GetLastError() == ERROR_ACCESS_DENIED;
+        }
+        bool alive = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+        CloseHandle(process);
+        return alive;
+    }
+
+    // Windows 上的共享内存是用户目录中的文件，进程全部退出后由系统释放映射，不需要回收
+    std::vector<SegmentInfo> list_segments() {
+        return std::vector<SegmentInfo>();
+    }
+
+    std::vector<SegmentInfo> collect_orphans(bool /*dry_run*/) {
+        return std::vector<SegmentInfo>();
+    }
+#else
+    uint32_t pid_namespace() {
+        static const uint32_t ns = []() -> uint32_t {
+            struct stat st;
+            return stat("/proc/self/ns/pid", &st) == 0 ? static_cast<uint32_t>(st.st_ino) : 0;
+        }();
+        return ns;
+    }
+
+    bool process_alive(uint32_t pid) {
+        if (pid == 0) {
+            return false;
+        }
+        return kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+    }
+
+    static const char SEGMENT_PREFIX[] = "skyline_";
+    static const char SEGMENT_SUFFIX[] = ".dat";
+    static const char SEMAPHORE_PREFIX[] = "sem.skyline_mutex_";
+
+    // 从文件名 skyline_<key>.dat 中取出键名
+    static bool segment_key(const std::string& name, std::string& key) {
+        size_t prefix = sizeof(SEGMENT_PREFIX) - 1;
+        size_t suffix = sizeof(SEGMENT_SUFFIX) - 1;
+        if (name.size() <= prefix + suffix || name.compare(0, prefix, SEGMENT_PREFIX) != 0 ||
+            name.compare(name.size() - suffix, suffix, SEGMENT_SUFFIX) != 0) {
+            return false;
+        }
+        key = name.substr(prefix, name.size() - prefix - suffix);
+        return true;
+    }
+
+    // 目录中的文件名
+    static std::vector<std::string> directory_entries(const std::string& dir) {
+        std::vector<std::string> names;
+        DIR* handle = opendir(dir.c_str());
+        if (!handle) {
+            return names;
+        }
+        while (struct dirent* entry = readdir(handle)) {
+            names.push_back(entry->d_name);
+        }
+        closedir(handle);
+        return names;
+    }
+
+    // 从映射的头部读取附加记录，只读原子字段
+    static void inspect_header(const SharedMemoryHeader* header, SegmentInfo& info) {
+        info.legacy = false;
+        info.tracked = false;
+        info.foreign = false;
+        info.orphaned = false;
+        info.owners.clear();
+        if (is_legacy_header(header, info.object_size)) {
+            info.legacy = true;
+            return;
+        }
+        if (header->magic != HEADER_MAGIC) {
+            return;
+        }
+        info.creator_pid = header->owner_pid;
+        info.tracked = header->format_version >= 3 && header->data_offset >= sizeof(SharedMemoryHeader) &&
+                       info.object_size >= sizeof(SharedMemoryHeader);
+        if (!info.tracked) {
+            return;
+        }
+        const SegmentOwners& record = header->owners;
+        info.attached = record.attached.load(std::memory_order_acquire);
+        info.removed = record.removed.load(std::memory_order_acquire) != 0;
+        // 创建者在其他（或未知的）PID 命名空间中时进程号无法用 kill 判断，全部视为存活
+        info.foreign = header->pid_namespace == 0 || header->pid_namespace != pid_namespace();
+        uint32_t recorded = 0;
+        for (size_t i = 0; i < OWNER_SLOT_COUNT; i++) {
+            uint32_t pid = record.pids[i].load(std::memory_order_acquire);
+            if (pid == 0) {
+                continue;
+            }
+            recorded++;
+            if (info.foreign || process_alive(pid)) {
+                info.owners.push_back(pid);
+            }
+        }
+        // 超出槽数的附加无法判断其进程是否存活，保守地不回收
+        info.orphaned = !info.foreign && info.owners.empty() && !process_alive(info.creator_pid) &&
+                        info.attached <= recorded;
+    }
+
+    // 只读映射头部检查；不获取互斥锁（持有者可能已退出），回收前由 reclaim_segment 在锁内重新检查
+    static bool inspect_segment(int fd, size_t header_length, SegmentInfo& info) {
+        struct stat st;
+        if (fstat(fd, &st) == -1) {
+            return false;
+        }
+        info.object_size = static_cast<uint64_t>(st.st_size);
+        if (info.object_size < sizeof(LegacyHeader)) {
+            return true;
+        }
+        void* address = mmap(NULL, header_length, PROT_READ, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED) {
+            return false;
+        }
+        inspect_header(static_cast<const SharedMemoryHeader*>(address), info);
+        munmap(address, header_length);
+        return true;
+    }
+
+    // 列出一个目录中的共享内存对象，shm 对象以 /name 打开，hugetlbfs 上以完整路径打开
+    static void list_directory(const std::string& dir, size_t huge_page_size, std::vector<SegmentInfo>& segments) {
+        bool huge = huge_page_size != 0;
+        // hugetlbfs 上的映射长度须为大页的整数倍
+        size_t header_length = huge ? (sizeof(SharedMemoryHeader) + huge_page_size - 1) / huge_page_size * huge_page_size :
+                                      sizeof(SharedMemoryHeader);
+        for (const std::string& name : directory_entries(dir)) {
+            SegmentInfo info;
+            if (!segment_key(name, info.key)) {
+                continue;
+            }
+            info.path = huge ? dir + "/" + name : "/" + name;
+            int fd = huge ? open(info.path.c_str(), O_RDONLY) : shm_open(info.path.c_str(), O_RDONLY, 0);
+            if (fd == -1) {
+                continue;
+            }
+            if (inspect_segment(fd, header_length, info)) {
+                segments.push_back(std::move(info));
+            }
+            close(fd);
+        }
+    }
+
+    std::vector<SegmentInfo> list_segments() {
+        std::vector<SegmentInfo> segments;
+        list_directory("/dev/shm", 0, segments);
+        size_t huge_page_size = 0;
+        std::string mount = hugetlbfs_mount(huge_page_size);
+        if (!mount.empty()) {
+            list_directory(mount, huge_page_size, segments);
+        }
+        return segments;
+    }
+
+    // shm 名称以 / 开头且不含其他 /，hugetlbfs 上为完整路径
+    static bool shm_path(const std::string& path) {
+        return path.find('/', 1) == std::string::npos;
+    }
+
+    static bool unlink_path(const std::string& path) {
+        return (shm_path(path) ? shm_unlink(path.c_str()) : unlink(path.c_str())) == 0;
+    }
+
+    // 在头部互斥锁内重新检查并删除名称。检查之后有进程附加、或名称已被删除并重新创建时不删除；
+    // 删除前标记 removed，此后拿到锁的打开者放弃这个对象重新打开。返回是否已删除
+    static bool reclaim_segment(SegmentInfo& info) {
+        bool shm = shm_path(info.path);
+        int fd = shm ? shm_open(info.path.c_str(), O_RDWR, 0) : open(info.path.c_str(), O_RDWR);
+        if (fd == -1) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == -1 || static_cast<uint64_t>(st.st_size) < sizeof(SharedMemoryHeader)) {
+            close(fd);
+            return false;
+        }
+        info.object_size = static_cast<uint64_t>(st.st_size);
+        // hugetlbfs 上的映射长度须为大页的整数倍，块大小即大页大小
+        size_t header_length = sizeof(SharedMemoryHeader);
+        struct statvfs vfs;
+        if (!shm && fstatvfs(fd, &vfs) == 0 && vfs.f_bsize > 0) {
+            header_length = (header_length + vfs.f_bsize - 1) / vfs.f_bsize * vfs.f_bsize;
+        }
+        void* address = mmap(NULL, header_length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (address == MAP_FAILED) {
+            return false;
+        }
+        SharedMemoryHeader* header = static_cast<SharedMemoryHeader*>(address);
+        bool removed = false;
+        // 互斥锁尚未初始化说明正有进程在创建，不等待
+        if (header->magic == HEADER_MAGIC && header_lock_ready(header) &&
+            lock_header(header, 0) != LockResult::Busy) {
+            inspect_header(header, info);
+            if (info.orphaned) {
+                header->owners.removed.store(1, std::memory_order_release);
+                removed = unlink_path(info.path);
+                if (!removed) {
+                    LOG_WARN("Failed to remove orphaned shared memory %s, error: %s", info.path.c_str(),
+                        strerror(errno));
+                    header->owners.removed.store(0, std::memory_order_release);
+                }
+            }
+            unlock_header(header);
+        }
+        munmap(address, header_length);
+        return removed;
+    }
+
+    std::vector<SegmentInfo> collect_orphans(bool dry_run) {
+        std::vector<SegmentInfo> collected;
+        std::set<std::string> live_keys;
+        for (SegmentInfo& info : list_segments()) {
+            if (!info.orphaned) {
+                live_keys.insert(info.key);
+                continue;
+            }
+            if (!dry_run) {
+                if (!reclaim_segment(info)) {
+                    LOG_DEBUG("Shared memory is no longer orphaned, skipped: key=%s", info.key.c_str());
+                    live_keys.insert(info.key);
+                    continue;
+                }
+                evict_manager(info.key);
+                LOG_INFO("Removed orphaned shared memory: key=%s, size=%llu", info.key.c_str(),
+                    static_cast<unsigned long long>(info.object_size));
+            }
+            collected.push_back(std::move(info));
+        }
+
+        // 旧版本为每个共享内存创建的命名信号量，对应的对象已不存在时删除
+        size_t prefix = sizeof(SEMAPHORE_PREFIX) - 1;
+        for (const std::string& name : directory_entries("/dev/shm")) {
+            if (name.compare(0, prefix, SEMAPHORE_PREFIX) != 0) {
+                continue;
+            }
+            std::string key = name.substr(prefix);
+            if (live_keys.count(key)) {
+                continue;
+            }
+            if (!dry_run && sem_unlink(("/skyline_mutex_" + key).c_str()) == 0) {
+                LOG_INFO("Removed legacy semaphore: key=%s", key.c_str());
+            }
+        }
+        return collected;
+    }
+#endif
+}
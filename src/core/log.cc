@@ -0,0 +1,197 @@
+#include "shared_memory.hh"
+#include "logging.hh"
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <spdlog/async.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+namespace SharedMemory {
+    static const size_t LOG_QUEUE_SIZE = 256;    // 必须是 2 的幂
+    static const size_t LOG_MESSAGE_SIZE = 512;
+
+    // 有界无锁队列（Vyukov MPMC），sequence 标记槽位可写/可读
+    struct LogSlot {
+        std::atomic<size_t> sequence;
+        LogLevel level;
+        char message[LOG_MESSAGE_SIZE];
+    };
+
+    struct LogQueue {
+        LogSlot slots[LOG_QUEUE_SIZE];
+        alignas(64) std::atomic<size_t> enqueue_pos;
+        alignas(64) std::atomic<size_t> dequeue_pos;
+        alignas(64) std::atomic<uint64_t> dropped;
+
+        LogQueue() : enqueue_pos(0), dequeue_pos(0), dropped(0) {
+            for (size_t i = 0; i < LOG_QUEUE_SIZE; i++) {
+                slots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        bool push(LogLevel level, const char* message) {
+            size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+            LogSlot* slot;
+            for (;;) {
+                slot = &slots[pos & (LOG_QUEUE_SIZE - 1)];
+                size_t sequence = slot->sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+                if (diff == 0) {
+                    if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                } else {
+                    pos = enqueue_pos.load(std::memory_order_relaxed);
+                }
+            }
+            slot->level = level;
+            // 超长的消息截断，只复制实际长度而不像 strncpy 那样补零整个槽
+            size_t length = strnlen(message, LOG_MESSAGE_SIZE - 1);
+            memcpy(slot->message, message, length);
+            slot->message[length] = '\0';
+            slot->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool pop(LogLevel& level, char* message) {
+            size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+            LogSlot* slot;
+            for (;;) {
+                slot = &slots[pos & (LOG_QUEUE_SIZE - 1)];
+                size_t sequence = slot->sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+                if (diff == 0) {
+                    if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = dequeue_pos.load(std::memory_order_relaxed);
+                }
+            }
+            level = slot->level;
+            memcpy(message, slot->message, LOG_MESSAGE_SIZE);
+            slot->sequence.store(pos + LOG_QUEUE_SIZE, std::memory_order_release);
+            return true;
+        }
+    };
+
+    static LogQueue log_queue;
+    static std::atomic<int> log_level{static_cast<int>(LogLevel::Info)};
+    static std::atomic<LogNotifier> log_notifier{nullptr};
+    static std::atomic<bool> flush_pending{false};
+
+    // 未接入 JS 时写入异步 spdlog，格式化和输出都不在调用线程完成
+    static std::shared_ptr<spdlog::logger> default_logger() {
+        static std::shared_ptr<spdlog::logger> logger = [] {
+            auto existing = spdlog::get("shared_memory");
+            if (existing) {
+                return existing;
+            }
+            return spdlog::create_async<spdlog::sinks::stdout_color_sink_mt>("shared_memory");
+        }();
+        return logger;
+    }
+
+    static spdlog::level::level_enum to_spdlog(LogLevel level) {
+        switch (level) {
+            case LogLevel::Trace: return spdlog::level::trace;
+            case LogLevel::Debug: return spdlog::level::debug;
+            case LogLevel::Info: return spdlog::level::info;
+            case LogLevel::Warn: return spdlog::level::warn;
+            case LogLevel::Error: return spdlog::level::err;
+            default: return spdlog::level::off;
+        }
+    }
+
+    bool log_enabled(LogLevel level) {
+        return static_cast<int>(level) >= log_level.load(std::memory_order_relaxed);
+    }
+
+    void set_log_level(LogLevel level) {
+        log_level.store(static_cast<int>(level), std::memory_order_relaxed);
+        auto logger = default_logger();
+        logger->set_level(to_spdlog(level));
+    }
+
+    LogLevel get_log_level() {
+        return static_cast<LogLevel>(log_level.load(std::memory_order_relaxed));
+    }
+
+    void set_log_notifier(LogNotifier notifier) {
+        log_notifier.store(notifier, std::memory_order_release);
+        flush_pending.store(false, std::memory_order_release);
+    }
+
+    void log(LogLevel level, const char* format, ...) {
+        char buffer[LOG_MESSAGE_SIZE];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+
+        LogNotifier notifier = log_notifier.load(std::memory_order_acquire);
+        if (!notifier) {
+            try {
+                default_logger()->log(to_spdlog(level), "{}", buffer);
+            } catch (...) {
+                // 进程退出阶段日志线程可能已销毁，丢弃即可
+            }
+            return;
+        }
+
+        if (log_queue.push(level, buffer) && !flush_pending.exchange(true, std::memory_order_acq_rel)) {
+            // 每批只唤醒一次 JS 线程
+            notifier();
+        }
+    }
+
+    size_t drain_log(void (*deliver)(LogLevel level, const char* message, void* context), void* context) {
+        // 先清除标记，之后入队的日志会触发新的一批
+        flush_pending.store(false, std::memory_order_release);
+
+        size_t count = 0;
+        LogLevel level;
+        char message[LOG_MESSAGE_SIZE];
+        while (log_queue.pop(level, message)) {
+            deliver(level, message, context);
+            count++;
+        }
+
+        uint64_t dropped = log_queue.dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0) {
+            snprintf(message, sizeof(message), "%llu log entries dropped", static_cast<unsigned long long>(dropped));
+            deliver(LogLevel::Warn, message, context);
+        }
+        return count;
+    }
+
+    const char* log_level_name(LogLevel level) {
+        switch (level) {
+            case LogLevel::Trace: return "trace";
+            case LogLevel::Debug: return "debug";
+            case LogLevel::Info: return "info";
+            case LogLevel::Warn: return "warn";
+            case LogLevel::Error: return "error";
+            default: return "off";
+        }
+    }
+
+    bool parse_log_level(const std::string& name, LogLevel& level) {
+        static const LogLevel levels[] = {
+            LogLevel::Trace, LogLevel::Debug, LogLevel::Info, LogLevel::Warn, LogLevel::Error, LogLevel::Off
+        };
+        for (LogLevel candidate : levels) {
+            if (name == log_level_name(candidate)) {
+                level = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+}
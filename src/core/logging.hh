@@ -0,0 +1,46 @@
+#pragma once
+
+#ifndef SHARED_MEMORY_LOGGING_HH
+#define SHARED_MEMORY_LOGGING_HH
+// 库内部使用的日志宏，不随公共头文件导出，避免与使用者的宏冲突
+#include "shared_memory.hh"
+
+// 编译期日志级别，低于该级别的日志语句不会被编译（0=trace ... 5=off）
+#ifndef SHARED_MEMORY_LOG_LEVEL
+#define SHARED_MEMORY_LOG_LEVEL 0
+#endif
+
+#define SHARED_MEMORY_LOG(level, ...) \
+    do { \
+        if (SharedMemory::log_enabled(level)) { \
+            SharedMemory::log(level, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#if SHARED_MEMORY_LOG_LEVEL <= 0
+#define LOG_TRACE(...) SHARED_MEMORY_LOG(SharedMemory::LogLevel::Trace, __VA_ARGS__)
+#else
+#define LOG_TRACE(...) ((void)0)
+#endif
+#if SHARED_MEMORY_LOG_LEVEL <= 1
+#define LOG_DEBUG(...) SHARED_MEMORY_LOG(SharedMemory::LogLevel::Debug, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+#if SHARED_MEMORY_LOG_LEVEL <= 2
+#define LOG_INFO(...) SHARED_MEMORY_LOG(SharedMemory::LogLevel::Info, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+#if SHARED_MEMORY_LOG_LEVEL <= 3
+#define LOG_WARN(...) SHARED_MEMORY_LOG(SharedMemory::LogLevel::Warn, __VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+#if SHARED_MEMORY_LOG_LEVEL <= 4
+#define LOG_ERROR(...) SHARED_MEMORY_LOG(SharedMemory::LogLevel::Error, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,836 @@
+#include "shared_memory.hh"
+#include "logging.hh"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <sys/stat.h>
+#include <stdexcept>
+#include <thread>
+
+#ifdef _WIN32
+#include <direct.h> // 用于Windows目录创建
+#include <shlobj.h> // 用于获取用户目录
+#else
+#include <errno.h>    // 用于错误处理
+#include <sys/mman.h>
+#include <sys/statvfs.h>
+#endif
+
+namespace SharedMemory {
+    // 打开期间名称被删除时重新打开的次数，删除和重新创建不会一直交替发生
+    static const int REOPEN_ATTEMPTS = 8;
+
+    // 检测是否在Wine环境下运行
+    bool is_running_under_wine() {
+#ifdef _WIN32
+        HMODULE hntdll = GetModuleHandleA("ntdll.dll");
+        if (hntdll) {
+            typedef const char* (*wine_get_version)();
+            wine_get_version wine_get_version_func = (wine_get_version)GetProcAddress(hntdll, "wine_get_version");
+            if (wine_get_version_func) {
+                LOG_INFO("Running under Wine: %s", wine_get_version_func());
+                return true;
+            }
+        }
+#endif
+        return false;
+    }
+
+    // 创建目录的跨平台函数
+    bool create_directory(const std::string& path) {
+#ifdef _WIN32
+        return _mkdir(path.c_str()) == 0 || errno == EEXIST;
+#else
+        return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+    }
+
+#ifndef _WIN32
+    // 刚创建的对象大小为 0，确保它至少能容纳头部（hugetlbfs 上为一个大页），返回对象大小
+    static uint64_t ensure_header(int fd, bool create, int timeout_ms, size_t header_length) {
+        if (create) {
+            // posix_fallocate 只扩展不截断，并发创建时不会缩小其他进程已扩展的对象
+            int result = posix_fallocate(fd, 0, header_length);
+            struct stat st;
+            if ((result != 0 && result != EOPNOTSUPP && result != EINVAL) || fstat(fd, &st) == -1 ||
+                (static_cast<size_t>(st.st_size) < header_length &&
+                 ftruncate(fd, header_length) == -1)) {
+                LOG_ERROR("Failed to set shared memory size, error: %s", strerror(result ? result : errno));
+                throw std::runtime_error("Failed to set shared memory size");
+            }
+            return std::max<uint64_t>(st.st_size, header_length);
+        }
+
+        // 创建者可能刚调用 shm_open 还未扩展，短暂等待
+        auto deadline = std::chrono::steady_clock::now() +
+            std::chrono::milliseconds(timeout_ms < 0 ? 1000 : timeout_ms);
+        for (;;) {
+            struct stat st;
+            if (fstat(fd, &st) == -1) {
+                LOG_ERROR("Failed to stat shared memory, error: %s", strerror(errno));
+                throw std::runtime_error("Failed to stat shared memory");
+            }
+            // 共享内存对象至少要容纳头部（旧版为 16 字节），否则读取头部会 SIGBUS
+            if (static_cast<uint64_t>(st.st_size) >= sizeof(LegacyHeader)) {
+                return static_cast<uint64_t>(st.st_size);
+            }
+            if (std::chrono::steady_clock::now() >= deadline) {
+                LOG_ERROR("Shared memory object is smaller than its header");
+                throw std::runtime_error("Shared memory object is smaller than its header");
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+#endif
+
+    // 新建时请求的变更跟踪块大小，不在 4 KiB–64 KiB 或不是 2 的幂时抛出 std::invalid_argument
+    static size_t requested_dirty_block(bool create, const MapOptions& options) {
+        if (!create || options.dirty_block == 0) {
+            return 0;
+        }
+        if (!valid_dirty_block(options.dirty_block)) {
+            throw std::invalid_argument("Dirty block size must be a power of two between 4 KiB and 64 KiB");
+        }
+        return options.dirty_block;
+    }
+
+    // 初始化新建共享内存的头部，已是新版格式、数据区偏移和块大小不变时保留变更跟踪区
+    static void init_header(SharedMemoryHeader* header, size_t size, size_t data_offset, size_t dirty_block) {
+        // 在写入头部之前检查，放不下跟踪区时 setMemory 报错，不创建没有跟踪的共享内存
+        if (dirty_block && sizeof(SharedMemoryHeader) + dirty_tracker_bytes(size, dirty_block) > data_offset) {
+            LOG_ERROR("No room for dirty tracking: size=%zu, data_offset=%zu, block=%zu", size, data_offset, dirty_block);
+            throw std::runtime_error("Shared memory has no room for dirty tracking");
+        }
+        bool initialized = header->magic == HEADER_MAGIC;
+        if (!initialized) {
+            memset(static_cast<void*>(&header->rwlock), 0, sizeof(header->rwlock));
+        }
+        uint16_t flags = data_offset % PAGE_SIZE_BYTES == 0 ? HEADER_FLAG_PAGE_ALIGNED : 0;
+        DirtyTracker* tracker = reinterpret_cast<DirtyTracker*>(header + 1);
+        if (initialized && (header->flags & HEADER_FLAG_DIRTY_TRACKING) && header->data_offset == data_offset &&
+            (dirty_block == 0 || (size_t(1) << std::min<uint32_t>(tracker->block_shift, 63)) == dirty_block)) {
+            flags |= HEADER_FLAG_DIRTY_TRACKING;
+        }
+        else if (dirty_block) {
+            memset(static_cast<void*>(tracker), 0, dirty_tracker_bytes(size, dirty_block));
+            while ((size_t(1) << tracker->block_shift) < dirty_block) {
+                tracker->block_shift++;
+            }
+            tracker->blocks = (size + dirty_block - 1) / dirty_block;
+            tracker->epoch.store(1, std::memory_order_relaxed);
+            flags |= HEADER_FLAG_DIRTY_TRACKING;
+        }
+        header->format_version = HEADER_FORMAT_VERSION;
+        header->flags = flags;
+#ifdef _WIN32
+        header->owner_pid = static_cast<uint32_t>(GetCurrentProcessId());
+#else
+        header->owner_pid = static_cast<uint32_t>(getpid());
+#endif
+        header->pid_namespace = pid_namespace();
+        header->data_offset = data_offset;
+        header->size = size;
+        // 版本号作为顺序锁使用，偶数表示没有写入在进行
+        uint32_t version = header->version.load(std::memory_order_relaxed);
+        header->writer_pid.store(0, std::memory_order_relaxed);
+        header->version.store((version + 1) & ~1u, std::memory_order_release);
+        // 重新创建时大小可能变化，推进代数通知已映射的读者
+        header->generation.fetch_add(1, std::memory_order_release);
+        // 魔数最后写入，打开者看到魔数时其余字段已就绪
+        std::atomic_thread_fence(std::memory_order_release);
+        header->magic = HEADER_MAGIC;
+        LOG_DEBUG("Initialized shared memory header: size=%zu, data_offset=%zu, version=%u",
+            size, data_offset, header->version.load());
+    }
+
+    SharedMemoryManager::SharedMemoryManager(const std::string& key, bool create, size_t size, int timeout_ms,
+                                             const MapOptions& options) 
+        : key_(key), size_(size), data_offset_(data_offset_for(size, requested_dirty_block(create, options))),
+          legacy_(false), huge_page_size_(0), backend_(Backend::Named), mode_(create ? MapMode::ReadWrite : options.mode),
+          backing_fd_(-1), dirty_block_(requested_dirty_block(create, options)), reused_length_(0), mapped_bytes_(0), address_(nullptr), generation_(0), owner_slot_(-1), attached_(false)
+#ifdef _WIN32
+        , file_mapping_(nullptr), mutex_(nullptr)
+#endif
+    {
+        // 计算实际需要分配的大小（包括头部）
+        size_t total_size = data_offset_ + size;
+        LOG_DEBUG("Size of header: %zu", data_offset_);
+        LOG_DEBUG("Size of header + size: %zu", total_size);
+        
+#ifdef _WIN32
+        // Windows实现
+        // 创建互斥锁名称
+        std::string mutex_name = "Global\\SharedMemoryMutex_" + key;
+        
+        // 检查是否在Wine环境下运行
+        bool is_wine = is_running_under_wine();
+        
+        std::string file_path;
+        
+        if (is_wine) {
+            // Wine环境下使用/dev/shm目录
+            file_path = "/dev/shm/skyline_" + key + ".dat";
+            LOG_DEBUG("Using Wine shared memory path: %s", file_path.c_str());
+            
+            // 确保/dev/shm目录存在
+            // 在Wine环境下，这个目录应该已经存在，但为了安全起见，我们检查一下
+            struct stat st;
+            if (stat("/dev/shm", &st) != 0) {
+                LOG_WARN("Warning: /dev/shm directory does not exist in Wine environment");
+            }
+        } else {
+            // 原生Windows环境下使用用户目录
+            // 获取用户目录
+            char user_path[MAX_PATH];
+            if (SUCCEEDED(SHGetFolderPathA(NULL, CSIDL_PERSONAL, NULL, 0, user_path))) {
+                LOG_DEBUG("User path: %s", user_path);
+            } else {
+                // 如果获取用户目录失败，使用当前目录
+                GetCurrentDirectoryA(MAX_PATH, user_path);
+                LOG_DEBUG("Using current directory: %s", user_path);
+            }
+            
+            // 创建文件路径
+            std::string shared_memory_dir = std::string(user_path) + "\\SharedMemory";
+            file_path = shared_memory_dir + "\\skyline_" + key + ".dat";
+            
+            // 确保目录存在
+            create_directory(shared_memory_dir);
+        }
+        
+        // 创建或打开互斥锁
+        mutex_ = CreateMutexA(NULL, FALSE, mutex_name.c_str());
+        if (!mutex_) {
+            DWORD error = GetLastError();
+            LOG_ERROR("Failed to create mutex, error code: %lu", error);
+            throw std::runtime_error("Failed to create mutex");
+        }
+        
+        // 获取互斥锁
+        // 未指定超时时保持原有的 5 秒上限
+        DWORD wait_ms = timeout_ms < 0 ? 5000 : static_cast<DWORD>(timeout_ms);
+        // 持有者退出时返回 WAIT_ABANDONED，互斥锁已归当前线程所有
+        DWORD wait_result = WaitForSingleObject(mutex_, wait_ms);
+        if (wait_result == WAIT_ABANDONED) {
+            LOG_WARN("Previous mutex owner died, recovering");
+        }
+        else if (wait_result != WAIT_OBJECT_0) {
+            DWORD error = GetLastError();
+            LOG_ERROR("Failed to acquire mutex, error code: %lu", error);
+            CloseHandle(mutex_);
+            mutex_ = nullptr;
+            throw std::runtime_error(wait_result == WAIT_TIMEOUT ? "Timed out acquiring mutex" : "Failed to acquire mutex");
+        }
+        
+        try {
+            // 创建或打开文件
+            HANDLE file_handle = INVALID_HANDLE_VALUE;
+            if (create) {
+                // 创建新文件
+                file_handle = CreateFileA(
+                    file_path.c_str(),
+                    GENERIC_READ | GENERIC_WRITE,
+                    FILE_SHARE_READ | FILE_SHARE_WRITE,  // 允许其他进程读写
+                    NULL,
+                    CREATE_ALWAYS,
+                    FILE_ATTRIBUTE_NORMAL,
+                    NULL
+                );
+                
+                if (file_handle == INVALID_HANDLE_VALUE) {
+                    DWORD error = GetLastError();
+                    LOG_ERROR("Failed to create file, error code: %lu", error);
+                    ReleaseMutex(mutex_);
+                    CloseHandle(mutex_);
+                    mutex_ = nullptr;
+                    throw std::runtime_error("Failed to create file");
+                }
+                
+                // 设置文件大小
+                LARGE_INTEGER file_size;
+                file_size.QuadPart = total_size;
+                if (!SetFilePointerEx(file_handle, file_size, NULL, FILE_BEGIN) || 
+                    !SetEndOfFile(file_handle)) {
+                    DWORD error = GetLastError();
+                    LOG_ERROR("Failed to set file size, error code: %lu", error);
+                    CloseHandle(file_handle);
+                    ReleaseMutex(mutex_);
+                    CloseHandle(mutex_);
+                    mutex_ = nullptr;
+                    throw std::runtime_error("Failed to set file size");
+                }
+            } else {
+                // 打开现有文件
+                file_handle = CreateFileA(
+                    file_path.c_str(),
+                    GENERIC_READ | GENERIC_WRITE,
+                    FILE_SHARE_READ | FILE_SHARE_WRITE,  // 允许其他进程读写
+                    NULL,
+                    OPEN_EXISTING,
+                    FILE_ATTRIBUTE_NORMAL,
+                    NULL
+                );
+                
+                if (file_handle == INVALID_HANDLE_VALUE) {
+                    DWORD error = GetLastError();
+                    LOG_ERROR("Failed to open file, error code: %lu", error);
+                    ReleaseMutex(mutex_);
+                    CloseHandle(mutex_);
+                    mutex_ = nullptr;
+                    throw std::runtime_error("Failed to open file");
+                }
+            }
+            
+            // 打开时先按文件实际大小映射，读取头部后再按头部记录的大小映射
+            if (!create) {
+                LARGE_INTEGER file_size;
+                if (!GetFileSizeEx(file_handle, &file_size) ||
+                    static_cast<uint64_t>(file_size.QuadPart) < sizeof(LegacyHeader)) {
+                    CloseHandle(file_handle);
+                    throw std::runtime_error("Shared memory object is smaller than its header");
+                }
+                total_size = static_cast<size_t>(file_size.QuadPart);
+            }
+            
+            // 创建映射
+            bool success = create_mapping(file_handle, total_size);
+            if (!success) {
+                CloseHandle(file_handle);
+                throw std::runtime_error("Failed to create mapping");
+            }
+            
+            // 如果是新创建的共享内存，初始化头部
+            if (create) {
+                init_header(static_cast<SharedMemoryHeader*>(address_), size, data_offset_, dirty_block_);
+            }
+            else {
+                // 读取头部信息，旧版头部的数据区紧跟在第 16 字节之后
+                if (is_legacy_header(address_, total_size)) {
+                    size = static_cast<size_t>(static_cast<LegacyHeader*>(address_)->size);
+                    data_offset_ = sizeof(LegacyHeader);
+                    legacy_ = true;
+                    LOG_INFO("Opening legacy shared memory: key=%s, size=%zu", key.c_str(), size);
+                }
+                else {
+                    SharedMemoryHeader* header = static_cast<SharedMemoryHeader*>(address_);
+                    if (total_size < HEADER_BASE_SIZE || header->magic != HEADER_MAGIC ||
+                        header->format_version > HEADER_FORMAT_VERSION) {
+                        CloseHandle(file_handle);
+                        throw std::runtime_error("Shared memory header is not initialized");
+                    }
+                    size = static_cast<size_t>(header->size);
+                    data_offset_ = static_cast<size_t>(header->data_offset);
+                    if (data_offset_ < HEADER_BASE_SIZE || size > total_size - data_offset_) {
+                        CloseHandle(file_handle);
+                        throw std::runtime_error("Shared memory header size exceeds the backing object");
+                    }
+                }
+                size_ = size;
+                LOG_DEBUG("Read shared memory header: size=%zu, version=%u", size, version_word().load());
+                
+                // 以头部信息为基准，重新映射
+                success = create_mapping(file_handle, data_offset_ + size);
+                if (!success) {
+                    CloseHandle(file_handle);
+                    throw std::runtime_error("Failed to create mapping with header size");
+                }
+            }
+            
+            // 关闭文件句柄，文件映射会保持文件打开
+            CloseHandle(file_handle);
+            
+            generation_ = generation_word().load(std::memory_order_acquire);
+            
+            // 存储文件路径
+            file_path_ = file_path;
+            
+            LOG_DEBUG("Shared memory %s: key=%s, size=%zu, address=%p, file=%s", 
+                create ? "created" : "opened", 
+                key.c_str(), 
+                size, 
+                address_,
+                file_path_.c_str());
+                
+        } catch (...) {
+            // 确保在发生异常时释放资源
+            if (address_) {
+                UnmapViewOfFile(address_);
+                address_ = nullptr;
+            }
+            
+            if (file_mapping_) {
+                CloseHandle(file_mapping_);
+                file_mapping_ = nullptr;
+            }
+            
+            if (mutex_) {
+                ReleaseMutex(mutex_);
+                CloseHandle(mutex_);
+                mutex_ = nullptr;
+            }
+            
+            throw;
+        }
+        
+        // 释放互斥锁
+        ReleaseMutex(mutex_);
+#else
+        // Linux实现
+        // 创建共享内存名称
+        std::string shm_name = "/skyline_" + key + ".dat";
+        
+        // 创建或打开共享内存，显式大页时建在 hugetlbfs 上。
+        // 等待互斥锁期间名称被删除（removeMemory 或 gcMemory）时重新打开，新建时得到新的对象
+        for (int attempt = 0;; attempt++) {
+            LOG_DEBUG("Call shm_open");
+            int fd = open_backing(key, create, options.huge_pages == HugePages::Explicit, shm_name, huge_page_size_,
+                                  mode_ != MapMode::ReadWrite);
+            if (fd == -1) {
+                LOG_ERROR("Failed to open shared memory, error: %s", strerror(errno));
+                throw std::runtime_error("Failed to open shared memory");
+            }
+            
+            bool mapped;
+            try {
+                mapped = map_object(fd, create, size, timeout_ms);
+            } catch (...) {
+                close(fd);
+                throw;
+            }
+            close(fd);
+            if (mapped) {
+                break;
+            }
+            if (attempt + 1 >= REOPEN_ATTEMPTS) {
+                LOG_ERROR("Shared memory was removed while opening: key=%s", key.c_str());
+                throw std::runtime_error("Shared memory was removed while opening");
+            }
+            std::this_thread::yield();
+        }
+        
+        // 存储共享内存名称
+        file_path_ = shm_name;
+#endif
+        
+        attach(options);
+    }
+
+    SharedMemoryManager::SharedMemoryManager(int fd, const std::string& key, bool create, size_t size, int timeout_ms,
+                                             const MapOptions& options)
+        : key_(key), size_(size), data_offset_(data_offset_for(size, requested_dirty_block(create, options))),
+          legacy_(false), huge_page_size_(0), backend_(Backend::Named), mode_(create ? MapMode::ReadWrite : options.mode),
+          backing_fd_(-1), dirty_block_(requested_dirty_block(create, options)), reused_length_(0), mapped_bytes_(0), address_(nullptr), generation_(0), owner_slot_(-1), attached_(false)
+#ifdef _WIN32
+        , file_mapping_(nullptr), mutex_(nullptr)
+#endif
+    {
+#ifdef _WIN32
+        (void)fd;
+        (void)create;
+        (void)timeout_ms;
+        (void)options;
+        throw std::runtime_error("File descriptor backed shared memory is not supported on Windows");
+#else
+        try {
+            file_path_ = descriptor_path(fd);
+            // memfd 在 /proc/self/fd 中显示为 /memfd:<名称> (deleted)
+            if (file_path_.compare(0, 7, "/memfd:") == 0) {
+                backend_ = Backend::Memfd;
+            }
+            huge_page_size_ = descriptor_huge_page_size(fd);
+            if (!map_object(fd, create, size, timeout_ms)) {
+                throw std::runtime_error("Shared memory was removed while opening");
+            }
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+        backing_fd_ = fd;
+        attach(options);
+#endif
+    }
+
+    void SharedMemoryManager::attach(const MapOptions& options) {
+        attach_owner();
+        
+#ifdef _WIN32
+        // 文件映射句柄和互斥锁句柄
+        account_mapping(1, static_cast<int64_t>(data_offset_ + size_), 2);
+#else
+        // memfd 和传入的描述符在映射期间保留
+        account_mapping(1, static_cast<int64_t>(map_length(data_offset_ + size_)), backing_fd_ != -1 ? 1 : 0);
+#endif
+        
+        // 预取和锁定可能耗时较长，在释放互斥锁之后进行
+        apply_options(options);
+    }
+
+#ifndef _WIN32
+    bool SharedMemoryManager::map_object(int fd, bool create, size_t size, int timeout_ms) {
+        size_t total_size = data_offset_ + size;
+
+        // 封印了写入的对象不能以可写方式共享映射，内容也不会再变化；不支持封印的对象返回 -1
+        int seals = fcntl(fd, F_GET_SEALS);
+        if (!create && seals != -1 && (seals & F_SEAL_WRITE) && mode_ == MapMode::ReadWrite) {
+            mode_ = MapMode::ReadOnly;
+        }
+        if (!create && mode_ != MapMode::ReadWrite) {
+            map_detached(fd, timeout_ms);
+            return true;
+        }
+
+        // 互斥锁位于头部，先保证对象能容纳头部再单独映射头部
+        SharedMemoryHeader* lock_header_address = nullptr;
+        size_t header_length = map_length(sizeof(SharedMemoryHeader));
+        bool legacy_object = false;
+        try {
+            uint64_t object_size = ensure_header(fd, create, timeout_ms, header_length);
+            
+            LOG_DEBUG("Call mmap header.");
+            void* header_address = mmap(NULL, header_length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (header_address == MAP_FAILED) {
+                LOG_ERROR("Failed to map shared memory header, error: %s", strerror(errno));
+                throw std::runtime_error("Failed to map shared memory");
+            }
+            lock_header_address = static_cast<SharedMemoryHeader*>(header_address);
+            
+            legacy_object = is_legacy_header(lock_header_address, object_size);
+            if (legacy_object) {
+                if (!create) {
+                    // 旧版共享内存没有头部互斥锁，直接按 16 字节头部映射
+                    size = static_cast<LegacyHeader*>(header_address)->size;
+                    LOG_INFO("Opening legacy shared memory: key=%s, size=%zu", key_.c_str(), size);
+                    munmap(lock_header_address, header_length);
+                    lock_header_address = nullptr;
+                    
+                    total_size = sizeof(LegacyHeader) + size;
+                    address_ = mmap(NULL, map_length(total_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                    if (address_ == MAP_FAILED) {
+                        address_ = nullptr;
+                        LOG_ERROR("Failed to map shared memory, error: %s", strerror(errno));
+                        throw std::runtime_error("Failed to map shared memory");
+                    }
+                    size_ = size;
+                    data_offset_ = sizeof(LegacyHeader);
+                    legacy_ = true;
+                    generation_ = generation_word().load(std::memory_order_acquire);
+                    return true;
+                }
+                // 以新版格式重新创建旧版共享内存，旧数据中的锁状态和统计无效
+                lock_header_address->lock_state.store(0, std::memory_order_relaxed);
+                memset(static_cast<void*>(&lock_header_address->stats), 0, sizeof(lock_header_address->stats));
+                memset(static_cast<void*>(&lock_header_address->owners), 0, sizeof(lock_header_address->owners));
+            }
+            
+            // 获取互斥锁，无竞争时只在用户态完成；本线程持有同名互斥锁时等待会自锁
+            ensure_lock_not_held();
+            init_header_lock(lock_header_address, timeout_ms);
+            LockResult lock_result = lock_header(lock_header_address, timeout_ms);
+            if (lock_result == LockResult::Busy) {
+                LOG_ERROR("Timed out acquiring mutex: key=%s", key_.c_str());
+                throw std::runtime_error("Timed out acquiring mutex");
+            }
+        } catch (...) {
+            if (lock_header_address) {
+                munmap(lock_header_address, header_length);
+            }
+            throw;
+        }
+        
+        try {
+            // 删除者在锁内标记 removed 后才删除名称，拿到锁时已标记说明这个对象已没有名称
+            if (!legacy_object && lock_header_address->magic == HEADER_MAGIC &&
+                lock_header_address->format_version >= 3 &&
+                lock_header_address->data_offset >= sizeof(SharedMemoryHeader) &&
+                lock_header_address->owners.removed.load(std::memory_order_acquire)) {
+                LOG_DEBUG("Shared memory was removed while waiting for the mutex: key=%s", key_.c_str());
+                unlock_header(lock_header_address);
+                munmap(lock_header_address, header_length);
+                return false;
+            }
+            
+            struct stat st;
+            if (fstat(fd, &st) == -1) {
+                LOG_ERROR("Failed to stat shared memory, error: %s", strerror(errno));
+                throw std::runtime_error("Failed to stat shared memory");
+            }
+            
+            if (create) {
+                // 重新创建时按新的大小和选项重新计算数据区偏移，偏移变化时推进的代数让已映射的进程在 refresh 中按新偏移重新映射
+                bool initialized = lock_header_address->magic == HEADER_MAGIC;
+                data_offset_ = data_offset_for(size, dirty_block_);
+                total_size = data_offset_ + size;
+                
+                // 设置共享内存大小，只扩大不缩小，避免已映射的读者访问被截断的页面（SIGBUS）
+                // tmpfs 上的 ftruncate 不预留空间，容量不足时要到访问页面才会 SIGBUS，这里提前检查
+                size_t existing_size = static_cast<size_t>(st.st_size);
+                struct statvfs vfs;
+                // 未设置 size= 的 hugetlbfs 不报告容量（f_blocks 为 0），大页不足时由 ftruncate/mmap 报错
+                if (existing_size < total_size && fstatvfs(fd, &vfs) == 0 && vfs.f_blocks != 0 &&
+                    static_cast<uint64_t>(vfs.f_bavail) * vfs.f_frsize < total_size - existing_size) {
+                    LOG_ERROR("Not enough space for shared memory: required=%zu, available=%llu",
+                        total_size - existing_size,
+                        static_cast<unsigned long long>(vfs.f_bavail) * vfs.f_frsize);
+                    throw std::runtime_error("Not enough space in the shared memory backing store");
+                }
+                
+                if (existing_size < total_size && ftruncate(fd, map_length(total_size)) == -1) {
+                    LOG_ERROR("Failed to set shared memory size, error: %s", strerror(errno));
+                    throw std::runtime_error("Failed to set shared memory size");
+                }
+                
+                // 新对象和扩展出的部分由系统清零，只有重新创建时沿用的旧内容需要调用方清零
+                if ((initialized || legacy_object) && existing_size > data_offset_) {
+                    reused_length_ = std::min(size, existing_size - data_offset_);
+                }
+            }
+            else {
+                // 创建者持有互斥锁直到头部写完，拿到锁后仍无魔数说明创建尚未开始或已失败
+                if (lock_header_address->magic != HEADER_MAGIC) {
+                    LOG_ERROR("Shared memory header is not initialized: key=%s", key_.c_str());
+                    throw std::runtime_error("Shared memory header is not initialized");
+                }
+                if (lock_header_address->format_version > HEADER_FORMAT_VERSION) {
+                    LOG_ERROR("Unsupported header format version: %u", lock_header_address->format_version);
+                    throw std::runtime_error("Unsupported shared memory header format version");
+                }
+                
+                // 读取头部信息
+                size = static_cast<size_t>(lock_header_address->size);
+                size_ = size;
+                data_offset_ = static_cast<size_t>(lock_header_address->data_offset);
+                LOG_DEBUG("Read shared memory header: size=%zu, version=%u", size, lock_header_address->version.load());
+                
+                // 头部记录的大小必须落在共享内存对象之内，否则访问末尾会 SIGBUS
+                if (data_offset_ < HEADER_BASE_SIZE || data_offset_ % CACHE_LINE_SIZE != 0 ||
+                    size > SIZE_MAX - data_offset_ ||
+                    static_cast<uint64_t>(st.st_size) < data_offset_ + size) {
+                    LOG_ERROR("Shared memory header size exceeds the backing object: size=%zu", size);
+                    throw std::runtime_error("Shared memory header size exceeds the backing object");
+                }
+                total_size = data_offset_ + size;
+            }
+            
+            // 映射共享内存
+            LOG_DEBUG("Call mmap.");
+            address_ = mmap(NULL, map_length(total_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (address_ == MAP_FAILED) {
+                address_ = nullptr;
+                LOG_ERROR("Failed to map shared memory, error: %s", strerror(errno));
+                throw std::runtime_error("Failed to map shared memory");
+            }
+            
+            // 如果是新创建的共享内存，初始化头部
+            if (create) {
+                init_header(static_cast<SharedMemoryHeader*>(address_), size, data_offset_, dirty_block_);
+            }
+            
+            generation_ = generation_word().load(std::memory_order_acquire);
+            
+            // 在锁内登记附加，回收者在锁内重新检查时能看到
+            attach_owner();
+            
+            LOG_DEBUG("Shared memory %s: key=%s, size=%zu, address=%p", 
+                create ? "created" : "opened", 
+                key_.c_str(), 
+                size, 
+                address_);
+                
+        } catch (...) {
+            // 确保在发生异常时释放资源
+            if (address_) {
+                munmap(address_, map_length(total_size));
+                address_ = nullptr;
+            }
+            unlock_header(lock_header_address);
+            munmap(lock_header_address, header_length);
+            throw;
+        }
+        
+        // 释放互斥锁
+        unlock_header(lock_header_address);
+        munmap(lock_header_address, header_length);
+        return true;
+    }
+
+    void* SharedMemoryManager::map_view(int fd, size_t length) const {
+        int protection = mode_ == MapMode::ReadOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+        return mmap(NULL, length, protection, mode_ == MapMode::Private ? MAP_PRIVATE : MAP_SHARED, fd, 0);
+    }
+
+    void SharedMemoryManager::map_detached(int fd, int timeout_ms) {
+        uint64_t object_size = ensure_header(fd, false, timeout_ms, 0);
+        size_t header_length = static_cast<size_t>(std::min<uint64_t>(object_size, map_length(sizeof(SharedMemoryHeader))));
+        void* header_address = mmap(NULL, header_length, PROT_READ, MAP_SHARED, fd, 0);
+        if (header_address == MAP_FAILED) {
+            LOG_ERROR("Failed to map shared memory header, error: %s", strerror(errno));
+            throw std::runtime_error("Failed to map shared memory");
+        }
+        const SharedMemoryHeader* header = static_cast<const SharedMemoryHeader*>(header_address);
+        if (is_legacy_header(header_address, object_size)) {
+            size_ = static_cast<size_t>(static_cast<const LegacyHeader*>(header_address)->size);
+            data_offset_ = sizeof(LegacyHeader);
+            legacy_ = true;
+        }
+        else if (header_length < HEADER_BASE_SIZE || header->magic != HEADER_MAGIC) {
+            // 不获取互斥锁，创建者写入魔数之前的头部不可用
+            munmap(header_address, header_length);
+            throw std::runtime_error("Shared memory header is not initialized");
+        }
+        else {
+            // 魔数最后写入，看到魔数后其余字段已就绪
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (header->format_version > HEADER_FORMAT_VERSION || header->data_offset < HEADER_BASE_SIZE ||
+                header->data_offset % CACHE_LINE_SIZE != 0 ||
+                header->size > object_size - std::min<uint64_t>(object_size, header->data_offset)) {
+                munmap(header_address, header_length);
+                throw std::runtime_error("Shared memory header size exceeds the backing object");
+            }
+            size_ = static_cast<size_t>(header->size);
+            data_offset_ = static_cast<size_t>(header->data_offset);
+        }
+        munmap(header_address, header_length);
+
+        // 经读写描述符建立的只读共享映射仍计为可写映射，会妨碍 memfd 封印写入，改用只读描述符
+        int view_fd = fd;
+        if (mode_ == MapMode::ReadOnly && (fcntl(fd, F_GETFL) & O_ACCMODE) != O_RDONLY) {
+            view_fd = reopen_descriptor(fd, true);
+            if (view_fd == -1) {
+                view_fd = fd;
+            }
+        }
+        address_ = map_view(view_fd, map_length(data_offset_ + size_));
+        int error = errno;
+        if (view_fd != fd) {
+            close(view_fd);
+        }
+        if (address_ == MAP_FAILED) {
+            address_ = nullptr;
+            LOG_ERROR("Failed to map shared memory, error: %s", strerror(error));
+            throw std::runtime_error("Failed to map shared memory");
+        }
+        generation_ = generation_word().load(std::memory_order_acquire);
+        LOG_DEBUG("Mapped shared memory %s: key=%s, size=%zu", map_mode_name(mode_), key_.c_str(), size_);
+    }
+#endif
+    
+    SharedMemoryManager::~SharedMemoryManager() {
+        LOG_DEBUG("Destroying shared memory manager: key=%s, file=%s", 
+            key_.c_str(), 
+            file_path_.c_str());
+        if (address_) {
+            detach_owner();
+#ifdef _WIN32
+            account_mapping(-1, -static_cast<int64_t>(mapped_bytes_), -static_cast<int64_t>(2 + retired_.size()));
+#else
+            account_mapping(-1, -static_cast<int64_t>(mapped_bytes_), backing_fd_ != -1 ? -1 : 0);
+#endif
+        }
+        
+#ifdef _WIN32
+        // Windows实现
+        // 释放资源
+        for (const auto& retired : retired_) {
+            UnmapViewOfFile(retired.address);
+            CloseHandle(retired.mapping);
+        }
+        retired_.clear();
+        
+        if (address_) {
+            UnmapViewOfFile(address_);
+            address_ = nullptr;
+        }
+        
+        if (file_mapping_) {
+            CloseHandle(file_mapping_);
+            file_mapping_ = nullptr;
+        }
+        
+        if (mutex_) {
+            ReleaseMutex(mutex_);
+            CloseHandle(mutex_);
+            mutex_ = nullptr;
+        }
+#else
+        // Linux实现
+        // 释放资源
+        for (const auto& retired : retired_) {
+            munmap(retired.address, retired.length);
+        }
+        retired_.clear();
+        
+        if (address_ && address_ != MAP_FAILED) {
+            munmap(address_, map_length(data_offset_ + size_));
+            address_ = nullptr;
+        }
+        
+        if (backing_fd_ != -1) {
+            close(backing_fd_);
+            backing_fd_ = -1;
+        }
+#endif
+        
+        LOG_DEBUG("Shared memory manager destroyed: key=%s, file=%s", 
+            key_.c_str(), 
+            file_path_.c_str());
+    }
+
+    #ifdef _WIN32
+    DWORD page_protection(MapMode mode) {
+        return mode == MapMode::ReadOnly ? PAGE_READONLY : mode == MapMode::Private ? PAGE_WRITECOPY : PAGE_READWRITE;
+    }
+
+    DWORD view_access(MapMode mode) {
+        return mode == MapMode::ReadOnly ? FILE_MAP_READ : mode == MapMode::Private ? FILE_MAP_COPY : FILE_MAP_ALL_ACCESS;
+    }
+
+    bool SharedMemoryManager::create_mapping(HANDLE file_handle, size_t mapping_size) {
+        // 如果已存在映射，先清理
+        if (file_mapping_) {
+            CloseHandle(file_mapping_);
+            file_mapping_ = nullptr;
+        }
+        if (address_) {
+            UnmapViewOfFile(address_);
+            address_ = nullptr;
+        }
+        
+        // 创建文件映射
+        file_mapping_ = CreateFileMappingA(
+            file_handle,          // 使用实际文件
+            NULL,                 // 默认安全属性
+            page_protection(mode_),  // 读写、只读或写时复制
+            static_cast<DWORD>(static_cast<uint64_t>(mapping_size) >> 32),  // 最大大小的高32位
+            static_cast<DWORD>(mapping_size & 0xffffffff),                 // 最大大小的低32位
+            NULL                  // 不使用命名映射
+        );
+        
+        if (!file_mapping_) {
+            DWORD error = GetLastError();
+            LOG_ERROR("Failed to create file mapping, error code: %lu, size: %zu", error, mapping_size);
+            return false;
+        }
+        
+        // 映射视图
+        address_ = MapViewOfFile(
+            file_mapping_,
+            view_access(mode_),
+            0,
+            0,
+            mapping_size
+        );
+        
+        if (!address_) {
+            DWORD error = GetLastError();
+            LOG_ERROR("Failed to map view of file, error code: %lu, size: %zu", error, mapping_size);
+            CloseHandle(file_mapping_);
+            file_mapping_ = nullptr;
+            return false;
+        }
+        
+        return true;
+    }
+    #endif
+
+} 
\ No newline at end of file
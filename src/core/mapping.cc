@@ -0,0 +1,320 @@
+#include "shared_memory.hh"
+#include "logging.hh"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <climits>
+#include <sys/mman.h>
+#include <sys/vfs.h>
+#endif
+
+namespace SharedMemory {
+    const char* huge_pages_name(HugePages mode) {
+        switch (mode) {
+            case HugePages::Transparent: return "transparent";
+            case HugePages::Explicit: return "explicit";
+            default: return "none";
+        }
+    }
+
+    const char* map_mode_name(MapMode mode) {
+        switch (mode) {
+            case MapMode::ReadOnly: return "readonly";
+            case MapMode::Private: return "private";
+            default: return "readwrite";
+        }
+    }
+
+    bool parse_map_mode(const std::string& name, MapMode& mode) {
+        if (name == "readwrite") {
+            mode = MapMode::ReadWrite;
+        } else if (name == "readonly") {
+            mode = MapMode::ReadOnly;
+        } else if (name == "private") {
+            mode = MapMode::Private;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    bool parse_huge_pages(const std::string& name, HugePages& mode) {
+        if (name == "none") {
+            mode = HugePages::None;
+        } else if (name == "transparent") {
+            mode = HugePages::Transparent;
+        } else if (name == "explicit") {
+            mode = HugePages::Explicit;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+#ifndef _WIN32
+    static const long HUGETLBFS_MAGIC_NUMBER = 0x958458f6;
+
+    // 挂载表中的一项
+    struct MountEntry {
+        std::string dir;
+        std::string type;
+        std::string options;
+    };
+
+    // 查找第一个满足条件的挂载点
+    template <typename Predicate>
+    static bool find_mount(Predicate match, MountEntry& entry) {
+        std::ifstream mounts("/proc/mounts");
+        std::string line;
+        while (std::getline(mounts, line)) {
+            std::istringstream fields(line);
+            std::string device;
+            if ((fields >> device >> entry.dir >> entry.type >> entry.options) && match(entry)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::string hugetlbfs_mount(size_t& huge_page_size) {
+        MountEntry entry;
+        if (!find_mount([](const MountEntry& e) { return e.type == "hugetlbfs"; }, entry)) {
+            return std::string();
+        }
+        struct statfs fs;
+        if (statfs(entry.dir.c_str(), &fs) != 0 || fs.f_type != HUGETLBFS_MAGIC_NUMBER) {
+            return std::string();
+        }
+        huge_page_size = static_cast<size_t>(fs.f_bsize);
+        return entry.dir;
+    }
+
+    // /dev/shm 上的透明大页由挂载选项 huge= 决定，sysfs 中的 force/deny 可覆盖挂载选项
+    static bool shmem_transparent_huge_pages() {
+        std::ifstream sysfs("/sys/kernel/mm/transparent_hugepage/shmem_enabled");
+        std::string policy;
+        std::getline(sysfs, policy);
+        if (policy.find("[force]") != std::string::npos) {
+            return true;
+        }
+        if (policy.empty() || policy.find("[deny]") != std::string::npos) {
+            return false;
+        }
+        MountEntry entry;
+        if (!find_mount([](const MountEntry& e) { return e.dir == "/dev/shm"; }, entry)) {
+            return false;
+        }
+        return entry.options.find("huge=always") != std::string::npos ||
+               entry.options.find("huge=within_size") != std::string::npos ||
+               entry.options.find("huge=advise") != std::string::npos;
+    }
+
+    int open_backing(const std::string& key, bool create, bool explicit_huge, std::string& path, size_t& huge_page_size,
+                     bool read_only) {
+        std::string shm_name = "/skyline_" + key + ".dat";
+        int access = read_only ? O_RDONLY : O_RDWR;
+        huge_page_size = 0;
+
+        // 已存在的对象优先，重新创建时不改变存储位置，已映射的进程不受影响
+        path = shm_name;
+        int fd = shm_open(shm_name.c_str(), access, 0644);
+        if (fd != -1 || errno != ENOENT) {
+            return fd;
+        }
+        size_t mount_page_size = 0;
+        std::string mount = hugetlbfs_mount(mount_page_size);
+        std::string huge_path = mount.empty() ? std::string() : mount + "/skyline_" + key + ".dat";
+        if (!huge_path.empty()) {
+            fd = open(huge_path.c_str(), access);
+            if (fd != -1 || errno != ENOENT) {
+                path = huge_path;
+                huge_page_size = mount_page_size;
+                return fd;
+            }
+        }
+        if (!create || read_only) {
+            errno = ENOENT;
+            return -1;
+        }
+
+        if (explicit_huge && !huge_path.empty()) {
+            fd = open(huge_path.c_str(), O_RDWR | O_CREAT, 0644);
+            if (fd != -1) {
+                path = huge_path;
+                huge_page_size = mount_page_size;
+                return fd;
+            }
+            LOG_WARN("Failed to create %s on hugetlbfs, error: %s", huge_path.c_str(), strerror(errno));
+        }
+        if (explicit_huge) {
+            LOG_WARN("Explicit huge pages are not available for %s, falling back to regular shared memory", key.c_str());
+        }
+        return shm_open(shm_name.c_str(), O_RDWR | O_CREAT, 0644);
+    }
+
+    int reopen_backing(const std::string& path, size_t huge_page_size, bool read_only) {
+        int access = read_only ? O_RDONLY : O_RDWR;
+        return huge_page_size ? open(path.c_str(), access) : shm_open(path.c_str(), access, 0644);
+    }
+
+    std::string descriptor_path(int fd) {
+        char link[PATH_MAX];
+        ssize_t length = readlink(("/proc/self/fd/" + std::to_string(fd)).c_str(), link, sizeof(link) - 1);
+        return length > 0 ? std::string(link, static_cast<size_t>(length)) : std::string();
+    }
+
+    int reopen_descriptor(int fd, bool read_only) {
+        if (!read_only) {
+            return fcntl(fd, F_DUPFD_CLOEXEC, 0);
+        }
+        return open(("/proc/self/fd/" + std::to_string(fd)).c_str(), O_RDONLY | O_CLOEXEC);
+    }
+
+    size_t descriptor_huge_page_size(int fd) {
+        struct statfs fs;
+        if (fstatfs(fd, &fs) != 0 || fs.f_type != HUGETLBFS_MAGIC_NUMBER) {
+            return 0;
+        }
+        return static_cast<size_t>(fs.f_bsize);
+    }
+
+    // 预先建立页表；内核不支持 MADV_POPULATE_WRITE（5.14 之前）时逐页读取。
+    // 只读和私有映射只按读取预取，私有映射按写入预取会复制全部页面
+    static void populate_pages(void* address, size_t length, bool write) {
+#ifdef MADV_POPULATE_WRITE
+        if (madvise(address, length, write ? MADV_POPULATE_WRITE : MADV_POPULATE_READ) == 0) {
+            return;
+        }
+        LOG_DEBUG("MADV_POPULATE_%s failed (%s), touching pages", write ? "WRITE" : "READ", strerror(errno));
+#endif
+        volatile const uint8_t* bytes = static_cast<const uint8_t*>(address);
+        for (size_t i = 0; i < length; i += PAGE_SIZE_BYTES) {
+            (void)bytes[i];
+        }
+    }
+#else
+    static void populate_pages(void* address, size_t length, bool) {
+        volatile const uint8_t* bytes = static_cast<const uint8_t*>(address);
+        for (size_t i = 0; i < length; i += PAGE_SIZE_BYTES) {
+            (void)bytes[i];
+        }
+    }
+#endif
+
+    void SharedMemoryManager::apply_options(const MapOptions& options) {
+        // 缓存中的管理器由多个线程共用，同时应用选项时只有一个线程修改 requested_/mapping_
+        MappingLock mapping = lock_mapping();
+        if (!address_) {
+            return;
+        }
+        size_t length = map_length(data_offset_ + size_);
+
+        // 已请求过的选项不重复应用（失败的也不重试），每次 getMemory 都带选项时只有几次比较
+        if (options.huge_pages != HugePages::None && requested_.huge_pages == HugePages::None) {
+            requested_.huge_pages = options.huge_pages;
+#ifdef _WIN32
+            LOG_WARN("Huge pages are not supported for file-backed shared memory on Windows: key=%s", key_.c_str());
+#else
+            if (huge_page_size_) {
+                mapping_.huge_pages = HugePages::Explicit;
+            }
+            else {
+                if (options.huge_pages == HugePages::Explicit) {
+                    LOG_WARN("Shared memory %s is not on hugetlbfs, falling back to transparent huge pages", key_.c_str());
+                }
+                if (!shmem_transparent_huge_pages()) {
+                    LOG_WARN("Transparent huge pages are not enabled for /dev/shm (mount option huge=), using regular pages: key=%s",
+                        key_.c_str());
+                }
+                else if (madvise(address_, length, MADV_HUGEPAGE) != 0) {
+                    LOG_WARN("madvise(MADV_HUGEPAGE) failed: key=%s, error: %s", key_.c_str(), strerror(errno));
+                }
+                else {
+                    mapping_.huge_pages = HugePages::Transparent;
+                }
+            }
+#endif
+        }
+
+        if (options.populate && !requested_.populate) {
+            requested_.populate = true;
+            populate_pages(address_, length, mode_ == MapMode::ReadWrite);
+            mapping_.populate = true;
+        }
+
+        if (options.lock && !requested_.lock) {
+            requested_.lock = true;
+#ifdef _WIN32
+            bool locked = VirtualLock(address_, length) != 0;
+#else
+            bool locked = mlock(address_, length) == 0;
+#endif
+            if (locked) {
+                mapping_.lock = true;
+            }
+            else {
+#ifdef _WIN32
+                LOG_WARN("VirtualLock failed: key=%s, error code: %lu", key_.c_str(), GetLastError());
+#else
+                LOG_WARN("mlock failed (check RLIMIT_MEMLOCK): key=%s, error: %s", key_.c_str(), strerror(errno));
+#endif
+            }
+        }
+    }
+
+    void SharedMemoryManager::prefault(unsigned threads) {
+        // 只在锁内读取地址和长度：重新映射后旧映射移入 retired_，保留到管理器销毁，预取旧映射仍然安全；
+        // 预取期间不持有映射锁，JS 线程的 getMemory/refresh 不会等待整个预取
+        uint8_t* base;
+        size_t length;
+        bool write;
+        {
+            MappingLock mapping = lock_mapping();
+            if (!address_) {
+                return;
+            }
+            base = static_cast<uint8_t*>(address_);
+            length = map_length(data_offset_ + size_);
+            write = mode_ == MapMode::ReadWrite;
+        }
+        if (threads == 0) {
+            threads = std::max(1u, std::min(std::thread::hardware_concurrency(), 8u));
+        }
+        threads = std::min(threads, 64u);
+
+        // 按 2 MiB 切分，分块边界不会落在（透明）大页中间
+        const size_t unit = std::max<size_t>(huge_page_size_, 2 * 1024 * 1024);
+        size_t units = (length + unit - 1) / unit;
+        threads = static_cast<unsigned>(std::min<size_t>(threads, units));
+        size_t chunk = (units + threads - 1) / threads * unit;
+
+        std::vector<std::thread> workers;
+        for (unsigned i = 1; i < threads; i++) {
+            size_t begin = chunk * i;
+            if (begin >= length) {
+                break;
+            }
+            workers.emplace_back(populate_pages, base + begin, std::min(chunk, length - begin), write);
+        }
+        // 第一块在当前线程执行
+        populate_pages(base, std::min(chunk, length), write);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        LOG_DEBUG("Prefaulted shared memory: key=%s, length=%zu, threads=%u", key_.c_str(), length, threads);
+    }
+
+    void SharedMemoryManager::reapply_options() {
+        MappingLock mapping = lock_mapping();
+        MapOptions requested = requested_;
+        requested_ = MapOptions();
+        mapping_ = MapOptions();
+        apply_options(requested);
+    }
+}
@@ -0,0 +1,356 @@
+#include "shared_memory.hh"
+#include "logging.hh"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#endif
+
+namespace SharedMemory {
+    const char* backend_name(Backend backend) {
+        return backend == Backend::Memfd ? "memfd" : "shm";
+    }
+
+    bool parse_backend(const std::string& name, Backend& backend) {
+        if (name == "shm") {
+            backend = Backend::Named;
+        } else if (name == "memfd") {
+            backend = Backend::Memfd;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+#ifdef _WIN32
+    int SharedMemoryManager::export_fd() const {
+        throw std::runtime_error("File descriptor passing is not supported on Windows");
+    }
+
+    void SharedMemoryManager::seal(bool /*write*/) {
+        throw std::runtime_error("memfd is not supported on Windows");
+    }
+
+    uint32_t SharedMemoryManager::get_seals() const {
+        return 0;
+    }
+
+    std::shared_ptr<SharedMemoryManager> create_memfd(const std::string& /*key*/, size_t /*size*/, int /*timeout_ms*/,
+                                                      const MapOptions& /*options*/) {
+        throw std::runtime_error("memfd is not supported on Windows");
+    }
+
+    void create_socket_pair(int& /*first*/, int& /*second*/) {
+        throw std::runtime_error("Unix domain sockets are not supported on Windows");
+    }
+
+    void export_segment(int /*socket*/, const std::shared_ptr<SharedMemoryManager>& /*manager*/) {
+        throw std::runtime_error("File descriptor passing is not supported on Windows");
+    }
+
+    std::shared_ptr<SharedMemoryManager> import_segment(int /*socket*/, int /*timeout_ms*/, const MapOptions& /*options*/,
+                                                        const std::string& /*local_key*/) {
+        throw std::runtime_error("File descriptor passing is not supported on Windows");
+    }
+#else
+    // 消息中键名的最大长度，memfd 名称本身不超过 249 字节
+    static const size_t MAX_KEY_LENGTH = 4096;
+
+    // glibc 2.27 之前没有 memfd_create 包装函数
+    static int memfd(const std::string& name, unsigned int flags) {
+#ifdef SYS_memfd_create
+        return static_cast<int>(syscall(SYS_memfd_create, name.c_str(), flags));
+#else
+        errno = ENOSYS;
+        return -1;
+#endif
+    }
+
+    int SharedMemoryManager::export_fd() const {
+        int fd = backing_fd_ != -1 ? reopen_descriptor(backing_fd_, false) : reopen_backing(file_path_, huge_page_size_);
+        if (fd == -1) {
+            LOG_ERROR("Failed to duplicate shared memory descriptor: key=%s, error: %s", key_.c_str(), strerror(errno));
+            throw std::runtime_error("Failed to duplicate shared memory descriptor");
+        }
+        return fd;
+    }
+
+    // 以 MAP_FIXED 原地替换映射，地址不变，已返回的 ArrayBuffer 仍指向它
+    static bool protect_mapping(void* address, size_t length, int protection, int fd) {
+        return mmap(address, length, protection, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+    }
+
+    void SharedMemoryManager::seal(bool write) {
+        if (backend_ != Backend::Memfd || backing_fd_ == -1) {
+            throw std::invalid_argument("Only memfd-backed shared memory can be sealed");
+        }
+        int seals = F_SEAL_SHRINK;
+        // 封印写入前本进程的可写映射必须先改为只读，否则 F_ADD_SEALS 返回 EBUSY；
+        // 内容不再变化，头部中的锁和计数也随之冻结，同时禁止扩展
+        bool downgrade = write && mode_ == MapMode::ReadWrite;
+        // 改为只读后经仍存活的可写视图写入会触发 SIGSEGV，这些视图被回收之前拒绝封印
+        MappingLock mapping = lock_mapping();
+        if (downgrade && writable_views() > 0) {
+            LOG_ERROR("Shared memory still has writable views in this process: key=%s, views=%d", key_.c_str(),
+                writable_views());
+            throw std::runtime_error("Shared memory still has writable views in this process (EBUSY)");
+        }
+        if (write) {
+            seals |= F_SEAL_WRITE | F_SEAL_GROW;
+        }
+        if (downgrade) {
+            // 以读写方式打开的描述符建立的共享映射即使只读也计为可写（VM_MAYWRITE），须经只读描述符重新映射
+            int read_fd = reopen_descriptor(backing_fd_, true);
+            if (read_fd == -1) {
+                LOG_ERROR("Failed to reopen memfd read-only: key=%s, error: %s", key_.c_str(), strerror(errno));
+                throw std::runtime_error("Failed to reopen memfd read-only");
+            }
+            detach_owner();
+            bool protected_all = protect_mapping(address_, map_length(data_offset_ + size_), PROT_READ, read_fd);
+            for (const auto& retired : retired_) {
+                protected_all = protect_mapping(retired.address, retired.length, PROT_READ, read_fd) && protected_all;
+            }
+            close(read_fd);
+            if (!protected_all) {
+                LOG_ERROR("Failed to remap shared memory read-only: key=%s, error: %s", key_.c_str(), strerror(errno));
+                throw std::runtime_error("Failed to remap shared memory read-only");
+            }
+            mode_ = MapMode::ReadOnly;
+        }
+
+        if (fcntl(backing_fd_, F_ADD_SEALS, seals) == -1) {
+            int error = errno;
+            if (downgrade) {
+                // 恢复可写映射
+                protect_mapping(address_, map_length(data_offset_ + size_), PROT_READ | PROT_WRITE, backing_fd_);
+                for (const auto& retired : retired_) {
+                    protect_mapping(retired.address, retired.length, PROT_READ | PROT_WRITE, backing_fd_);
+                }
+                mode_ = MapMode::ReadWrite;
+                attach_owner();
+            }
+            LOG_ERROR("Failed to seal shared memory: key=%s, error: %s", key_.c_str(), strerror(error));
+            throw std::runtime_error(error == EBUSY ? "Shared memory is still mapped writable by another process" :
+                                                      "Failed to seal shared memory");
+        }
+        LOG_DEBUG("Sealed shared memory: key=%s, write=%d", key_.c_str(), write ? 1 : 0);
+    }
+
+    uint32_t SharedMemoryManager::get_seals() const {
+        int seals = backing_fd_ != -1 ? fcntl(backing_fd_, F_GET_SEALS) : -1;
+        if (seals == -1) {
+            return 0;
+        }
+        return ((seals & F_SEAL_SHRINK) ? SEAL_SHRINK : 0) |
+               ((seals & F_SEAL_GROW) ? SEAL_GROW : 0) |
+               ((seals & F_SEAL_WRITE) ? SEAL_WRITE : 0);
+    }
+
+    std::shared_ptr<SharedMemoryManager> create_memfd(const std::string& key, size_t size, int timeout_ms,
+                                                      const MapOptions& options) {
+        // 匿名对象不在 hugetlbfs 上，显式大页由 apply_options 降级为透明大页
+        int fd = memfd("skyline_" + key, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        if (fd == -1) {
+            LOG_ERROR("memfd_create failed: key=%s, error: %s", key.c_str(), strerror(errno));
+            throw std::runtime_error("Failed to create memfd shared memory");
+        }
+        return std::make_shared<SharedMemoryManager>(fd, key, true, size, timeout_ms, options);
+    }
+
+    void create_socket_pair(int& first, int& second) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) == -1) {
+            LOG_ERROR("socketpair failed, error: %s", strerror(errno));
+            throw std::runtime_error("Failed to create socket pair");
+        }
+        first = fds[0];
+        second = fds[1];
+    }
+
+    void export_segment(int socket, const std::shared_ptr<SharedMemoryManager>& manager) {
+        const std::string& key = manager->get_key();
+        if (key.size() > MAX_KEY_LENGTH) {
+            throw std::length_error("Key is too long to send");
+        }
+        int fd = manager->export_fd();
+
+        // 消息为 4 字节键名长度加键名，描述符随第一个字节发送
+        uint32_t length = static_cast<uint32_t>(key.size());
+        struct iovec parts[2];
+        parts[0].iov_base = &length;
+        parts[0].iov_len = sizeof(length);
+        parts[1].iov_base = const_cast<char*>(key.data());
+        parts[1].iov_len = key.size();
+
+        union {
+            char buffer[CMSG_SPACE(sizeof(int))];
+            struct cmsghdr align;
+        } control;
+        memset(&control, 0, sizeof(control));
+        struct msghdr message;
+        memset(&message, 0, sizeof(message));
+        message.msg_iov = parts;
+        message.msg_iovlen = 2;
+        message.msg_control = control.buffer;
+        message.msg_controllen = sizeof(control.buffer);
+        struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(header), &fd, sizeof(int));
+
+        ssize_t sent;
+        do {
+            sent = sendmsg(socket, &message, MSG_NOSIGNAL);
+        } while (sent == -1 && errno == EINTR);
+        int error = errno;
+        // 接收方持有自己的副本，本地副本可以关闭
+        close(fd);
+        if (sent != static_cast<ssize_t>(sizeof(length) + key.size())) {
+            LOG_ERROR("Failed to send shared memory descriptor: key=%s, error: %s", key.c_str(),
+                sent == -1 ? strerror(error) : "short write");
+            throw std::runtime_error("Failed to send shared memory descriptor");
+        }
+        LOG_DEBUG("Exported shared memory descriptor: key=%s", key.c_str());
+    }
+
+    // 等待套接字可读，超时抛出异常
+    static void wait_readable(int socket, int timeout_ms) {
+        struct pollfd target;
+        target.fd = socket;
+        target.events = POLLIN;
+        target.revents = 0;
+        int ready;
+        do {
+            ready = poll(&target, 1, timeout_ms < 0 ? -1 : timeout_ms);
+        } while (ready == -1 && errno == EINTR);
+        if (ready == 0) {
+            throw std::runtime_error("Timed out waiting for a shared memory descriptor");
+        }
+        if (ready == -1) {
+            LOG_ERROR("poll failed, error: %s", strerror(errno));
+            throw std::runtime_error("Failed to wait for a shared memory descriptor");
+        }
+    }
+
+    // 接收一段数据并取出随附的描述符（没有时为 -1）
+    static ssize_t receive_part(int socket, void* buffer, size_t length, int& fd) {
+        union {
+            char buffer[CMSG_SPACE(sizeof(int))];
+            struct cmsghdr align;
+        } control;
+        struct iovec part;
+        part.iov_base = buffer;
+        part.iov_len = length;
+        struct msghdr message;
+        memset(&message, 0, sizeof(message));
+        message.msg_iov = &part;
+        message.msg_iovlen = 1;
+        message.msg_control = control.buffer;
+        message.msg_controllen = sizeof(control.buffer);
+
+        ssize_t received;
+        do {
+            received = recvmsg(socket, &message, MSG_CMSG_CLOEXEC);
+        } while (received == -1 && errno == EINTR);
+        for (struct cmsghdr* header = CMSG_FIRSTHDR(&message); received >= 0 && header;
+             header = CMSG_NXTHDR(&message, header)) {
+            if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS &&
+                header->cmsg_len >= CMSG_LEN(sizeof(int))) {
+                memcpy(&fd, CMSG_DATA(header), sizeof(int));
+            }
+        }
+        return received;
+    }
+
+    // 接收 export_segment 发送的描述符和键名
+    static int receive_segment(int socket, int timeout_ms, std::string& key) {
+        int type = 0;
+        socklen_t type_length = sizeof(type);
+        if (getsockopt(socket, SOL_SOCKET, SO_TYPE, &type, &type_length) == -1) {
+            LOG_ERROR("Not a socket: %d, error: %s", socket, strerror(errno));
+            throw std::invalid_argument("Not a socket");
+        }
+
+        wait_readable(socket, timeout_ms);
+        int fd = -1;
+        char buffer[sizeof(uint32_t) + MAX_KEY_LENGTH];
+        // 流式套接字没有消息边界，先读长度再读键名；报文套接字一次读出整条消息
+        size_t first = type == SOCK_STREAM ? sizeof(uint32_t) : sizeof(buffer);
+        ssize_t received = receive_part(socket, buffer, first, fd);
+        try {
+            if (received == 0) {
+                throw std::runtime_error("Socket closed before a shared memory descriptor was received");
+            }
+            if (received == -1) {
+                LOG_ERROR("recvmsg failed, error: %s", strerror(errno));
+                throw std::runtime_error("Failed to receive shared memory descriptor");
+            }
+            if (fd == -1 || static_cast<size_t>(received) < sizeof(uint32_t)) {
+                throw std::runtime_error("Message does not carry a shared memory descriptor");
+            }
+            uint32_t length;
+            memcpy(&length, buffer, sizeof(length));
+            if (length > MAX_KEY_LENGTH) {
+                throw std::runtime_error("Received key is too long");
+            }
+            size_t total = sizeof(uint32_t) + length;
+            size_t offset = static_cast<size_t>(received);
+            while (type == SOCK_STREAM && offset < total) {
+                wait_readable(socket, timeout_ms);
+                int extra = -1;
+                ssize_t part = receive_part(socket, buffer + offset, total - offset, extra);
+                if (extra != -1) {
+                    close(extra);
+                }
+                if (part <= 0) {
+                    throw std::runtime_error("Socket closed while receiving a shared memory key");
+                }
+                offset += static_cast<size_t>(part);
+            }
+            if (offset != total) {
+                throw std::runtime_error("Truncated shared memory message");
+            }
+            key.assign(buffer + sizeof(uint32_t), length);
+        } catch (...) {
+            if (fd != -1) {
+                close(fd);
+            }
+            throw;
+        }
+        return fd;
+    }
+
+    std::shared_ptr<SharedMemoryManager> import_segment(int socket, int timeout_ms, const MapOptions& options,
+                                                        const std::string& local_key) {
+        // 指定了本地键名时先检查，消息留在套接字中
+        if (!local_key.empty() && manager_cached(local_key)) {
+            LOG_ERROR("Key is already mapped in this process: key=%s", local_key.c_str());
+            throw std::invalid_argument("Key is already mapped in this process");
+        }
+        std::string key;
+        int fd = receive_segment(socket, timeout_ms, key);
+        if (!local_key.empty()) {
+            key = local_key;
+        }
+        else if (manager_cached(key)) {
+            close(fd);
+            LOG_ERROR("Key is already mapped in this process: key=%s", key.c_str());
+            throw std::invalid_argument("Key is already mapped in this process, import it under another key");
+        }
+        auto manager = std::make_shared<SharedMemoryManager>(fd, key, false, 0, timeout_ms, options);
+        // 打开期间其他线程可能已映射同名共享内存，不覆盖
+        if (!cache_new_manager(key, manager)) {
+            LOG_ERROR("Key is already mapped in this process: key=%s", key.c_str());
+            throw std::invalid_argument("Key is already mapped in this process, import it under another key");
+        }
+        LOG_DEBUG("Imported shared memory descriptor: key=%s, size=%zu, read_only=%d", key.c_str(),
+            manager->get_size(), manager->is_read_only() ? 1 : 0);
+        return manager;
+    }
+#endif
+}
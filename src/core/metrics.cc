@@ -0,0 +1,122 @@
+#include "shared_memory.hh"
+
+namespace SharedMemory {
+    static_assert(sizeof(SharedMemoryHeader) <= PAGE_SIZE_BYTES, "header with statistics must fit in one page");
+
+    // 进程内的全局计数，只在映射建立、扩展和释放时更新
+    static std::atomic<uint64_t> process_mappings{0};
+    static std::atomic<uint64_t> process_mapped_bytes{0};
+    static std::atomic<uint64_t> process_handles{0};
+    static std::atomic<uint64_t> process_opens{0};
+    static std::atomic<uint64_t> process_closes{0};
+    static std::atomic<uint64_t> process_remaps{0};
+
+    size_t lock_wait_bucket(uint64_t ns) {
+        if (ns < LOCK_WAIT_SUB_BUCKETS) {
+            return static_cast<size_t>(ns);
+        }
+        if (ns >> LOCK_WAIT_MAX_EXPONENT) {
+            return LOCK_WAIT_BUCKETS - 1;
+        }
+        // 最高位决定区间，其后两位决定子桶
+        size_t exponent = 2;
+        while (ns >> (exponent + 1)) {
+            exponent++;
+        }
+        size_t sub = static_cast<size_t>(ns >> (exponent - 2)) & (LOCK_WAIT_SUB_BUCKETS - 1);
+        return (exponent - 1) * LOCK_WAIT_SUB_BUCKETS + sub;
+    }
+
+    uint64_t lock_wait_bucket_bound(size_t bucket) {
+        if (bucket < LOCK_WAIT_SUB_BUCKETS) {
+            return bucket + 1;
+        }
+        size_t exponent = bucket / LOCK_WAIT_SUB_BUCKETS + 1;
+        uint64_t sub = bucket % LOCK_WAIT_SUB_BUCKETS;
+        return (LOCK_WAIT_SUB_BUCKETS + sub + 1) << (exponent - 2);
+    }
+
+    void record_lock_wait(SegmentStats& stats, uint64_t ns) {
+        stats.wait_count.fetch_add(1, std::memory_order_relaxed);
+        stats.wait_total_ns.fetch_add(ns, std::memory_order_relaxed);
+        stats.wait_histogram[lock_wait_bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+        uint64_t max = stats.wait_max_ns.load(std::memory_order_relaxed);
+        while (ns > max && !stats.wait_max_ns.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t lock_wait_percentile(const SegmentStats& stats, double quantile) {
+        // 各桶计数之和作为总数，与 wait_count 之间的并发差异不影响结果
+        uint64_t total = 0;
+        for (size_t i = 0; i < LOCK_WAIT_BUCKETS; i++) {
+            total += stats.wait_histogram[i].load(std::memory_order_relaxed);
+        }
+        if (total == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(quantile * static_cast<double>(total) + 0.5);
+        if (rank < 1) {
+            rank = 1;
+        }
+        uint64_t seen = 0;
+        for (size_t i = 0; i < LOCK_WAIT_BUCKETS; i++) {
+            seen += stats.wait_histogram[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                return lock_wait_bucket_bound(i);
+            }
+        }
+        return lock_wait_bucket_bound(LOCK_WAIT_BUCKETS - 1);
+    }
+
+    ProcessStats get_process_stats() {
+        ProcessStats stats;
+        stats.mappings = process_mappings.load(std::memory_order_relaxed);
+        stats.mapped_bytes = process_mapped_bytes.load(std::memory_order_relaxed);
+        stats.handles = process_handles.load(std::memory_order_relaxed);
+        stats.opens = process_opens.load(std::memory_order_relaxed);
+        stats.closes = process_closes.load(std::memory_order_relaxed);
+        stats.remaps = process_remaps.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void SharedMemoryManager::account_mapping(int64_t mappings, int64_t bytes, int64_t handles) {
+        mapped_bytes_ = static_cast<size_t>(static_cast<int64_t>(mapped_bytes_) + bytes);
+        process_mappings.fetch_add(static_cast<uint64_t>(mappings), std::memory_order_relaxed);
+        process_mapped_bytes.fetch_add(static_cast<uint64_t>(bytes), std::memory_order_relaxed);
+        process_handles.fetch_add(static_cast<uint64_t>(handles), std::memory_order_relaxed);
+
+        SegmentStats* segment = stats();
+        if (mappings > 0) {
+            process_opens.fetch_add(1, std::memory_order_relaxed);
+            if (segment) {
+                segment->opens.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        else if (mappings < 0) {
+            process_closes.fetch_add(1, std::memory_order_relaxed);
+            if (segment) {
+                segment->closes.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void SharedMemoryManager::account_remap(int64_t bytes, int64_t handles) {
+        process_remaps.fetch_add(1, std::memory_order_relaxed);
+        if (SegmentStats* segment = stats()) {
+            segment->remaps.fetch_add(1, std::memory_order_relaxed);
+        }
+        account_mapping(0, bytes, handles);
+    }
+
+    uint64_t SharedMemoryManager::read_acquisitions() const {
+        if (!address_ || legacy_) {
+            return 0;
+        }
+        const ReadWriteLock& lock = static_cast<SharedMemoryHeader*>(address_)->rwlock;
+        uint64_t total = 0;
+        for (size_t i = 0; i < RWLOCK_SLOT_COUNT; i++) {
+            total += lock.slots[i].acquisitions.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+}
@@ -0,0 +1,249 @@
+#include "shared_memory.hh"
+#include "logging.hh"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+namespace SharedMemory {
+    const char* lock_result_name(LockResult result) {
+        switch (result) {
+            case LockResult::Ok:
+                return "ok";
+            case LockResult::Recovered:
+                return "recovered";
+            case LockResult::Busy:
+                return "busy";
+        }
+        return "ok";
+    }
+
+#ifndef _WIN32
+    static const uint32_t LOCK_UNINITIALIZED = 0;
+    static const uint32_t LOCK_INITIALIZING = 1;
+    static const uint32_t LOCK_READY = 2;
+    // 初始化只需几微秒，超过该时间仍未完成且初始化者已退出时才接管
+    static const int INIT_TIMEOUT_MS = 1000;
+
+    // 本线程经 lock()/try_lock() 持有的互斥锁（按键名）。头部互斥锁不可重入，持有期间在同一线程中扩展或重新创建会自锁
+    static thread_local std::set<std::string> held_locks;
+
+    // 初始化中的状态低两位为 LOCK_INITIALIZING，高位为初始化者的进程号；旧版本只写入 LOCK_INITIALIZING
+    static uint32_t initializing_state() {
+        return (static_cast<uint32_t>(getpid()) << 2) | LOCK_INITIALIZING;
+    }
+
+    static_assert(sizeof(pthread_mutex_t) <= sizeof(SharedMemoryHeader::lock), "pthread_mutex_t does not fit in the header");
+
+    static pthread_mutex_t* header_mutex(SharedMemoryHeader* header) {
+        return reinterpret_cast<pthread_mutex_t*>(header->lock);
+    }
+
+    static void create_mutex(SharedMemoryHeader* header) {
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+        // 同一线程重复获取时返回 EDEADLK 而不是自锁
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ERRORCHECK);
+        int result = pthread_mutex_init(header_mutex(header), &attr);
+        pthread_mutexattr_destroy(&attr);
+        if (result != 0) {
+            LOG_ERROR("Failed to initialize mutex, error: %s", strerror(result));
+            throw std::runtime_error("Failed to initialize mutex");
+        }
+        header->lock_state.store(LOCK_READY, std::memory_order_release);
+    }
+
+    void init_header_lock(SharedMemoryHeader* header, int timeout_ms) {
+        uint32_t state = header->lock_state.load(std::memory_order_acquire);
+        if (state == LOCK_READY) {
+            return;
+        }
+        // 新建的共享内存全为 0，第一个到达的进程负责初始化
+        if (state == LOCK_UNINITIALIZED &&
+            header->lock_state.compare_exchange_strong(state, initializing_state(), std::memory_order_acquire)) {
+            create_mutex(header);
+            return;
+        }
+
+        // timeout_ms 为 0 时只检查一次；接管以 CAS 换入自己的初始化状态，多个等待者中只有一个初始化互斥锁
+        auto start = std::chrono::steady_clock::now();
+        for (;;) {
+            state = header->lock_state.load(std::memory_order_acquire);
+            if (state == LOCK_READY) {
+                return;
+            }
+            int64_t waited = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            if (state == LOCK_UNINITIALIZED || (waited >= INIT_TIMEOUT_MS && !process_alive(state >> 2))) {
+                if (header->lock_state.compare_exchange_strong(state, initializing_state(), std::memory_order_acquire)) {
+                    if (state != LOCK_UNINITIALIZED) {
+                        LOG_WARN("Mutex initialization was abandoned by process %u, reinitializing", state >> 2);
+                    }
+                    create_mutex(header);
+                    return;
+                }
+                continue;
+            }
+            if (timeout_ms >= 0 && waited >= timeout_ms) {
+                LOG_ERROR("Timed out waiting for mutex initialization");
+                throw std::runtime_error("Timed out waiting for mutex initialization");
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    LockResult lock_header(SharedMemoryHeader* header, int timeout_ms) {
+        pthread_mutex_t* mutex = header_mutex(header);
+        SegmentStats& stats = header->stats;
+        // 先尝试一次，无争用时不读时钟
+        int result = pthread_mutex_trylock(mutex);
+        // 本线程已持有时 trylock 也返回 EDEADLK，只尝试一次时与被占用一样返回 Busy
+        if (result == EDEADLK && timeout_ms == 0) {
+            result = EBUSY;
+        }
+        bool contended = result == EBUSY && timeout_ms != 0;
+        if (contended) {
+            auto wait_start = std::chrono::steady_clock::now();
+            if (timeout_ms < 0) {
+                result = pthread_mutex_lock(mutex);
+            }
+            else {
+                // pthread_mutex_timedlock 使用 CLOCK_REALTIME 的绝对时间
+                struct timespec deadline;
+                clock_gettime(CLOCK_REALTIME, &deadline);
+                deadline.tv_sec += timeout_ms / 1000;
+                deadline.tv_nsec += static_cast<long>(timeout_ms % 1000) * 1000000L;
+                if (deadline.tv_nsec >= 1000000000L) {
+                    deadline.tv_sec += 1;
+                    deadline.tv_nsec -= 1000000000L;
+                }
+                result = pthread_mutex_timedlock(mutex, &deadline);
+            }
+            record_lock_wait(stats, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - wait_start).count()));
+        }
+
+        switch (result) {
+            case 0:
+                // 持有锁期间更新，计数之间不会互相争用
+                stats.lock_acquisitions.fetch_add(1, std::memory_order_relaxed);
+                if (contended) {
+                    stats.lock_contended.fetch_add(1, std::memory_order_relaxed);
+                }
+                return LockResult::Ok;
+            case EBUSY:
+            case ETIMEDOUT:
+                return LockResult::Busy;
+            case EDEADLK:
+                LOG_ERROR("Mutex is already held by this thread");
+                throw std::runtime_error("Mutex is already held by this thread");
+            case EOWNERDEAD:
+                // 持有者已退出，标记为一致后继续使用
+                LOG_WARN("Previous mutex owner died, recovering");
+                pthread_mutex_consistent(mutex);
+                stats.lock_acquisitions.fetch_add(1, std::memory_order_relaxed);
+                stats.lock_recoveries.fetch_add(1, std::memory_order_relaxed);
+                if (contended) {
+                    stats.lock_contended.fetch_add(1, std::memory_order_relaxed);
+                }
+                return LockResult::Recovered;
+            default:
+                LOG_ERROR("Failed to acquire mutex, error: %s", strerror(result));
+                throw std::runtime_error(result == ENOTRECOVERABLE ? "Mutex is not recoverable" : "Failed to acquire mutex");
+        }
+    }
+
+    bool header_lock_ready(const SharedMemoryHeader* header) {
+        return header->lock_state.load(std::memory_order_acquire) == LOCK_READY;
+    }
+
+    void unlock_header(SharedMemoryHeader* header) {
+        int result = pthread_mutex_unlock(header_mutex(header));
+        if (result != 0) {
+            LOG_ERROR("Failed to release mutex, error: %s", strerror(result));
+            throw std::runtime_error(result == EPERM ? "Mutex is not held by this thread" : "Failed to release mutex");
+        }
+    }
+
+    void SharedMemoryManager::ensure_lock_not_held() const {
+        if (held_locks.count(key_)) {
+            LOG_ERROR("Mutex is already held by this thread: key=%s", key_.c_str());
+            throw std::runtime_error("Mutex is already held by this thread, unlock it first");
+        }
+    }
+
+    LockResult SharedMemoryManager::lock(int timeout_ms) {
+        ensure_lock_not_held();
+        LockResult result = lock_header(header(), timeout_ms);
+        if (result != LockResult::Busy) {
+            held_locks.insert(key_);
+        }
+        return result;
+    }
+
+    LockResult SharedMemoryManager::try_lock() {
+        LockResult result = lock_header(header(), 0);
+        if (result != LockResult::Busy) {
+            held_locks.insert(key_);
+        }
+        return result;
+    }
+
+    void SharedMemoryManager::unlock() {
+        unlock_header(header());
+        held_locks.erase(key_);
+    }
+#else
+    // Windows 命名互斥锁可重入，同一线程重复获取不会自锁
+    void SharedMemoryManager::ensure_lock_not_held() const {
+    }
+
+    // Windows 命名互斥锁的持有者退出后返回 WAIT_ABANDONED，本身就是鲁棒的
+    LockResult SharedMemoryManager::lock(int timeout_ms) {
+        SegmentStats& stats = header()->stats;
+        // 先尝试一次，无争用时不读时钟
+        DWORD result = WaitForSingleObject(mutex_, 0);
+        bool contended = result == WAIT_TIMEOUT && timeout_ms != 0;
+        if (contended) {
+            auto wait_start = std::chrono::steady_clock::now();
+            result = WaitForSingleObject(mutex_, timeout_ms < 0 ? INFINITE : static_cast<DWORD>(timeout_ms));
+            record_lock_wait(stats, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - wait_start).count()));
+        }
+        if (result == WAIT_OBJECT_0 || result == WAIT_ABANDONED) {
+            stats.lock_acquisitions.fetch_add(1, std::memory_order_relaxed);
+            if (contended) {
+                stats.lock_contended.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        switch (result) {
+            case WAIT_OBJECT_0:
+                return LockResult::Ok;
+            case WAIT_ABANDONED:
+                LOG_WARN("Previous mutex owner died, recovering");
+                stats.lock_recoveries.fetch_add(1, std::memory_order_relaxed);
+                return LockResult::Recovered;
+            case WAIT_TIMEOUT:
+                return LockResult::Busy;
+            default:
+                LOG_ERROR("Failed to acquire mutex, error code: %lu", GetLastError());
+                throw std::runtime_error("Failed to acquire mutex");
+        }
+    }
+
+    LockResult SharedMemoryManager::try_lock() {
+        return lock(0);
+    }
+
+    void SharedMemoryManager::unlock() {
+        if (!ReleaseMutex(mutex_)) {
+            LOG_ERROR("Failed to release mutex, error code: %lu", GetLastError());
+            throw std::runtime_error("Mutex is not held by this thread");
+        }
+    }
+#endif
+}
@@ -0,0 +1,246 @@
+#include "shared_memory.hh"
+#include "logging.hh"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace SharedMemory {
+#ifndef _WIN32
+    // 调整大小期间持有头部中的互斥锁，与创建/打开互斥
+    class HeaderLockGuard {
+    public:
+        explicit HeaderLockGuard(SharedMemoryHeader* header) : header_(header) {
+            lock_header(header_, -1);
+        }
+        ~HeaderLockGuard() {
+            try {
+                unlock_header(header_);
+            } catch (...) {
+            }
+        }
+
+    private:
+        SharedMemoryHeader* header_;
+    };
+
+    // 打开已有的共享内存对象（只读和私有映射以只读方式打开），以文件描述符打开的对象没有名称，复制保留的描述符
+    static int open_object(const std::string& name, size_t huge_page_size, int backing_fd, bool read_only) {
+        int fd = backing_fd != -1 ? reopen_descriptor(backing_fd, read_only) : reopen_backing(name, huge_page_size, read_only);
+        if (fd == -1) {
+            LOG_ERROR("Failed to open shared memory, error: %s", strerror(errno));
+            throw std::runtime_error("Failed to open shared memory");
+        }
+        return fd;
+    }
+
+    void SharedMemoryManager::remap(int fd, size_t new_size, size_t data_offset) {
+        MappingLock mapping = lock_mapping();
+        size_t old_total = map_length(data_offset_ + size_);
+        size_t new_total = map_length(data_offset + new_size);
+
+        // 优先原地扩展，已返回的 ArrayBuffer 地址保持不变；数据区偏移变化（重新创建）时数据区已移动，总是建立新映射
+        if (data_offset == data_offset_ && new_total > old_total) {
+            void* address = mremap(address_, old_total, new_total, 0);
+            if (address != MAP_FAILED) {
+                size_ = new_size;
+                account_remap(static_cast<int64_t>(new_total - old_total), 0);
+                LOG_DEBUG("Remapped in place: key=%s, size=%zu", key_.c_str(), new_size);
+                reapply_options();
+                return;
+            }
+        }
+
+        // 无法原地扩展（或缩小）时建立新映射，旧映射保留到管理器销毁，避免旧 ArrayBuffer 悬空
+        void* address = map_view(fd, new_total);
+        if (address == MAP_FAILED) {
+            LOG_ERROR("Failed to map shared memory, error: %s", strerror(errno));
+            throw std::runtime_error("Failed to map shared memory");
+        }
+        retired_.push_back({address_, old_total});
+        address_ = address;
+        data_offset_ = data_offset;
+        size_ = new_size;
+        account_remap(static_cast<int64_t>(new_total), 0);
+        LOG_DEBUG("Remapped to new address: key=%s, size=%zu, address=%p", key_.c_str(), new_size, address_);
+        reapply_options();
+    }
+
+    void SharedMemoryManager::resize(size_t new_size) {
+        // 原地扩展或旧映射移入 retired_ 后，加锁时的头部地址仍然有效；旧版共享内存没有头部互斥锁，不支持扩展
+        ensure_lock_not_held();
+        HeaderLockGuard guard(header());
+        // 先取头部互斥锁再取映射锁，与持有头部互斥锁后调用 refresh 的线程加锁顺序一致
+        MappingLock mapping = lock_mapping();
+
+        // 先按调用方给出的大小判断缩小，再与其他进程可能已扩展到的更大值取较大者
+        size_t old_size = static_cast<size_t>(size_field());
+        if (new_size < size_) {
+            throw std::invalid_argument("Shrinking shared memory is not supported");
+        }
+        new_size = std::max<size_t>(new_size, old_size);
+
+        int fd = open_object(file_path_, huge_page_size_, backing_fd_, mode_ != MapMode::ReadWrite);
+        size_t total_size = data_offset_ + new_size;
+        struct stat st;
+        if (fstat(fd, &st) == -1 ||
+            (static_cast<size_t>(st.st_size) < total_size && ftruncate(fd, map_length(total_size)) == -1)) {
+            LOG_ERROR("Failed to set shared memory size, error: %s", strerror(errno));
+            close(fd);
+            throw std::runtime_error("Failed to set shared memory size");
+        }
+
+        try {
+            remap(fd, new_size, data_offset_);
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+        close(fd);
+
+        // 先写大小再推进代数，读者看到新代数时一定能读到新大小
+        size_field() = new_size;
+        generation_ = generation_word().fetch_add(1, std::memory_order_release) + 1;
+        // 扩展出的部分算作变更，同步的副本随之扩展
+        mark_dirty(old_size, new_size - old_size);
+        LOG_DEBUG("Shared memory resized: key=%s, size=%zu, generation=%u", key_.c_str(), new_size, generation_);
+    }
+
+    bool SharedMemoryManager::refresh() {
+        // 多个线程同时发现代数变化时只有第一个重新映射，其余在锁内看到代数已更新
+        MappingLock mapping = lock_mapping();
+        uint32_t generation = generation_word().load(std::memory_order_acquire);
+        if (generation == generation_) {
+            return false;
+        }
+
+        size_t new_size = static_cast<size_t>(size_field());
+        size_t data_offset = header_data_offset();
+        int fd = open_object(file_path_, huge_page_size_, backing_fd_, mode_ != MapMode::ReadWrite);
+        struct stat st;
+        if (fstat(fd, &st) == -1 || new_size > SIZE_MAX - data_offset ||
+            static_cast<size_t>(st.st_size) < data_offset + new_size) {
+            close(fd);
+            throw std::runtime_error("Shared memory object is smaller than its header size");
+        }
+
+        try {
+            remap(fd, new_size, data_offset);
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+        close(fd);
+
+        generation_ = generation;
+        return true;
+    }
+#else
+    void SharedMemoryManager::remap(HANDLE file_handle, size_t new_size, size_t data_offset) {
+        MappingLock mapping = lock_mapping();
+        size_t old_total = data_offset_ + size_;
+        size_t new_total = data_offset + new_size;
+
+        // 映射大小超过文件大小时 CreateFileMapping 会扩展文件
+        HANDLE mapping = CreateFileMappingA(
+            file_handle,
+            NULL,
+            page_protection(mode_),
+            static_cast<DWORD>(static_cast<uint64_t>(new_total) >> 32),
+            static_cast<DWORD>(new_total & 0xffffffff),
+            NULL
+        );
+        if (!mapping) {
+            DWORD error = GetLastError();
+            LOG_ERROR("Failed to create file mapping, error code: %lu, size: %zu", error, new_total);
+            throw std::runtime_error("Failed to create file mapping");
+        }
+
+        void* address = MapViewOfFile(mapping, view_access(mode_), 0, 0, new_total);
+        if (!address) {
+            DWORD error = GetLastError();
+            LOG_ERROR("Failed to map view of file, error code: %lu, size: %zu", error, new_total);
+            CloseHandle(mapping);
+            throw std::runtime_error("Failed to map view of file");
+        }
+
+        // 旧视图保留到管理器销毁，避免旧 ArrayBuffer 悬空
+        retired_.push_back({address_, old_total, file_mapping_});
+        address_ = address;
+        file_mapping_ = mapping;
+        data_offset_ = data_offset;
+        size_ = new_size;
+        account_remap(static_cast<int64_t>(new_total), 1);
+        reapply_options();
+    }
+
+    static HANDLE open_file(const std::string& file_path) {
+        HANDLE file_handle = CreateFileA(
+            file_path.c_str(),
+            GENERIC_READ | GENERIC_WRITE,
+            FILE_SHARE_READ | FILE_SHARE_WRITE,
+            NULL,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            NULL
+        );
+        if (file_handle == INVALID_HANDLE_VALUE) {
+            DWORD error = GetLastError();
+            LOG_ERROR("Failed to open file, error code: %lu", error);
+            throw std::runtime_error("Failed to open file");
+        }
+        return file_handle;
+    }
+
+    void SharedMemoryManager::resize(size_t new_size) {
+        lock(-1);
+
+        try {
+            MappingLock mapping = lock_mapping();
+            // 先按调用方给出的大小判断缩小，再与其他进程可能已扩展到的更大值取较大者
+            size_t old_size = static_cast<size_t>(size_field());
+            if (new_size < size_) {
+                throw std::invalid_argument("Shrinking shared memory is not supported");
+            }
+            new_size = std::max<size_t>(new_size, old_size);
+
+            HANDLE file_handle = open_file(file_path_);
+            try {
+                remap(file_handle, new_size, data_offset_);
+            } catch (...) {
+                CloseHandle(file_handle);
+                throw;
+            }
+            CloseHandle(file_handle);
+
+            size_field() = new_size;
+            generation_ = generation_word().fetch_add(1, std::memory_order_release) + 1;
+            mark_dirty(old_size, new_size - old_size);
+        } catch (...) {
+            ReleaseMutex(mutex_);
+            throw;
+        }
+        ReleaseMutex(mutex_);
+    }
+
+    bool SharedMemoryManager::refresh() {
+        MappingLock mapping = lock_mapping();
+        uint32_t generation = generation_word().load(std::memory_order_acquire);
+        if (generation == generation_) {
+            return false;
+        }
+
+        HANDLE file_handle = open_file(file_path_);
+        try {
+            remap(file_handle, static_cast<size_t>(size_field()), header_data_offset());
+        } catch (...) {
+            CloseHandle(file_handle);
+            throw;
+        }
+        CloseHandle(file_handle);
+
+        generation_ = generation;
+        return true;
+    }
+#endif
+}
@@ -0,0 +1,173 @@
+#include "shared_memory.hh"
+#include <cstring>
+#include <stdexcept>
+
+namespace SharedMemory {
+    static const uint32_t RING_MAGIC = 0x52494e47;        // "RING"
+    static const uint32_t RING_WRAP_MARKER = 0xffffffff;  // 回绕标记，表示跳到缓冲区起始处
+    static const size_t RING_FRAME_HEADER = sizeof(uint32_t);
+    static const size_t RING_ALIGNMENT = 64;
+
+    // 帧按 8 字节对齐，保证长度字段不会跨越缓冲区末尾
+    static inline size_t frame_size(size_t length) {
+        return (RING_FRAME_HEADER + length + 7) & ~static_cast<size_t>(7);
+    }
+
+    static size_t round_up_pow2(size_t value) {
+        size_t result = 64;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    // 控制块放在数据区内第一个缓存行对齐的位置，各进程计算结果一致
+    static RingHeader* ring_header_of(void* data_addr) {
+        uintptr_t addr = reinterpret_cast<uintptr_t>(data_addr);
+        addr = (addr + RING_ALIGNMENT - 1) & ~(RING_ALIGNMENT - 1);
+        return reinterpret_cast<RingHeader*>(addr);
+    }
+
+    size_t RingBuffer::segment_size(size_t capacity) {
+        return RING_ALIGNMENT + sizeof(RingHeader) + round_up_pow2(capacity);
+    }
+
+    RingBuffer::RingBuffer(std::shared_ptr<SharedMemoryManager> manager, bool create)
+        : manager_(std::move(manager)), header_(nullptr), data_(nullptr), mask_(0),
+          cached_head_(0), cached_tail_(0)
+    {
+        // 生产者和消费者都要写控制块
+        if (manager_->is_read_only()) {
+            throw std::invalid_argument("Ring buffer requires a writable mapping");
+        }
+        void* data_addr = manager_->get_data();
+        header_ = ring_header_of(data_addr);
+        data_ = reinterpret_cast<uint8_t*>(header_ + 1);
+
+        size_t available = manager_->get_size() - (reinterpret_cast<uint8_t*>(data_) - static_cast<uint8_t*>(data_addr));
+        if (create) {
+            // 取不超过可用空间的最大 2 的幂作为容量
+            size_t capacity = 64;
+            while ((capacity << 1) <= available) {
+                capacity <<= 1;
+            }
+            header_->head.store(0, std::memory_order_relaxed);
+            header_->tail.store(0, std::memory_order_relaxed);
+            header_->capacity = capacity;
+            header_->reserved = 0;
+            std::atomic_thread_fence(std::memory_order_release);
+            header_->magic = RING_MAGIC;
+        }
+        else {
+            if (header_->magic != RING_MAGIC) {
+                throw std::runtime_error("Shared memory is not a ring buffer");
+            }
+            if (header_->capacity > available || (header_->capacity & (header_->capacity - 1)) != 0) {
+                throw std::runtime_error("Ring buffer header is corrupted");
+            }
+        }
+
+        mask_ = header_->capacity - 1;
+        cached_head_ = header_->head.load(std::memory_order_acquire);
+        cached_tail_ = header_->tail.load(std::memory_order_acquire);
+    }
+
+    size_t RingBuffer::max_frame() const {
+        // 限制为容量的一半，保证回绕浪费的空间之外总能放下一帧
+        return (mask_ + 1) / 2 - RING_FRAME_HEADER;
+    }
+
+    bool RingBuffer::reserve(size_t length, uint64_t& head) {
+        size_t capacity = mask_ + 1;
+        size_t need = frame_size(length);
+        size_t pos = head & mask_;
+        size_t contiguous = capacity - pos;
+        size_t total = contiguous < need ? contiguous + need : need;
+
+        // 先用本地缓存的读取位置判断，空间不足时才读取对端的缓存行
+        if (head + total - cached_tail_ > capacity) {
+            cached_tail_ = header_->tail.load(std::memory_order_acquire);
+            if (head + total - cached_tail_ > capacity) {
+                return false;
+            }
+        }
+
+        if (contiguous < need) {
+            uint32_t marker = RING_WRAP_MARKER;
+            memcpy(data_ + pos, &marker, sizeof(marker));
+            head += contiguous;
+        }
+        return true;
+    }
+
+    void RingBuffer::write_frame(uint64_t& head, const void* data, size_t length) {
+        size_t pos = head & mask_;
+        uint32_t frame_length = static_cast<uint32_t>(length);
+        memcpy(data_ + pos, &frame_length, sizeof(frame_length));
+        memcpy(data_ + pos + RING_FRAME_HEADER, data, length);
+        head += frame_size(length);
+    }
+
+    bool RingBuffer::push(const void* data, size_t length) {
+        if (length > max_frame()) {
+            throw std::length_error("Frame is larger than half of the ring capacity");
+        }
+
+        // 只有生产者修改 head，relaxed 读取即可
+        uint64_t head = header_->head.load(std::memory_order_relaxed);
+        if (!reserve(length, head)) {
+            return false;
+        }
+        write_frame(head, data, length);
+        header_->head.store(head, std::memory_order_release);
+        return true;
+    }
+
+    size_t RingBuffer::push_batch(const Frame* frames, size_t count) {
+        uint64_t head = header_->head.load(std::memory_order_relaxed);
+        size_t pushed = 0;
+        for (; pushed < count; pushed++) {
+            if (frames[pushed].length > max_frame()) {
+                throw std::length_error("Frame is larger than half of the ring capacity");
+            }
+            if (!reserve(frames[pushed].length, head)) {
+                break;
+            }
+            write_frame(head, frames[pushed].data, frames[pushed].length);
+        }
+        // 整批只发布一次，消费者一次看到全部帧
+        if (pushed > 0) {
+            header_->head.store(head, std::memory_order_release);
+        }
+        return pushed;
+    }
+
+    const uint8_t* RingBuffer::peek(size_t& length) {
+        uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+        if (tail == cached_head_) {
+            cached_head_ = header_->head.load(std::memory_order_acquire);
+            if (tail == cached_head_) {
+                return nullptr;
+            }
+        }
+
+        size_t pos = tail & mask_;
+        uint32_t frame_length;
+        memcpy(&frame_length, data_ + pos, sizeof(frame_length));
+        if (frame_length == RING_WRAP_MARKER) {
+            // 生产者在写完回绕后的帧之后才发布 head，此处可直接跳转
+            tail += (mask_ + 1) - pos;
+            header_->tail.store(tail, std::memory_order_release);
+            pos = 0;
+            memcpy(&frame_length, data_, sizeof(frame_length));
+        }
+
+        length = frame_length;
+        return data_ + pos + RING_FRAME_HEADER;
+    }
+
+    void RingBuffer::consume(size_t length) {
+        uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+        header_->tail.store(tail + frame_size(length), std::memory_order_release);
+    }
+}
@@ -0,0 +1,208 @@
+#include "shared_memory.hh"
+#include <chrono>
+#include <climits>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+namespace SharedMemory {
+    // 写入者最多让等待中的读者先读这么久，避免已退出的读者拖住写入者
+    static const double READER_GRACE_MS = 1;
+
+    // 剩余等待时间，负数表示无限等待
+    class Deadline {
+    public:
+        explicit Deadline(double timeout_ms)
+            : infinite_(timeout_ms < 0),
+              start_(std::chrono::steady_clock::now()),
+              end_(start_ + std::chrono::microseconds(static_cast<int64_t>((timeout_ms < 0 ? 0 : timeout_ms) * 1000))) {}
+
+        bool expired() const {
+            return !infinite_ && std::chrono::steady_clock::now() >= end_;
+        }
+
+        double remaining_ms() const {
+            if (infinite_) {
+                return -1;
+            }
+            auto remaining = std::chrono::duration<double, std::milli>(end_ - std::chrono::steady_clock::now()).count();
+            return remaining < 0 ? 0 : remaining;
+        }
+
+        // 自开始加锁以来的纳秒数，只在发生等待时用于统计
+        uint64_t elapsed_ns() const {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start_).count());
+        }
+
+    private:
+        bool infinite_;
+        std::chrono::steady_clock::time_point start_;
+        std::chrono::steady_clock::time_point end_;
+    };
+
+    static uint64_t process_id() {
+#ifdef _WIN32
+        return static_cast<uint64_t>(GetCurrentProcessId());
+#else
+        return static_cast<uint64_t>(getpid());
+#endif
+    }
+
+    // 每个线程固定使用一个读者槽，加锁和解锁必须在同一线程。
+    // 线程号只在进程内唯一（各进程的主线程往往相同），混入进程号后不同进程的读者分散到不同槽
+    static ReadWriteLock::Slot& reader_slot(ReadWriteLock& lock) {
+        static thread_local size_t index =
+            ((std::hash<std::thread::id>()(std::this_thread::get_id()) ^ process_id()) * 0x9e3779b97f4a7c15ULL >> 32) %
+            RWLOCK_SLOT_COUNT;
+        return lock.slots[index];
+    }
+
+    // 读者离开槽，写入者正在等待且槽已清空时唤醒它
+    static void leave_slot(ReadWriteLock& lock, std::atomic<uint32_t>& slot) {
+        if (slot.fetch_sub(1, std::memory_order_seq_cst) == 1 && lock.writer.load(std::memory_order_seq_cst) != 0) {
+            futex_wake(&slot, INT_MAX);
+        }
+    }
+
+    static void leave_waiting(ReadWriteLock& lock) {
+        if (lock.waiting_readers.fetch_sub(1, std::memory_order_release) == 1) {
+            futex_wake(&lock.waiting_readers, INT_MAX);
+        }
+    }
+
+    // 写入者之间的三态 futex 互斥锁，无竞争时只有一次 CAS
+    static bool lock_writer_mutex(std::atomic<uint32_t>& mutex, const Deadline& deadline, bool& contended) {
+        uint32_t state = 0;
+        if (mutex.compare_exchange_strong(state, 1, std::memory_order_acquire)) {
+            return true;
+        }
+        contended = true;
+        if (state != 2) {
+            state = mutex.exchange(2, std::memory_order_acquire);
+        }
+        while (state != 0) {
+            if (deadline.expired()) {
+                return false;
+            }
+            futex_wait(&mutex, 2, deadline.remaining_ms());
+            state = mutex.exchange(2, std::memory_order_acquire);
+        }
+        return true;
+    }
+
+    static void unlock_writer_mutex(std::atomic<uint32_t>& mutex) {
+        if (mutex.fetch_sub(1, std::memory_order_release) != 1) {
+            mutex.store(0, std::memory_order_release);
+            futex_wake(&mutex, 1);
+        }
+    }
+
+    bool SharedMemoryManager::read_lock(double timeout_ms) {
+        SharedMemoryHeader* shared = header();
+        ReadWriteLock& lock = shared->rwlock;
+        ReadWriteLock::Slot& reader = reader_slot(lock);
+        std::atomic<uint32_t>& slot = reader.readers;
+        Deadline deadline(timeout_ms);
+        bool waiting = false;
+
+        for (;;) {
+            uint32_t writer = lock.writer.load(std::memory_order_acquire);
+            if (writer == 0) {
+                // 先登记再确认没有写入者，与写入者的先置位再检查各槽配对
+                slot.fetch_add(1, std::memory_order_seq_cst);
+                if (lock.writer.load(std::memory_order_seq_cst) == 0) {
+                    // 计数与读者数位于同一缓存行，不引入新的争用
+                    reader.acquisitions.fetch_add(1, std::memory_order_relaxed);
+                    if (waiting) {
+                        leave_waiting(lock);
+                        shared->stats.read_contended.fetch_add(1, std::memory_order_relaxed);
+                        record_lock_wait(shared->stats, deadline.elapsed_ns());
+                    }
+                    return true;
+                }
+                // 写入者已到达，撤回登记让它先执行
+                leave_slot(lock, slot);
+                continue;
+            }
+
+            if (!waiting) {
+                lock.waiting_readers.fetch_add(1, std::memory_order_acq_rel);
+                waiting = true;
+            }
+            if (deadline.expired()) {
+                leave_waiting(lock);
+                record_lock_wait(shared->stats, deadline.elapsed_ns());
+                return false;
+            }
+            futex_wait(&lock.writer, writer, deadline.remaining_ms());
+        }
+    }
+
+    void SharedMemoryManager::read_unlock() {
+        ReadWriteLock& lock = header()->rwlock;
+        std::atomic<uint32_t>& slot = reader_slot(lock).readers;
+        if (slot.load(std::memory_order_relaxed) == 0) {
+            throw std::logic_error("readUnlock called without readLock");
+        }
+        leave_slot(lock, slot);
+    }
+
+    bool SharedMemoryManager::write_lock(double timeout_ms) {
+        SharedMemoryHeader* shared = header();
+        ReadWriteLock& lock = shared->rwlock;
+        Deadline deadline(timeout_ms);
+        bool contended = false;
+        if (!lock_writer_mutex(lock.writer_mutex, deadline, contended)) {
+            record_lock_wait(shared->stats, deadline.elapsed_ns());
+            return false;
+        }
+
+        // 上一个写入者释放后，先让已在等待的读者读一轮，写入者连续到达时读者也不会饿死
+        uint32_t waiting = lock.waiting_readers.load(std::memory_order_acquire);
+        if (waiting != 0) {
+            contended = true;
+            Deadline grace(READER_GRACE_MS);
+            do {
+                futex_wait(&lock.waiting_readers, waiting, grace.remaining_ms());
+            } while ((waiting = lock.waiting_readers.load(std::memory_order_acquire)) != 0 && !grace.expired());
+        }
+
+        // 置位后新读者不再进入，逐槽等待已有读者退出
+        lock.writer.store(1, std::memory_order_seq_cst);
+        for (size_t i = 0; i < RWLOCK_SLOT_COUNT; i++) {
+            std::atomic<uint32_t>& slot = lock.slots[i].readers;
+            uint32_t readers;
+            while ((readers = slot.load(std::memory_order_seq_cst)) != 0) {
+                contended = true;
+                if (deadline.expired()) {
+                    lock.writer.store(0, std::memory_order_release);
+                    futex_wake(&lock.writer, INT_MAX);
+                    unlock_writer_mutex(lock.writer_mutex);
+                    record_lock_wait(shared->stats, deadline.elapsed_ns());
+                    return false;
+                }
+                futex_wait(&slot, readers, deadline.remaining_ms());
+            }
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        // 持有写锁期间更新，写入者之间不会争用
+        shared->stats.write_acquisitions.fetch_add(1, std::memory_order_relaxed);
+        if (contended) {
+            shared->stats.write_contended.fetch_add(1, std::memory_order_relaxed);
+            record_lock_wait(shared->stats, deadline.elapsed_ns());
+        }
+        return true;
+    }
+
+    void SharedMemoryManager::write_unlock() {
+        ReadWriteLock& lock = header()->rwlock;
+        if (lock.writer.load(std::memory_order_relaxed) == 0) {
+            throw std::logic_error("writeUnlock called without writeLock");
+        }
+        lock.writer.store(0, std::memory_order_release);
+        futex_wake(&lock.writer, INT_MAX);
+        unlock_writer_mutex(lock.writer_mutex);
+    }
+}
@@ -0,0 +1,207 @@
+#include "shared_memory.hh"
+#include "logging.hh"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <shlobj.h> // 用于CSIDL_PERSONAL
+#else
+#include <cerrno>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace SharedMemory {
+#ifndef _WIN32
+    // 删除名称前等待头部互斥锁的上限；调用 lock 的进程可能长时间持有，超时后不加锁删除
+    static const int REMOVE_LOCK_TIMEOUT_MS = 5000;
+#endif
+
+    std::shared_ptr<SharedMemoryManager> create_segment(const std::string& key, size_t length, int timeout_ms,
+                                                        const MapOptions& options, Backend backend) {
+        LOG_DEBUG("Creating SharedMemoryManager...");
+        
+        // 创建共享内存管理器
+        auto manager = create_manager(key, length, timeout_ms, options, backend);
+        LOG_DEBUG("SharedMemoryManager created successfully.");
+        
+        // 获取共享内存的地址
+        void* addr = manager->get_address();
+        
+        LOG_DEBUG("Shared memory created: key=%s, size=%zu, address=%p", 
+            key.c_str(), manager->get_size(), addr);
+        
+        // 获取数据区域的地址
+        void* data_addr = manager->get_data();
+        // 新页面在首次访问时由系统清零，只清除重新创建时沿用的旧内容，大共享内存不再在此逐页缺页
+        memset(data_addr, 0, manager->get_reused_length());
+        // 初始分配时，存储key。
+        auto str = "key:" + key;
+        memcpy(data_addr, str.c_str(), std::min(str.length(), length));
+        // 新建或重新创建后整个数据区都算作变更，从纪元 0 收集得到完整内容
+        manager->mark_dirty(0, manager->get_size());
+        return manager;
+    }
+
+    bool remove_segment(const std::string& key) {
+        // 移出映射缓存，之后的 getMemory 会重新打开共享内存
+        evict_manager(key);
+        
+#ifdef _WIN32
+        // Windows实现
+        // 尝试打开共享内存
+        HANDLE hMapFile = OpenFileMappingA(
+            FILE_MAP_ALL_ACCESS,  // 读写权限
+            FALSE,               // 不继承句柄
+            ("SharedMemory_" + key).c_str()  // 共享内存名称
+        );
+        
+        if (hMapFile != NULL) {
+            // 关闭句柄，这会在最后一个引用被关闭时自动删除共享内存
+            CloseHandle(hMapFile);
+            LOG_DEBUG("Closed file mapping handle");
+        }
+        
+        // 尝试删除互斥锁
+        std::string mutex_name = key + "_mutex";
+        HANDLE hMutex = OpenMutexA(
+            DELETE,              // 请求删除权限
+            FALSE,              // 不继承句柄
+            mutex_name.c_str()  // 互斥锁名称
+        );
+        
+        if (hMutex != NULL) {
+            CloseHandle(hMutex);
+            LOG_DEBUG("Closed mutex handle");
+        }
+        
+        // 尝试删除实际文件
+        // 获取用户目录
+        char user_path[MAX_PATH];
+        std::string file_path;
+        
+        if (SUCCEEDED(SHGetFolderPathA(NULL, CSIDL_PERSONAL, NULL, 0, user_path))) {
+            LOG_DEBUG("User path: %s", user_path);
+            file_path = std::string(user_path) + "\\SharedMemory\\skyline_" + key + ".dat";
+        } else {
+            // 如果获取用户目录失败，使用当前目录
+            GetCurrentDirectoryA(MAX_PATH, user_path);
+            LOG_DEBUG("Using current directory: %s", user_path);
+            file_path = std::string(user_path) + "\\SharedMemory\\skyline_" + key + ".dat";
+        }
+        
+        // 尝试删除文件
+        if (DeleteFileA(file_path.c_str())) {
+            LOG_INFO("Deleted file: %s", file_path.c_str());
+        } else {
+            DWORD error = GetLastError();
+            if (error != ERROR_FILE_NOT_FOUND) {
+                LOG_ERROR("Failed to delete file: %s, error code: %lu", file_path.c_str(), error);
+            }
+        }
+        
+        // 尝试删除目录（如果为空）
+        std::string dir_path = std::string(user_path) + "\\SharedMemory";
+        if (RemoveDirectoryA(dir_path.c_str())) {
+            LOG_INFO("Removed directory: %s", dir_path.c_str());
+        }
+#else
+        // 删除名称后新的打开会失败，已映射的进程继续使用原有内存，最后一个映射释放后由系统回收
+        std::string path;
+        size_t huge_page_size = 0;
+        int fd = open_backing(key, false, false, path, huge_page_size);
+        if (fd == -1) {
+            if (errno != ENOENT) {
+                LOG_ERROR("Failed to open shared memory %s, error: %s", key.c_str(), strerror(errno));
+            }
+            return false;
+        }
+        // 在附加记录中标记已删除，仍映射的进程可从 getMemoryInfo 得知，等待互斥锁的打开者据此重新打开
+        struct stat st;
+        size_t header_length = huge_page_size ? huge_page_size : sizeof(SharedMemoryHeader);
+        SharedMemoryHeader* header = nullptr;
+        if (fstat(fd, &st) == 0 && static_cast<uint64_t>(st.st_size) >= sizeof(SharedMemoryHeader)) {
+            void* address = mmap(NULL, header_length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (address != MAP_FAILED) {
+                header = static_cast<SharedMemoryHeader*>(address);
+                if (header->magic != HEADER_MAGIC || header->format_version < 3 ||
+                    header->data_offset < sizeof(SharedMemoryHeader)) {
+                    munmap(address, header_length);
+                    header = nullptr;
+                }
+            }
+        }
+        close(fd);
+
+        // 标记和删除名称在互斥锁内进行，打开者在锁内看到未标记时名称一定还在；
+        // 互斥锁尚未初始化时没有打开者越过锁，本线程已持有或锁不可恢复时只能不加锁标记
+        bool locked = false;
+        if (header && header_lock_ready(header)) {
+            try {
+                if (lock_header(header, REMOVE_LOCK_TIMEOUT_MS) != LockResult::Busy) {
+                    locked = true;
+                }
+                else {
+                    LOG_WARN("Timed out waiting for the mutex, removing without it: key=%s", key.c_str());
+                }
+            } catch (const std::runtime_error& e) {
+                LOG_WARN("Removing without the mutex: key=%s, reason: %s", key.c_str(), e.what());
+            }
+        }
+        if (header) {
+            header->owners.removed.store(1, std::memory_order_release);
+        }
+
+        int result = huge_page_size ? unlink(path.c_str()) : shm_unlink(path.c_str());
+        int error = errno;
+        if (header) {
+            // 名称仍在时撤销标记，否则之后的打开都会放弃这个对象
+            if (result != 0) {
+                header->owners.removed.store(0, std::memory_order_release);
+            }
+            if (locked) {
+                unlock_header(header);
+            }
+            munmap(header, header_length);
+        }
+        if (result != 0) {
+            LOG_ERROR("Failed to remove shared memory %s, error: %s", path.c_str(), strerror(error));
+            return false;
+        }
+        // 旧版本创建的命名信号量，不存在时忽略
+        sem_unlink(("/skyline_mutex_" + key).c_str());
+#endif
+        
+        LOG_INFO("Shared memory removed: key=%s", key.c_str());
+        return true;
+    }
+
+    WriteScope::WriteScope(std::shared_ptr<SharedMemoryManager> manager, double timeout_ms)
+        : manager_(std::move(manager)), locked_(false)
+    {
+        if (!manager_->is_legacy()) {
+            if (!manager_->write_lock(timeout_ms)) {
+                throw std::runtime_error("Timed out waiting for the write lock");
+            }
+            locked_ = true;
+        }
+        try {
+            manager_->begin_write(timeout_ms);
+        } catch (...) {
+            if (locked_) {
+                manager_->write_unlock();
+            }
+            throw;
+        }
+    }
+
+    WriteScope::~WriteScope() {
+        manager_->end_write();
+        if (locked_) {
+            manager_->write_unlock();
+        }
+    }
+}
@@ -0,0 +1,122 @@
+#include "shared_memory.hh"
+#include "logging.hh"
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace SharedMemory {
+    // 自旋若干次后让出 CPU，避免写入者被抢占时读者空转
+    static const int SPIN_LIMIT = 64;
+
+    static uint32_t current_pid() {
+#ifdef _WIN32
+        return static_cast<uint32_t>(GetCurrentProcessId());
+#else
+        return static_cast<uint32_t>(getpid());
+#endif
+    }
+
+    uint32_t SharedMemoryManager::begin_write(double timeout_ms) {
+        if (mode_ != MapMode::ReadWrite) {
+            throw std::runtime_error(mode_ == MapMode::ReadOnly ? "Shared memory is mapped read-only" :
+                                                                  "Shared memory is mapped privately");
+        }
+        std::atomic<uint32_t>& word = version_word();
+        // 旧版头部没有写入者进程号，只能等到超时
+        SharedMemoryHeader* shared = local_pids() ? header() : nullptr;
+        if (!std::isfinite(timeout_ms) || timeout_ms > INT_MAX) {
+            timeout_ms = -1;
+        }
+        auto deadline = std::chrono::steady_clock::now() +
+            std::chrono::microseconds(static_cast<int64_t>(timeout_ms * 1000));
+        int spins = 0;
+        uint32_t version = word.load(std::memory_order_acquire);
+        for (;;) {
+            if ((version & 1) == 0) {
+                if (word.compare_exchange_weak(version, version + 1, std::memory_order_acquire, std::memory_order_acquire)) {
+                    break;
+                }
+                continue;
+            }
+            if (++spins > SPIN_LIMIT) {
+                // 写入者退出而未结束写入：先清除进程号，只有清除成功的等待者推进版本号，
+                // 其他等待者读到 0 不会误判之后开始的写入
+                uint32_t writer = shared ? shared->writer_pid.load(std::memory_order_acquire) : 0;
+                if (writer != 0 && !process_alive(writer) &&
+                    shared->writer_pid.compare_exchange_strong(writer, 0, std::memory_order_acq_rel)) {
+                    uint32_t abandoned = version;
+                    if (word.compare_exchange_strong(abandoned, version + 1, std::memory_order_release,
+                                                     std::memory_order_relaxed)) {
+                        LOG_WARN("Recovered seqlock abandoned by writer %u: key=%s, version=%u", writer,
+                            key_.c_str(), version);
+                    }
+                }
+                else if (timeout_ms >= 0 && std::chrono::steady_clock::now() >= deadline) {
+                    throw std::runtime_error("Timed out waiting for the previous writer");
+                }
+                std::this_thread::yield();
+            }
+            version = word.load(std::memory_order_acquire);
+        }
+        if (shared) {
+            shared->writer_pid.store(current_pid(), std::memory_order_relaxed);
+        }
+        // 保证奇数版本号先于数据写入可见
+        std::atomic_thread_fence(std::memory_order_release);
+        return version + 1;
+    }
+
+    uint32_t SharedMemoryManager::end_write() {
+        std::atomic<uint32_t>& word = version_word();
+        uint32_t version = word.load(std::memory_order_relaxed);
+        if ((version & 1) == 0) {
+            throw std::logic_error("endWrite called without beginWrite");
+        }
+        if (!legacy_) {
+            header()->writer_pid.store(0, std::memory_order_relaxed);
+        }
+        word.store(version + 1, std::memory_order_release);
+        return version + 1;
+    }
+
+    uint32_t SharedMemoryManager::read_consistent(size_t offset, size_t length, void* target, double timeout_ms) {
+        std::atomic<uint32_t>& word = version_word();
+        if (offset > size_ || length > size_ - offset) {
+            throw std::out_of_range("Read range exceeds shared memory size");
+        }
+        const char* source = reinterpret_cast<const char*>(get_data()) + offset;
+
+        if (!std::isfinite(timeout_ms) || timeout_ms > INT_MAX) {
+            timeout_ms = -1;
+        }
+        auto deadline = std::chrono::steady_clock::now() +
+            std::chrono::microseconds(static_cast<int64_t>(timeout_ms * 1000));
+        int spins = 0;
+        for (;;) {
+            uint32_t before = word.load(std::memory_order_acquire);
+            if ((before & 1) == 0) {
+                memcpy(target, source, length);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (word.load(std::memory_order_relaxed) == before) {
+                    return before;
+                }
+            }
+
+            if (++spins > SPIN_LIMIT) {
+                // 写入者可能已退出而未结束写入，超时后放弃
+                if (timeout_ms >= 0 && std::chrono::steady_clock::now() >= deadline) {
+                    throw std::runtime_error("Timed out waiting for a consistent snapshot");
+                }
+                std::this_thread::yield();
+            }
+        }
+    }
+}
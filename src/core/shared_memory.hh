@@ -0,0 +1,1255 @@
+#pragma once
+
+#ifndef SHARED_MEMORY_HH
+#define SHARED_MEMORY_HH
+// 共享内存核心库的公共头文件，不依赖 N-API，原生生产者可直接链接 shared_memory_core 使用
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 平台特定的头文件
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <pthread.h>
+#endif
+
+namespace SharedMemory {
+    // 日志级别
+    enum class LogLevel {
+        Trace = 0,
+        Debug = 1,
+        Info = 2,
+        Warn = 3,
+        Error = 4,
+        Off = 5
+    };
+
+    // 日志入队后的通知函数，可在任意线程调用
+    typedef void (*LogNotifier)();
+
+    // 运行期日志级别判断，只有一次原子读
+    bool log_enabled(LogLevel level);
+
+    // 设置/获取运行期最低日志级别
+    void set_log_level(LogLevel level);
+    LogLevel get_log_level();
+
+    // 日志辅助函数，可在任意线程调用；未设置通知函数时写入异步 spdlog
+    void log(LogLevel level, const char* format, ...);
+
+    // 设置通知函数，设置后日志先进入无锁队列，再由 drain_log 批量取出
+    void set_log_notifier(LogNotifier notifier);
+
+    // 取出队列中的全部日志，返回条数
+    size_t drain_log(void (*deliver)(LogLevel level, const char* message, void* context), void* context);
+
+    // 日志级别与名称互转
+    const char* log_level_name(LogLevel level);
+    bool parse_log_level(const std::string& name, LogLevel& level);
+
+    // 读写锁的读者计数槽数，不同线程分散到不同缓存行，读者之间互不争用
+    constexpr size_t RWLOCK_SLOT_COUNT = 16;
+
+    // 进程间读写锁，读者只修改自己所在槽的计数，写入者逐槽等待读者退出
+    struct ReadWriteLock {
+        alignas(64) std::atomic<uint32_t> writer;           // 1 表示写入者持有或正在等待，新读者需等待
+        std::atomic<uint32_t> writer_mutex;                 // 写入者之间的互斥（0 空闲，1 持有，2 有等待者）
+        std::atomic<uint32_t> waiting_readers;              // 因写入者而等待的读者数
+        struct alignas(64) Slot {
+            std::atomic<uint32_t> readers;                  // 该槽中持有读锁的读者数
+            uint32_t reserved;                              // 保留
+            std::atomic<uint64_t> acquisitions;             // 该槽累计获取读锁的次数，与计数同一缓存行，不增加争用
+        } slots[RWLOCK_SLOT_COUNT];
+    };
+
+    // 锁等待直方图：对数-线性分桶，每个 2 的幂区间分 4 个子桶，相对误差不超过 25%，覆盖 1ns 到约 68s
+    constexpr size_t LOCK_WAIT_SUB_BUCKETS = 4;
+    constexpr size_t LOCK_WAIT_MAX_EXPONENT = 36;
+    constexpr size_t LOCK_WAIT_BUCKETS = (LOCK_WAIT_MAX_EXPONENT - 1) * LOCK_WAIT_SUB_BUCKETS;
+
+    // 共享内存头部中的跨进程统计，任何已映射的进程都可读取；只在发生争用时读时钟
+    struct SegmentStats {
+        alignas(64) std::atomic<uint64_t> opens;            // 创建和打开次数
+        std::atomic<uint64_t> closes;                       // 映射释放次数
+        std::atomic<uint64_t> remaps;                       // 重新映射次数
+        std::atomic<uint64_t> lock_acquisitions;            // 互斥锁获取次数
+        std::atomic<uint64_t> lock_contended;               // 互斥锁需要等待的次数
+        std::atomic<uint64_t> lock_recoveries;              // 互斥锁从已退出的持有者恢复的次数
+        std::atomic<uint64_t> write_acquisitions;           // 写锁获取次数
+        std::atomic<uint64_t> write_contended;              // 写锁需要等待的次数
+        alignas(64) std::atomic<uint64_t> read_contended;   // 读锁需要等待的次数（获取次数在各读者槽中）
+        std::atomic<uint64_t> wait_count;                   // 锁等待次数
+        std::atomic<uint64_t> wait_total_ns;                // 锁等待总时长
+        std::atomic<uint64_t> wait_max_ns;                  // 锁等待最长时长
+        std::atomic<uint64_t> wait_histogram[LOCK_WAIT_BUCKETS];  // 锁等待时长分布
+    };
+
+    /**
+     * 等待时长所在的直方图桶
+     * @param ns 等待纳秒数
+     * @return 桶号
+     */
+    size_t lock_wait_bucket(uint64_t ns);
+
+    /**
+     * 直方图桶的上界（不含）
+     * @param bucket 桶号
+     * @return 纳秒数
+     */
+    uint64_t lock_wait_bucket_bound(size_t bucket);
+
+    /**
+     * 记录一次锁等待
+     * @param stats 头部统计
+     * @param ns 等待纳秒数
+     */
+    void record_lock_wait(SegmentStats& stats, uint64_t ns);
+
+    /**
+     * 按直方图估算等待时长的分位数
+     * @param stats 头部统计
+     * @param quantile 分位 (0, 1]
+     * @return 所在桶的上界纳秒数，没有等待时返回 0
+     */
+    uint64_t lock_wait_percentile(const SegmentStats& stats, double quantile);
+
+    // 进程内的全局统计
+    struct ProcessStats {
+        uint64_t mappings;      // 存活的共享内存映射数
+        uint64_t mapped_bytes;  // 映射的总字节数（含扩展后保留的旧映射）
+        uint64_t handles;       // 持有的句柄数（Windows 的文件映射和互斥锁；Linux 上为 memfd 等保留的描述符，命名对象映射后即关闭）
+        uint64_t opens;         // 累计创建和打开次数
+        uint64_t closes;        // 累计释放次数
+        uint64_t remaps;        // 累计重新映射次数
+    };
+
+    // 获取进程内的全局统计
+    ProcessStats get_process_stats();
+
+    // 头部魔数 "SKYM"，旧版 16 字节头部没有魔数
+    constexpr uint32_t HEADER_MAGIC = 0x4d594b53;
+    // 头部格式版本，布局不兼容时递增
+    constexpr uint16_t HEADER_FORMAT_VERSION = 3;
+    // 数据区按页对齐（否则按缓存行对齐）
+    constexpr uint16_t HEADER_FLAG_PAGE_ALIGNED = 0x1;
+    // 头部之后有变更跟踪区，数据区偏移已为其留出空间
+    constexpr uint16_t HEADER_FLAG_DIRTY_TRACKING = 0x2;
+    constexpr size_t CACHE_LINE_SIZE = 64;
+    constexpr size_t PAGE_SIZE_BYTES = 4096;
+
+    // 附加记录中的进程槽数，槽用完后的附加只计数、不登记进程号
+    constexpr size_t OWNER_SLOT_COUNT = 128;
+
+    // 附加记录：每个映射占一个槽，释放时清空，进程崩溃留下的槽由 gc 按进程是否存活判断
+    struct SegmentOwners {
+        alignas(64) std::atomic<uint32_t> attached;         // 当前附加的映射数（含已退出但未释放的进程）
+        std::atomic<uint32_t> removed;                      // removeMemory 后为 1，名称已删除，映射仍有效
+        std::atomic<uint32_t> pids[OWNER_SLOT_COUNT];       // 附加进程号，0 表示空槽
+    };
+
+    // 共享内存头部结构，元数据、顺序锁版本号、互斥锁和读写锁分别位于不同的缓存行
+    struct SharedMemoryHeader {
+        alignas(64) uint32_t magic;        // 魔数
+        uint16_t format_version;           // 头部格式版本
+        uint16_t flags;                    // HEADER_FLAG_*
+        uint32_t owner_pid;                // 创建者进程号
+        uint32_t pid_namespace;            // 创建者的 PID 命名空间标识，0 表示未知（旧版本创建）
+        uint64_t data_offset;              // 数据区相对映射起点的偏移，按缓存行或页对齐
+        uint64_t size;                     // 用户数据大小
+        std::atomic<uint32_t> generation;  // 映射代数，大小变化时递增
+        alignas(64) std::atomic<uint32_t> version;  // 版本号（顺序锁），奇数表示写入进行中
+        std::atomic<uint32_t> writer_pid;  // 写入进行中时为写入者进程号，0 表示未知
+        alignas(64) std::atomic<uint32_t> lock_state;  // 互斥锁初始化状态
+        uint32_t lock_reserved;            // 保留
+        alignas(8) unsigned char lock[56]; // 进程间鲁棒互斥锁（Linux 为 pthread_mutex_t，Windows 使用命名互斥锁）
+        ReadWriteLock rwlock;              // 保护数据区的读写锁
+        SegmentStats stats;                // 跨进程统计
+        SegmentOwners owners;              // 附加记录（格式版本 3）
+    };
+
+    // 变更跟踪的块大小范围，必须是 2 的幂
+    constexpr size_t DIRTY_BLOCK_MIN = 4096;
+    constexpr size_t DIRTY_BLOCK_MAX = 65536;
+    // 每组的块数，组纪元为组内块纪元的最大值，收集时跳过没有变化的组
+    constexpr size_t DIRTY_GROUP_BLOCKS = 64;
+
+    // 变更跟踪控制块，紧跟在头部之后；其后依次是组纪元数组和块纪元数组（uint32_t，各自按缓存行对齐）。
+    // 块纪元记录块最后一次被标记时的纪元，每次收集后纪元递增，collect 只返回纪元晚于 since 的块（按回绕差值比较）
+    struct DirtyTracker {
+        alignas(64) std::atomic<uint32_t> epoch;   // 当前纪元，从 1 开始
+        uint32_t block_shift;                      // 块大小的以 2 为底的对数
+        uint64_t blocks;                           // 跟踪的块数，覆盖创建时的数据区
+        std::atomic<uint32_t> tail_epoch;          // 扩展后超出跟踪范围的部分最后被标记时的纪元
+    };
+
+    // 变更区间，偏移相对数据区起点
+    struct DirtyRange {
+        uint64_t offset;
+        uint64_t length;
+    };
+
+    /**
+     * 块大小是否可用于变更跟踪
+     * @param block_size 块大小
+     */
+    bool valid_dirty_block(size_t block_size);
+
+    /**
+     * 变更跟踪区（控制块、组纪元和块纪元）的字节数
+     * @param size 数据区大小
+     * @param block_size 块大小
+     */
+    size_t dirty_tracker_bytes(size_t size, size_t block_size);
+
+    // 不含附加记录的头部大小（格式版本 2），数据区偏移小于完整头部的共享内存不记录附加进程
+    constexpr size_t HEADER_BASE_SIZE = sizeof(SharedMemoryHeader) - sizeof(SegmentOwners);
+
+    // 旧版头部，数据区紧跟在第 16 字节之后，只支持打开
+    struct LegacyHeader {
+        uint64_t size;                     // 用户数据大小
+        std::atomic<uint32_t> version;     // 版本号
+        std::atomic<uint32_t> generation;  // 映射代数
+    };
+
+    /**
+     * 计算数据区偏移：较小的共享内存按缓存行对齐，不小于一页的按页对齐；跟踪变更时在头部之后留出跟踪区并按页对齐
+     * @param size 数据区大小
+     * @param dirty_block 变更跟踪的块大小，0 表示不跟踪
+     * @return 数据区偏移
+     */
+    size_t data_offset_for(size_t size, size_t dirty_block = 0);
+
+    /**
+     * 判断头部是否为旧版格式
+     * @param address 映射起点
+     * @param object_size 共享内存对象的实际大小
+     */
+    bool is_legacy_header(const void* address, uint64_t object_size);
+
+    // 大页模式
+    enum class HugePages {
+        None,           // 普通页
+        Transparent,    // 透明大页（madvise MADV_HUGEPAGE）
+        Explicit        // hugetlbfs 上的预留大页
+    };
+
+    // 打开方式，只在打开已有的共享内存时生效，新建的共享内存总是读写映射
+    enum class MapMode {
+        ReadWrite,  // MAP_SHARED 读写映射
+        ReadOnly,   // PROT_READ 只读映射，写入会触发 SIGSEGV；不获取互斥锁，不写入头部
+        Private     // MAP_PRIVATE 写时复制，写入只影响本映射；未写过的页面仍随共享内存变化
+    };
+
+    // 打开方式对应的字符串
+    const char* map_mode_name(MapMode mode);
+
+    // 解析 "readwrite" | "readonly" | "private"
+    bool parse_map_mode(const std::string& name, MapMode& mode);
+
+#ifdef _WIN32
+    // 打开方式对应的 CreateFileMapping 页面保护与 MapViewOfFile 访问权限
+    DWORD page_protection(MapMode mode);
+    DWORD view_access(MapMode mode);
+#endif
+
+    // 映射选项，不可用的模式会降级并记录警告
+    struct MapOptions {
+        MapMode mode = MapMode::ReadWrite;  // 打开方式，缓存中的只读映射与读写映射分开保存，私有映射不缓存
+        HugePages huge_pages = HugePages::None;
+        bool populate = false;      // 预先建立全部页表，首次访问不再缺页
+        bool lock = false;          // mlock 锁定在物理内存中
+        size_t dirty_block = 0;     // 变更跟踪的块大小（4 KiB–64 KiB），0 表示不跟踪；只在新建时生效
+    };
+
+    // 大页模式对应的字符串
+    const char* huge_pages_name(HugePages mode);
+
+    // 解析 "transparent" | "explicit" | "none"
+    bool parse_huge_pages(const std::string& name, HugePages& mode);
+
+    // 存储后端
+    enum class Backend {
+        Named,      // /dev/shm 或 hugetlbfs 上的命名对象，按键名打开
+        Memfd       // memfd_create 创建的匿名对象，没有全局名称，经 Unix 套接字传递文件描述符共享（仅 Linux）
+    };
+
+    // 存储后端对应的字符串
+    const char* backend_name(Backend backend);
+
+    // 解析 "shm" | "memfd"
+    bool parse_backend(const std::string& name, Backend& backend);
+
+    // memfd 的封印，与 F_SEAL_* 一一对应
+    constexpr uint32_t SEAL_SHRINK = 0x1;      // 不能缩小，映射者不会因截断而 SIGBUS
+    constexpr uint32_t SEAL_GROW = 0x2;        // 不能扩展
+    constexpr uint32_t SEAL_WRITE = 0x4;       // 内容不可修改，只能只读映射
+
+#ifndef _WIN32
+    /**
+     * 打开共享内存对象：已存在时沿用其所在位置，否则 explicit_huge 为真且存在 hugetlbfs 挂载点时建在 hugetlbfs 上
+     * @param key 共享内存键名
+     * @param create 不存在时是否创建
+     * @param explicit_huge 新建时是否使用 hugetlbfs
+     * @param path 对象路径（shm_open 名称或 hugetlbfs 上的文件路径）
+     * @param huge_page_size hugetlbfs 的大页大小，普通共享内存为 0
+     * @param read_only 以只读方式打开（只读和私有映射不需要写权限），不创建
+     * @return 文件描述符，失败返回 -1 并保留 errno
+     */
+    int open_backing(const std::string& key, bool create, bool explicit_huge, std::string& path, size_t& huge_page_size,
+                     bool read_only = false);
+
+    /**
+     * 按 open_backing 返回的路径重新打开共享内存对象
+     * @param path 对象路径
+     * @param huge_page_size 大页大小，0 表示普通共享内存
+     * @param read_only 以只读方式打开
+     * @return 文件描述符，失败返回 -1 并保留 errno
+     */
+    int reopen_backing(const std::string& path, size_t huge_page_size, bool read_only = false);
+
+    /**
+     * 第一个 hugetlbfs 挂载点
+     * @param huge_page_size 大页大小
+     * @return 挂载目录，没有时返回空字符串
+     */
+    std::string hugetlbfs_mount(size_t& huge_page_size);
+
+    /**
+     * 文件描述符对应的路径（/proc/self/fd 的链接目标）
+     * @param fd 文件描述符
+     * @return 路径，memfd 为 /memfd:<名称> (deleted)，读取失败时返回空字符串
+     */
+    std::string descriptor_path(int fd);
+
+    /**
+     * 重新打开文件描述符对应的对象；只读时经 /proc/self/fd 以 O_RDONLY 打开，
+     * 建立的共享映射不计为可写映射，不妨碍 memfd 封印写入
+     * @param fd 文件描述符
+     * @param read_only 是否只读
+     * @return 新的文件描述符，失败返回 -1 并保留 errno
+     */
+    int reopen_descriptor(int fd, bool read_only);
+
+    /**
+     * 文件描述符所在 hugetlbfs 的大页大小
+     * @param fd 文件描述符
+     * @return 大页大小，不在 hugetlbfs 上时返回 0
+     */
+    size_t descriptor_huge_page_size(int fd);
+#endif
+
+    // 获取互斥锁的结果
+    enum class LockResult {
+        Ok,         // 已获取
+        Recovered,  // 已获取，上一个持有者退出时未释放，数据可能不完整
+        Busy        // 超时或已被占用
+    };
+
+    // 获取结果对应的字符串
+    const char* lock_result_name(LockResult result);
+
+#ifndef _WIN32
+    /**
+     * 初始化头部中的进程间鲁棒互斥锁，已由其他进程初始化时直接返回；
+     * 初始化者已退出且等待超过一秒时由一个等待者接管，超时抛出异常
+     * @param header 共享内存头部
+     * @param timeout_ms 等待其他进程完成初始化的超时毫秒数，0 表示只检查一次，负数表示无限等待
+     */
+    void init_header_lock(SharedMemoryHeader* header, int timeout_ms);
+
+    /**
+     * 获取头部中的互斥锁
+     * @param header 共享内存头部
+     * @param timeout_ms 超时毫秒数，负数表示无限等待，0 表示只尝试一次
+     * @return Ok | Recovered | Busy（超时）
+     */
+    LockResult lock_header(SharedMemoryHeader* header, int timeout_ms);
+
+    // 释放头部中的互斥锁
+    void unlock_header(SharedMemoryHeader* header);
+
+    // 头部中的互斥锁是否已初始化完成
+    bool header_lock_ready(const SharedMemoryHeader* header);
+#endif
+
+    // 管理器的映射锁
+    typedef std::unique_lock<std::recursive_mutex> MappingLock;
+
+    // 共享内存管理器类
+    class SharedMemoryManager : public std::enable_shared_from_this<SharedMemoryManager> {
+    public:
+        // 构造函数，timeout_ms 为获取互斥锁的超时毫秒数，负数表示使用平台默认值
+        SharedMemoryManager(const std::string& key, bool create = false, size_t size = 0, int timeout_ms = -1,
+                            const MapOptions& options = MapOptions());
+
+        /**
+         * 以文件描述符创建或打开共享内存（memfd 或经 Unix 套接字收到的描述符），管理器接管 fd，析构时关闭；
+         * 已封印写入的对象以只读方式映射，不获取头部互斥锁
+         * @param fd 文件描述符，构造失败时也会关闭
+         * @param key 进程内的键名
+         * @param create 是否初始化为新的共享内存
+         * @param size 新建时的数据区大小
+         * @param timeout_ms 获取互斥锁的超时毫秒数，负数表示使用平台默认值
+         * @param options 映射选项
+         */
+        SharedMemoryManager(int fd, const std::string& key, bool create, size_t size = 0, int timeout_ms = -1,
+                            const MapOptions& options = MapOptions());
+        
+        // 析构函数
+        ~SharedMemoryManager();
+        
+        /**
+         * 本进程内的映射锁：同一管理器由所有 worker_threads 和线程池共用，重新映射、应用选项与读取地址和大小之间互斥。
+         * 同一线程可重入；与头部互斥锁一起使用时先取头部互斥锁，持有映射锁时不再获取头部互斥锁
+         * @return 已加锁的映射锁
+         */
+        MappingLock lock_mapping() const { return MappingLock(mapping_mutex_); }
+
+        // 映射锁本身，同时锁定两个管理器时配合 std::lock 使用，避免加锁顺序不同造成死锁
+        std::recursive_mutex& mapping_mutex() const { return mapping_mutex_; }
+
+        // 获取共享内存地址
+        void* get_address() const { return address_; }
+        
+        // 获取共享内存大小
+        size_t get_size() const { return size_; }
+
+        // 数据区相对映射起点的偏移
+        size_t get_data_offset() const { return data_offset_; }
+
+        // 数据区地址
+        uint8_t* get_data() const { return static_cast<uint8_t*>(address_) + data_offset_; }
+
+        // 是否为旧版 16 字节头部的共享内存
+        bool is_legacy() const { return legacy_; }
+
+        // 本进程与创建者位于同一 PID 命名空间，头部和数据区中记录的进程号可以判断存活；旧版头部为 false
+        bool local_pids() const;
+
+        // 键名
+        const std::string& get_key() const { return key_; }
+
+        // 存储后端
+        Backend get_backend() const { return backend_; }
+
+        // 打开方式；封印写入后变为只读
+        MapMode get_mode() const { return mode_; }
+
+        // 是否只读映射，只读和私有映射不能加锁、扩展或开始写入
+        bool is_read_only() const { return mode_ == MapMode::ReadOnly; }
+
+        /**
+         * 复制一个指向同一共享内存对象的文件描述符，用于经 Unix 套接字交给其他进程
+         * @return 新的文件描述符，由调用方关闭
+         */
+        int export_fd() const;
+
+        /**
+         * 封印 memfd：总是禁止缩小；write 为真时同时禁止写入和扩展，本进程的映射原地改为只读。
+         * 本进程仍有可写视图（ArrayBuffer）时抛出异常（EBUSY），避免之后经视图写入触发 SIGSEGV；
+         * 其他进程仍有可写映射时同样失败
+         * @param write 是否禁止写入
+         */
+        void seal(bool write);
+
+        /**
+         * 登记或注销指向可写映射的视图，由视图的持有者 ViewReference 调用
+         * @param delta 增减的数量
+         */
+        void add_writable_views(int delta) { writable_views_.fetch_add(delta, std::memory_order_acq_rel); }
+
+        // 本进程中指向可写映射、尚未回收的视图数
+        int writable_views() const { return writable_views_.load(std::memory_order_acquire); }
+
+        // 已加的封印（SEAL_*），命名对象为 0
+        uint32_t get_seals() const;
+
+        /**
+         * 对当前映射应用大页、预取和锁定选项，已生效的选项保留，重新映射后自动重新应用
+         * @param options 映射选项，不可用的模式降级并记录警告
+         */
+        void apply_options(const MapOptions& options);
+
+        // 实际生效的映射选项
+        const MapOptions& get_mapping() const { return mapping_; }
+
+        // hugetlbfs 的大页大小，普通共享内存为 0
+        size_t get_huge_page_size() const { return huge_page_size_; }
+
+        // 重新创建时数据区中沿用旧内容的字节数，其余部分由系统清零
+        size_t get_reused_length() const { return reused_length_; }
+
+        // 本进程中该共享内存映射的字节数，含扩展后保留的旧映射
+        size_t get_mapped_bytes() const { return mapped_bytes_; }
+
+        // 头部中的跨进程统计，旧版共享内存没有统计或只读、私有映射时返回 nullptr
+        SegmentStats* stats() const {
+            return address_ && !legacy_ && mode_ == MapMode::ReadWrite ?
+                &static_cast<SharedMemoryHeader*>(address_)->stats : nullptr;
+        }
+
+        // 累计获取读锁的次数（各读者槽之和）
+        uint64_t read_acquisitions() const;
+
+        // 头部中的附加记录，旧版头部、只读或私有映射、数据区偏移容纳不下附加记录时返回 nullptr
+        SegmentOwners* owners() const {
+            return address_ && !legacy_ && mode_ == MapMode::ReadWrite && data_offset_ >= sizeof(SharedMemoryHeader) ?
+                &static_cast<SharedMemoryHeader*>(address_)->owners : nullptr;
+        }
+
+        // 变更跟踪控制块，未启用跟踪、只读或私有映射时返回 nullptr
+        DirtyTracker* dirty_tracker() const;
+
+        // 变更跟踪的块大小，未启用跟踪时为 0
+        size_t get_dirty_block_size() const;
+
+        /**
+         * 标记数据区中被修改的区间，写入数据之后调用
+         * @param offset 起始偏移
+         * @param length 字节数
+         * @return 未启用跟踪时返回 false
+         */
+        bool mark_dirty(size_t offset, size_t length);
+
+        /**
+         * 收集 since 之后被标记的区间，相邻的块合并为一个区间，区间不超出当前映射的大小
+         * @param since 上次收集返回的纪元，0 表示全部
+         * @param ranges 输出的变更区间
+         * @return 本次收集的纪元，下次收集时作为 since 传入
+         */
+        uint32_t collect_dirty(uint32_t since, std::vector<DirtyRange>& ranges);
+
+        /**
+         * 在多个线程中并行预取整个映射的页面，首次访问不再缺页；只在读取地址时持有映射锁，预取期间不阻塞其他线程
+         * @param threads 线程数，0 表示按 CPU 核数选择
+         */
+        void prefault(unsigned threads);
+        
+        // 获取文件路径
+        const std::string& get_file_path() const { return file_path_; }
+        
+        // 获取版本号
+        uint32_t get_version() const { 
+            if (address_) {
+                return version_word().load(std::memory_order_acquire);
+            }
+            return 0;
+        }
+
+        /**
+         * 开始写入：将版本号置为奇数，其他写入者在此等待。
+         * 上一个写入者已退出而未结束写入时，同一 PID 命名空间内的等待者把版本号推进为偶数后继续
+         * @param timeout_ms 等待上一个写入结束的超时毫秒数，负数表示无限等待，超时抛出 std::runtime_error
+         * @return 当前版本号
+         */
+        uint32_t begin_write(double timeout_ms = -1);
+
+        // 结束写入：将版本号推进到下一个偶数
+        uint32_t end_write();
+
+        /**
+         * 读取数据区的一致快照，读取期间发生写入则重试，不获取任何锁
+         * @param offset 数据区偏移
+         * @param length 读取长度
+         * @param target 目标地址
+         * @param timeout_ms 等待写入完成的超时毫秒数，负数表示无限等待
+         * @return 快照对应的版本号
+         */
+        uint32_t read_consistent(size_t offset, size_t length, void* target, double timeout_ms);
+
+        // 当前映射对应的代数
+        uint32_t get_generation() const { return generation_; }
+
+        // 头部记录的最新代数，与 get_generation() 不同时需要 refresh()
+        uint32_t get_header_generation() const {
+            return generation_word().load(std::memory_order_acquire);
+        }
+
+        /**
+         * 扩展共享内存并推进代数，不支持缩小
+         * @param new_size 新的数据区大小
+         */
+        void resize(size_t new_size);
+
+        /**
+         * 代数变化时按头部记录的大小重新映射，未变化时只有一次原子读
+         * @return 是否重新映射
+         */
+        bool refresh();
+
+        /**
+         * 获取共享内存的互斥锁，持有者退出后由下一个获取者恢复；本线程已持有时抛出异常
+         * @param timeout_ms 超时毫秒数，负数表示无限等待
+         * @return Ok | Recovered | Busy（超时）
+         */
+        LockResult lock(int timeout_ms = -1);
+
+        // 尝试获取互斥锁，已被占用时立即返回 Busy
+        LockResult try_lock();
+
+        // 释放互斥锁
+        void unlock();
+
+        // 本线程已通过 lock()/try_lock() 持有互斥锁时抛出异常，避免扩展或重新创建时自锁
+        void ensure_lock_not_held() const;
+
+        /**
+         * 获取数据区读锁，多个读者可同时持有
+         * @param timeout_ms 超时毫秒数，负数表示无限等待
+         * @return 超时返回 false
+         */
+        bool read_lock(double timeout_ms = -1);
+
+        // 释放当前线程持有的读锁
+        void read_unlock();
+
+        /**
+         * 获取数据区写锁，等待已有读者退出，期间新读者需等待
+         * @param timeout_ms 超时毫秒数，负数表示无限等待
+         * @return 超时返回 false
+         */
+        bool write_lock(double timeout_ms = -1);
+
+        // 释放写锁
+        void write_unlock();
+        
+    private:
+        // 被替换下来的旧映射，仍可能被旧的 ArrayBuffer 引用
+        struct RetiredMapping {
+            void* address;
+            size_t length;
+#ifdef _WIN32
+            HANDLE mapping;
+#endif
+        };
+
+        // 头部字段，旧版与新版位置不同
+        std::atomic<uint32_t>& version_word() const {
+            return legacy_ ? static_cast<LegacyHeader*>(address_)->version : static_cast<SharedMemoryHeader*>(address_)->version;
+        }
+        std::atomic<uint32_t>& generation_word() const {
+            return legacy_ ? static_cast<LegacyHeader*>(address_)->generation : static_cast<SharedMemoryHeader*>(address_)->generation;
+        }
+        uint64_t& size_field() const {
+            return legacy_ ? static_cast<LegacyHeader*>(address_)->size : static_cast<SharedMemoryHeader*>(address_)->size;
+        }
+
+        // 新版头部，旧版共享内存没有互斥锁和读写锁
+        SharedMemoryHeader* header() const;
+
+        // 当前头部记录的数据区偏移，其他进程重新创建后可能变化；记录的值无效时抛出 std::runtime_error
+        size_t header_data_offset() const;
+
+        // 重新映射后对新映射再次应用请求过的选项
+        void reapply_options();
+
+        // 映射建立（mappings 为 1）或释放（-1）时更新映射字节数、句柄数和打开/释放计数
+        void account_mapping(int64_t mappings, int64_t bytes, int64_t handles);
+
+        // 重新映射时更新统计
+        void account_remap(int64_t bytes, int64_t handles);
+
+        // 在附加记录中登记/注销本映射
+        void attach_owner();
+        void detach_owner();
+
+        // 映射建立后登记附加、更新统计并应用映射选项
+        void attach(const MapOptions& options);
+
+        // 映射和截断长度，hugetlbfs 上须为大页的整数倍
+        size_t map_length(size_t length) const {
+            return huge_page_size_ ? (length + huge_page_size_ - 1) / huge_page_size_ * huge_page_size_ : length;
+        }
+
+        std::string key_;           // 共享内存键名
+        size_t size_;               // 数据区大小
+        size_t data_offset_;        // 数据区偏移
+        bool legacy_;               // 是否为旧版头部
+        size_t huge_page_size_;     // hugetlbfs 的大页大小，0 表示普通共享内存
+        Backend backend_;           // 存储后端
+        MapMode mode_;              // 打开方式
+        int backing_fd_;            // 以文件描述符打开时保留的描述符，扩展和导出时使用，否则为 -1
+        size_t dirty_block_;        // 新建时请求的变更跟踪块大小，0 表示不跟踪
+        size_t reused_length_;      // 重新创建时沿用旧内容的字节数
+        size_t mapped_bytes_;       // 本进程映射的字节数
+        MapOptions requested_;      // 请求的映射选项，重新映射后再次应用
+        MapOptions mapping_;        // 实际生效的映射选项
+        void* address_;             // 共享内存地址
+        std::string file_path_;     // 文件路径
+        uint32_t generation_;       // 当前映射对应的代数
+        int owner_slot_;            // 附加记录中的槽号，-1 表示未登记进程号
+        bool attached_;             // 是否已计入附加计数
+        std::vector<RetiredMapping> retired_;  // 旧映射，析构时释放
+        mutable std::recursive_mutex mapping_mutex_;  // 映射锁，保护地址、大小、旧映射和映射选项
+        std::atomic<int> writable_views_{0};          // 指向可写映射的视图数
+
+#ifdef _WIN32
+        HANDLE file_mapping_;       // 文件映射句柄
+        HANDLE mutex_;              // 互斥锁句柄
+        
+        // 创建文件映射
+        bool create_mapping(HANDLE file_handle, size_t mapping_size);
+
+        // 建立新的视图，旧视图移入 retired_
+        void remap(HANDLE file_handle, size_t new_size, size_t data_offset);
+#else
+        // 映射 fd 对应的对象：新建时初始化头部，打开时按头部记录的大小映射；不关闭 fd。
+        // 等待互斥锁期间名称已被删除时返回 false，调用方重新打开
+        bool map_object(int fd, bool create, size_t size, int timeout_ms);
+
+        // 只读或私有映射：不获取互斥锁、不写入头部，按头部记录的大小映射
+        void map_detached(int fd, int timeout_ms);
+
+        // 按打开方式映射 [0, length)，失败返回 MAP_FAILED
+        void* map_view(int fd, size_t length) const;
+
+        // 原地扩展映射，失败或数据区偏移变化时建立新映射，旧映射移入 retired_
+        void remap(int fd, size_t new_size, size_t data_offset);
+#endif
+    };
+
+    // ArrayBuffer 等视图持有的管理器引用，最后一个引用释放时解除映射；以可写方式映射时计入 writable_views
+    class ViewReference {
+    public:
+        explicit ViewReference(std::shared_ptr<SharedMemoryManager> manager)
+            : manager_(std::move(manager)), writable_(manager_->get_mode() == MapMode::ReadWrite) {
+            if (writable_) {
+                manager_->add_writable_views(1);
+            }
+        }
+        ~ViewReference() {
+            if (writable_) {
+                manager_->add_writable_views(-1);
+            }
+        }
+        ViewReference(const ViewReference&) = delete;
+        ViewReference& operator=(const ViewReference&) = delete;
+
+        const std::shared_ptr<SharedMemoryManager>& manager() const { return manager_; }
+
+    private:
+        std::shared_ptr<SharedMemoryManager> manager_;
+        bool writable_;
+    };
+
+    // 环形缓冲区控制块，head 与 tail 分别独占一个缓存行，避免生产者和消费者互相争用
+    struct RingHeader {
+        alignas(64) std::atomic<uint64_t> head;   // 生产者写入位置（单调递增）
+        alignas(64) std::atomic<uint64_t> tail;   // 消费者读取位置（单调递增）
+        alignas(64) uint64_t capacity;            // 帧数据区容量，2 的幂
+        uint32_t magic;                           // 魔数
+        uint32_t reserved;                        // 保留
+    };
+
+    // 单生产者/单消费者无锁环形缓冲区，建立在共享内存数据区之上
+    class RingBuffer {
+    public:
+        // 待写入的一帧数据
+        struct Frame {
+            const void* data;
+            size_t length;
+        };
+
+        // 计算容纳指定容量所需的数据区大小
+        static size_t segment_size(size_t capacity);
+
+        // 在共享内存上创建或打开环形缓冲区
+        RingBuffer(std::shared_ptr<SharedMemoryManager> manager, bool create);
+
+        // 写入一帧，空间不足时返回 false
+        bool push(const void* data, size_t length);
+
+        // 批量写入，返回实际写入的帧数
+        size_t push_batch(const Frame* frames, size_t count);
+
+        // 查看下一帧，缓冲区为空时返回 nullptr
+        const uint8_t* peek(size_t& length);
+
+        // 释放 peek 返回的帧
+        void consume(size_t length);
+
+        // 单帧最大长度
+        size_t max_frame() const;
+
+        // 帧数据区容量
+        size_t capacity() const { return mask_ + 1; }
+
+    private:
+        bool reserve(size_t length, uint64_t& head);
+        void write_frame(uint64_t& head, const void* data, size_t length);
+
+        std::shared_ptr<SharedMemoryManager> manager_;  // 保持映射有效
+        RingHeader* header_;        // 控制块
+        uint8_t* data_;             // 帧数据区
+        uint64_t mask_;             // 容量掩码
+        uint64_t cached_head_;      // 消费者缓存的 head
+        uint64_t cached_tail_;      // 生产者缓存的 tail
+    };
+
+    // 堆的尺寸类数量，块大小从 32 字节到 1 TiB 按 2 的幂划分
+    constexpr size_t HEAP_CLASS_COUNT = 36;
+
+    // 堆控制块，每个尺寸类的空闲链表独占一个缓存行，互不争用
+    struct HeapHeader {
+        uint32_t magic;                           // 魔数
+        uint32_t reserved;                        // 保留
+        uint64_t arena_begin;                     // 可分配区域起点（相对数据区）
+        uint64_t arena_end;                       // 可分配区域终点（相对数据区）
+        alignas(64) std::atomic<uint64_t> bump;   // 未切分区域的起点
+        struct alignas(64) SizeClass {
+            std::atomic<uint32_t> lock;           // 空闲链表自旋锁，保存持有者进程号
+            uint32_t reserved;                    // 保留
+            uint64_t free_head;                   // 首个空闲块偏移，0 表示为空
+            uint64_t free_count;                  // 空闲块数量
+        } classes[HEAP_CLASS_COUNT];
+    };
+
+    struct HeapBlock;
+
+    // 共享内存内的按尺寸类分配器，偏移量均相对数据区起点，任何进程都可分配和释放
+    class SharedHeap {
+    public:
+        // 计算容纳指定可分配大小所需的数据区大小
+        static size_t segment_size(size_t size);
+
+        // 在共享内存上创建或打开堆
+        SharedHeap(std::shared_ptr<SharedMemoryManager> manager, bool create);
+
+        // 分配至少 size 字节，空间不足时返回 0
+        uint64_t alloc(size_t size);
+
+        // 释放 alloc 返回的偏移
+        void free(uint64_t offset);
+
+        // 块的实际可用大小
+        size_t usable_size(uint64_t offset) const;
+
+        // 所在的共享内存
+        const std::shared_ptr<SharedMemoryManager>& manager() const { return manager_; }
+
+    private:
+        HeapBlock* used_block(uint64_t offset) const;
+
+        std::shared_ptr<SharedMemoryManager> manager_;  // 保持映射有效
+        uint8_t* data_;             // 数据区起点
+        HeapHeader* header_;        // 控制块
+    };
+
+    // 哈希表写入分段数，相同的键总是落在同一分段
+    constexpr size_t MAP_STRIPE_BITS = 6;
+    constexpr size_t MAP_STRIPE_COUNT = static_cast<size_t>(1) << MAP_STRIPE_BITS;
+
+    // 哈希表控制块，桶数组紧随其后
+    struct MapHeader {
+        uint32_t magic;                           // 魔数
+        uint32_t key_size;                        // 键的最大长度
+        uint32_t value_size;                      // 值的最大长度
+        uint32_t reserved;                        // 保留
+        uint64_t capacity;                        // 最多容纳的键数
+        uint64_t buckets;                         // 桶数，2 的幂
+        uint64_t slot_size;                       // 每个桶的字节数
+        alignas(64) std::atomic<uint64_t> count;  // 当前键数
+        std::atomic<uint32_t> relocations;        // 键前移或墓碑改回空桶的次数，查找和插入据此判断是否需要重新探测
+        std::atomic<uint32_t> inserts;            // 插入次数，删除者据此判断扫描期间簇是否变化
+        struct alignas(64) Stripe {
+            std::atomic<uint32_t> lock;           // 分段写锁，保存持有者进程号
+        } stripes[MAP_STRIPE_COUNT];
+    };
+
+    struct MapSlot;
+
+    // 共享内存内的开放寻址哈希表：读取按桶版本号无锁校验，写入按分段串行
+    class SharedMap {
+    public:
+        // 计算容纳指定容量所需的数据区大小
+        static size_t segment_size(size_t capacity, size_t key_size, size_t value_size);
+
+        // 在共享内存上创建（需给出容量和键值长度）或打开哈希表
+        SharedMap(std::shared_ptr<SharedMemoryManager> manager, bool create,
+                  size_t capacity = 0, size_t key_size = 0, size_t value_size = 0);
+
+        // 查找键，找到时把值复制到 value（至少 value_size() 字节）
+        bool get(const void* key, size_t key_length, void* value, size_t& value_length) const;
+
+        // 插入或更新，表满时返回 false
+        bool put(const void* key, size_t key_length, const void* value, size_t value_length);
+
+        // 删除键，不存在时返回 false
+        bool remove(const void* key, size_t key_length);
+
+        // 依次访问每个键值对，visit 返回 false 时停止；与删除并发时，被前移的键可能被跳过或访问两次
+        void iterate(const std::function<bool(const uint8_t*, size_t, const uint8_t*, size_t)>& visit) const;
+
+        size_t size() const;
+        size_t capacity() const;
+        size_t key_size() const;
+        size_t value_size() const;
+
+    private:
+        enum class Probe {
+            Match,      // 桶中是要找的键
+            Empty,      // 空桶，探测结束
+            Other       // 其他键或墓碑，继续探测
+        };
+
+        MapSlot* slot_at(uint64_t index) const;
+        void close_gap(uint64_t hole, size_t stripe);
+        bool move_slot(uint64_t from, uint64_t to, uint64_t hash);
+        void reclaim_tombstones(uint64_t index);
+        Probe read_slot(MapSlot* slot, uint64_t hash, const uint8_t* key, size_t key_length,
+                        void* value, size_t* value_length) const;
+
+        std::shared_ptr<SharedMemoryManager> manager_;  // 保持映射有效
+        MapHeader* header_;         // 控制块
+        uint8_t* slots_;            // 桶数组
+        uint64_t mask_;             // 桶号掩码
+    };
+
+    // 等待结果，与 Atomics.wait 的返回值一致
+    enum class WaitResult {
+        Ok,         // 被唤醒
+        NotEqual,   // 值与期望不符，未进入等待
+        TimedOut    // 超时
+    };
+
+    /**
+     * 在共享内存中的 32 位字上等待，值不等于 expected 时立即返回
+     * @param addr 等待字地址
+     * @param expected 期望值
+     * @param timeout_ms 超时毫秒数，负数表示无限等待
+     */
+    WaitResult futex_wait(std::atomic<uint32_t>* addr, uint32_t expected, double timeout_ms);
+
+    /**
+     * 唤醒在 32 位字上等待的进程
+     * @param addr 等待字地址
+     * @param count 最多唤醒的数量
+     * @return 实际唤醒的数量
+     */
+    int futex_wake(std::atomic<uint32_t>* addr, int count);
+
+    // 等待结果对应的字符串
+    const char* wait_result_name(WaitResult result);
+
+    // 校验和算法
+    enum class ChecksumAlgorithm {
+        Crc32c,     // CRC32C（Castagnoli），可按块接续计算
+        Xxh3        // 64 位 XXH3
+    };
+
+    // 校验和算法对应的字符串
+    const char* checksum_name(ChecksumAlgorithm algorithm);
+
+    // 解析 "crc32c" | "xxh3"
+    bool parse_checksum(const std::string& name, ChecksumAlgorithm& algorithm);
+
+    // 批量操作当前使用的实现："avx2"、"sse4.2" 或 "scalar"，首次调用时按 CPU 检测
+    const char* bulk_kernels();
+
+    /**
+     * 指定批量操作使用的实现，用于对比测试和基准测试
+     * @param name 实现名称，空字符串或 "auto" 恢复自动检测
+     * @return CPU 不支持或名称无效时返回 false
+     */
+    bool select_bulk_kernels(const std::string& name);
+
+    /**
+     * 复制字节，允许重叠；不重叠的大块复制使用非临时存储，不把目标写入缓存
+     * @param dst 目标地址
+     * @param src 源地址
+     * @param length 字节数
+     */
+    void copy_bytes(void* dst, const void* src, size_t length);
+
+    /**
+     * 填充字节，大块填充使用非临时存储
+     * @param dst 目标地址
+     * @param value 填充值
+     * @param length 字节数
+     */
+    void fill_bytes(void* dst, uint8_t value, size_t length);
+
+    /**
+     * 比较两段字节
+     * @return 第一个不同字节的下标，完全相同时返回 length
+     */
+    size_t compare_bytes(const void* a, const void* b, size_t length);
+
+    /**
+     * 查找字节
+     * @return 第一个等于 value 的字节的下标，没有时返回 length
+     */
+    size_t find_byte(const void* data, size_t length, uint8_t value);
+
+    /**
+     * CRC32C 校验和
+     * @param crc 前一段数据的结果，分块计算时依次传入，首段为 0
+     */
+    uint32_t crc32c(const void* data, size_t length, uint32_t crc = 0);
+
+    /**
+     * 64 位 XXH3 校验和
+     * @param seed 种子
+     */
+    uint64_t xxh3_64(const void* data, size_t length, uint64_t seed = 0);
+
+    // 映射缓存统计
+    struct CacheStats {
+        uint64_t hits;        // 命中次数
+        uint64_t misses;      // 未命中次数
+        uint64_t entries;     // 当前存活的映射数
+    };
+
+    /**
+     * 从进程内映射缓存获取共享内存，未命中时打开已有的共享内存
+     * @param key 共享内存键名
+     * @param timeout_ms 获取互斥锁的超时毫秒数，负数表示使用平台默认值
+     * @param options 映射选项，缓存命中时应用到已有映射
+     * @return 共享内存管理器
+     */
+    std::shared_ptr<SharedMemoryManager> acquire_manager(const std::string& key, int timeout_ms = -1,
+                                                         const MapOptions& options = MapOptions());
+
+    /**
+     * 创建共享内存并替换缓存中的映射
+     * @param key 共享内存键名
+     * @param size 数据区大小
+     * @param timeout_ms 获取互斥锁的超时毫秒数，负数表示使用平台默认值
+     * @param options 映射选项
+     * @return 共享内存管理器
+     */
+    std::shared_ptr<SharedMemoryManager> create_manager(const std::string& key, size_t size, int timeout_ms = -1,
+                                                        const MapOptions& options = MapOptions(),
+                                                        Backend backend = Backend::Named);
+
+    /**
+     * 把映射放入缓存，替换同名的旧映射
+     * @param key 共享内存键名
+     * @param manager 共享内存管理器
+     */
+    void cache_manager(const std::string& key, const std::shared_ptr<SharedMemoryManager>& manager);
+
+    /**
+     * 键名在缓存中没有存活的映射时放入缓存
+     * @param key 共享内存键名
+     * @param manager 共享内存管理器
+     * @return 是否放入；已有存活的映射时返回 false，缓存不变
+     */
+    bool cache_new_manager(const std::string& key, const std::shared_ptr<SharedMemoryManager>& manager);
+
+    /**
+     * 键名在缓存中是否有存活的映射
+     * @param key 共享内存键名
+     */
+    bool manager_cached(const std::string& key);
+
+    /**
+     * 将映射移出缓存，已返回的 ArrayBuffer 不受影响
+     * @param key 共享内存键名
+     */
+    void evict_manager(const std::string& key);
+
+    /**
+     * 获取映射缓存统计
+     */
+    CacheStats get_cache_stats();
+
+    /**
+     * 缓存中仍存活的映射
+     * @return 键名与共享内存管理器
+     */
+    std::vector<std::pair<std::string, std::shared_ptr<SharedMemoryManager>>> cached_managers();
+
+    /**
+     * 固定映射并返回句柄，句柄可经 postMessage/workerData 交给同一进程中的其他环境，取出前映射保持有效
+     * @param manager 共享内存管理器
+     * @return 句柄，从 1 开始
+     */
+    uint32_t pin_manager(std::shared_ptr<SharedMemoryManager> manager);
+
+    /**
+     * 取出句柄对应的映射并解除固定，每个句柄只能取出一次
+     * @param handle pin_manager 返回的句柄
+     * @return 共享内存管理器，句柄无效或已取出时返回 nullptr
+     */
+    std::shared_ptr<SharedMemoryManager> take_pinned(uint32_t handle);
+
+    /**
+     * 创建共享内存并初始化数据区（清零并写入 key），新分配的页面已由系统清零，不再逐页写入
+     * @param key 共享内存键名
+     * @param length 数据区大小
+     * @param timeout_ms 获取互斥锁的超时毫秒数，负数表示使用平台默认值
+     * @param options 映射选项
+     * @param backend 存储后端
+     * @return 共享内存管理器
+     */
+    std::shared_ptr<SharedMemoryManager> create_segment(const std::string& key, size_t length, int timeout_ms = -1,
+                                                        const MapOptions& options = MapOptions(),
+                                                        Backend backend = Backend::Named);
+
+    /**
+     * 以 memfd_create 创建匿名共享内存（不放入缓存），对象可加封印
+     * @param key 进程内的键名，同时作为 memfd 的名称（/proc/<pid>/fd 中可见）
+     * @param size 数据区大小
+     * @param timeout_ms 获取互斥锁的超时毫秒数
+     * @param options 映射选项，explicit 大页降级为透明大页
+     * @return 共享内存管理器，Windows 上抛出异常
+     */
+    std::shared_ptr<SharedMemoryManager> create_memfd(const std::string& key, size_t size, int timeout_ms = -1,
+                                                      const MapOptions& options = MapOptions());
+
+    /**
+     * 创建一对相连的 Unix 套接字（SOCK_SEQPACKET），用于同一进程内或经 stdio 继承交给子进程
+     * @param first 第一个套接字
+     * @param second 第二个套接字
+     */
+    void create_socket_pair(int& first, int& second);
+
+    /**
+     * 经 Unix 套接字发送共享内存的文件描述符和键名（SCM_RIGHTS），接收方得到同一对象
+     * @param socket Unix 套接字（SOCK_STREAM、SOCK_SEQPACKET 或已连接的 SOCK_DGRAM）
+     * @param manager 共享内存管理器
+     */
+    void export_segment(int socket, const std::shared_ptr<SharedMemoryManager>& manager);
+
+    /**
+     * 从 Unix 套接字接收 export_segment 发送的共享内存并放入缓存，之后可按发送方的键名（或 local_key）获取；
+     * 本进程中该键名已有存活的映射时关闭收到的描述符并抛出异常，不覆盖本地映射
+     * @param socket Unix 套接字
+     * @param timeout_ms 等待消息和获取互斥锁的超时毫秒数，负数表示无限等待
+     * @param options 映射选项
+     * @param local_key 本地使用的键名，为空时使用发送方的键名
+     * @return 共享内存管理器
+     */
+    std::shared_ptr<SharedMemoryManager> import_segment(int socket, int timeout_ms = -1,
+                                                        const MapOptions& options = MapOptions(),
+                                                        const std::string& local_key = std::string());
+
+    /**
+     * 删除共享内存的名称，已映射的进程不受影响，内存在最后一个映射释放后由系统回收
+     * @param key 共享内存键名
+     * @return 是否删除了已存在的对象
+     */
+    bool remove_segment(const std::string& key);
+
+    // 共享内存对象的附加信息，由 list_segments 返回
+    struct SegmentInfo {
+        std::string key;                    // 键名
+        std::string path;                   // shm_open 名称或 hugetlbfs 上的文件路径
+        uint64_t object_size = 0;           // 对象大小（含头部）
+        bool legacy = false;                // 旧版 16 字节头部
+        bool tracked = false;               // 头部有附加记录
+        bool removed = false;               // 已调用 removeMemory
+        uint32_t creator_pid = 0;           // 创建者进程号
+        uint32_t attached = 0;              // 附加计数
+        std::vector<uint32_t> owners;       // 仍存活的附加进程；其他 PID 命名空间中为记录的全部进程号
+        bool foreign = false;               // 创建者位于其他（或未知的）PID 命名空间，无法判断进程是否存活
+        bool orphaned = false;              // 创建者和所有附加进程均已退出，可回收
+    };
+
+    /**
+     * 进程是否存活（kill(pid, 0)，无权限发送信号也视为存活）；只对本 PID 命名空间中的进程号有意义
+     * @param pid 进程号
+     * @return 是否存活
+     */
+    bool process_alive(uint32_t pid);
+
+    /**
+     * 获取共享内存中的跨进程自旋锁，锁字保存持有者进程号，0 表示未锁定；
+     * 持有者已退出而未释放时接管（保护的数据可能只改了一半），等待超过 timeout_ms 时抛出异常
+     * @param lock 锁字
+     * @param local 本进程与创建者位于同一 PID 命名空间；否则锁字记为未知持有者，也不据此判断其他持有者是否存活
+     * @param timeout_ms 最长等待毫秒数
+     */
+    void lock_spin(std::atomic<uint32_t>& lock, bool local, int timeout_ms);
+
+    /**
+     * 不等待地获取跨进程自旋锁
+     * @param lock 锁字
+     * @param local 同 lock_spin
+     * @return 是否获取成功
+     */
+    bool try_lock_spin(std::atomic<uint32_t>& lock, bool local);
+
+    // 释放跨进程自旋锁
+    inline void unlock_spin(std::atomic<uint32_t>& lock) {
+        lock.store(0, std::memory_order_release);
+    }
+
+    /**
+     * 本进程所在 PID 命名空间的标识（/proc/self/ns/pid 的 inode 低 32 位），无法获取时为 0；
+     * 头部记录创建者的命名空间，不同命名空间中的进程号不登记、不判断存活
+     * @return 命名空间标识
+     */
+    uint32_t pid_namespace();
+
+    /**
+     * 列出本机上的全部共享内存对象（/dev/shm 与 hugetlbfs），只读取头部，不登记附加
+     * @return 共享内存对象信息，Windows 上为空
+     */
+    std::vector<SegmentInfo> list_segments();
+
+    /**
+     * 删除创建者和所有附加进程均已退出的共享内存对象，以及没有对应对象的旧版信号量；
+     * 删除前在头部互斥锁内重新检查，期间附加或重新创建的共享内存不删除
+     * @param dry_run 只列出不删除
+     * @return 回收的共享内存对象
+     */
+    std::vector<SegmentInfo> collect_orphans(bool dry_run = false);
+
+    /**
+     * 把源共享内存中的变更区间复制到目标共享内存，目标较小时先扩展，复制后在目标上标记这些区间
+     * @param target 目标共享内存，需以读写方式映射
+     * @param source 变更所在的共享内存
+     * @param ranges collect_dirty 得到的变更区间
+     * @return 复制的字节数
+     */
+    uint64_t apply_delta(const std::shared_ptr<SharedMemoryManager>& target,
+                         const std::shared_ptr<SharedMemoryManager>& source, const std::vector<DirtyRange>& ranges);
+
+    /**
+     * 把按区间顺序首尾相接的变更数据写入目标共享内存，用于数据经其他途径传输的副本
+     * @param target 目标共享内存，需以读写方式映射
+     * @param data 变更数据
+     * @param length 变更数据的字节数，不能少于区间长度之和
+     * @param ranges 变更区间
+     * @return 写入的字节数
+     */
+    uint64_t apply_delta(const std::shared_ptr<SharedMemoryManager>& target, const uint8_t* data, size_t length,
+                         const std::vector<DirtyRange>& ranges);
+
+    /**
+     * 原生生产者的写入作用域：获取写锁并开始顺序锁写入，析构时结束写入并释放写锁，
+     * 作用域内直接写入数据区，JS 侧的 readLock/readConsistent 看到的是完整的一次写入
+     */
+    class WriteScope {
+    public:
+        /**
+         * @param manager 共享内存管理器，旧版共享内存没有读写锁，只使用顺序锁
+         * @param timeout_ms 获取写锁的超时毫秒数，负数表示无限等待，超时抛出 std::runtime_error
+         */
+        explicit WriteScope(std::shared_ptr<SharedMemoryManager> manager, double timeout_ms = -1);
+        ~WriteScope();
+
+        WriteScope(const WriteScope&) = delete;
+        WriteScope& operator=(const WriteScope&) = delete;
+
+        // 数据区地址与大小
+        uint8_t* data() const { return manager_->get_data(); }
+        size_t size() const { return manager_->get_size(); }
+
+    private:
+        std::shared_ptr<SharedMemoryManager> manager_;
+        bool locked_;               // 是否持有写锁
+    };
+}
+#endif
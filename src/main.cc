@@ -1,33 +1,126 @@
 #include <sys/types.h>
 #include "./memory.hh"
 #include <napi.h>
-#include <cstdlib>
 
 Napi::Value version(const Napi::CallbackInfo &info) {
   
   return Napi::String::New(info.Env(), "1352");
 }
 
-// 模块卸载时的清理函数
-static void Cleanup() {
-  SharedMemory::cleanup_console();
-}
-
 static Napi::Object Init(Napi::Env env, Napi::Object exports) {
+  // 每个环境（主线程或 worker_threads）各自的类引用和控制台回调，映射缓存在进程内共享
+  SharedMemory::init_addon_data(env);
+
   exports.Set(Napi::String::New(env, "setConsole"),
               Napi::Function::New(env, SharedMemory::set_console));
   exports.Set(Napi::String::New(env, "setMemory"),
               Napi::Function::New(env, SharedMemory::set_memory));
   exports.Set(Napi::String::New(env, "getMemory"),
               Napi::Function::New(env, SharedMemory::get_memory));
+  exports.Set(Napi::String::New(env, "getWindow"),
+              Napi::Function::New(env, SharedMemory::get_window));
+  exports.Set(Napi::String::New(env, "copyRegion"),
+              Napi::Function::New(env, SharedMemory::copy_region));
+  exports.Set(Napi::String::New(env, "fillRegion"),
+              Napi::Function::New(env, SharedMemory::fill_region));
+  exports.Set(Napi::String::New(env, "compareRegions"),
+              Napi::Function::New(env, SharedMemory::compare_regions));
+  exports.Set(Napi::String::New(env, "findByte"),
+              Napi::Function::New(env, SharedMemory::find_byte_in));
+  exports.Set(Napi::String::New(env, "checksum"),
+              Napi::Function::New(env, SharedMemory::checksum));
+  exports.Set(Napi::String::New(env, "bulkKernels"),
+              Napi::Function::New(env, SharedMemory::get_bulk_kernels));
+  exports.Set(Napi::String::New(env, "markDirty"),
+              Napi::Function::New(env, SharedMemory::mark_dirty));
+  exports.Set(Napi::String::New(env, "collectDelta"),
+              Napi::Function::New(env, SharedMemory::collect_delta));
+  exports.Set(Napi::String::New(env, "applyDelta"),
+              Napi::Function::New(env, SharedMemory::apply_delta_to));
   exports.Set(Napi::String::New(env, "removeMemory"),
               Napi::Function::New(env, SharedMemory::remove_memory));
+  exports.Set(Napi::String::New(env, "listSegments"),
+              Napi::Function::New(env, SharedMemory::list_memory));
+  exports.Set(Napi::String::New(env, "gc"),
+              Napi::Function::New(env, SharedMemory::gc_memory));
+  exports.Set(Napi::String::New(env, "resizeMemory"),
+              Napi::Function::New(env, SharedMemory::resize_memory));
+  exports.Set(Napi::String::New(env, "refresh"),
+              Napi::Function::New(env, SharedMemory::refresh_memory));
+  exports.Set(Napi::String::New(env, "getGeneration"),
+              Napi::Function::New(env, SharedMemory::get_generation));
+  exports.Set(Napi::String::New(env, "shareMemory"),
+              Napi::Function::New(env, SharedMemory::share_memory));
+  exports.Set(Napi::String::New(env, "attachMemory"),
+              Napi::Function::New(env, SharedMemory::attach_memory));
+  exports.Set(Napi::String::New(env, "socketPair"),
+              Napi::Function::New(env, SharedMemory::socket_pair));
+  exports.Set(Napi::String::New(env, "exportFd"),
+              Napi::Function::New(env, SharedMemory::export_fd));
+  exports.Set(Napi::String::New(env, "importFd"),
+              Napi::Function::New(env, SharedMemory::import_fd));
+  exports.Set(Napi::String::New(env, "importFdAsync"),
+              Napi::Function::New(env, SharedMemory::import_fd_async));
+  exports.Set(Napi::String::New(env, "sealMemory"),
+              Napi::Function::New(env, SharedMemory::seal_memory));
+  exports.Set(Napi::String::New(env, "getMemoryInfo"),
+              Napi::Function::New(env, SharedMemory::get_memory_info));
+  exports.Set(Napi::String::New(env, "setMemoryAsync"),
+              Napi::Function::New(env, SharedMemory::set_memory_async));
+  exports.Set(Napi::String::New(env, "getMemoryAsync"),
+              Napi::Function::New(env, SharedMemory::get_memory_async));
+  exports.Set(Napi::String::New(env, "removeMemoryAsync"),
+              Napi::Function::New(env, SharedMemory::remove_memory_async));
+  exports.Set(Napi::String::New(env, "warm"),
+              Napi::Function::New(env, SharedMemory::warm));
+  exports.Set(Napi::String::New(env, "getCacheStats"),
+              Napi::Function::New(env, SharedMemory::cache_stats));
+  exports.Set(Napi::String::New(env, "getStats"),
+              Napi::Function::New(env, SharedMemory::get_stats));
+  exports.Set(Napi::String::New(env, "createRing"),
+              Napi::Function::New(env, SharedMemory::create_ring));
+  exports.Set(Napi::String::New(env, "openRing"),
+              Napi::Function::New(env, SharedMemory::open_ring));
+  SharedMemory::init_ring_channel(env, exports);
+  exports.Set(Napi::String::New(env, "createHeap"),
+              Napi::Function::New(env, SharedMemory::create_heap));
+  exports.Set(Napi::String::New(env, "openHeap"),
+              Napi::Function::New(env, SharedMemory::open_heap));
+  SharedMemory::init_heap(env, exports);
+  exports.Set(Napi::String::New(env, "createMap"),
+              Napi::Function::New(env, SharedMemory::create_map));
+  exports.Set(Napi::String::New(env, "openMap"),
+              Napi::Function::New(env, SharedMemory::open_map));
+  SharedMemory::init_hash_map(env, exports);
+  exports.Set(Napi::String::New(env, "wait"),
+              Napi::Function::New(env, SharedMemory::wait));
+  exports.Set(Napi::String::New(env, "waitAsync"),
+              Napi::Function::New(env, SharedMemory::wait_async));
+  exports.Set(Napi::String::New(env, "notify"),
+              Napi::Function::New(env, SharedMemory::notify));
+  exports.Set(Napi::String::New(env, "beginWrite"),
+              Napi::Function::New(env, SharedMemory::begin_write));
+  exports.Set(Napi::String::New(env, "endWrite"),
+              Napi::Function::New(env, SharedMemory::end_write));
+  exports.Set(Napi::String::New(env, "readConsistent"),
+              Napi::Function::New(env, SharedMemory::read_consistent));
+  exports.Set(Napi::String::New(env, "lock"),
+              Napi::Function::New(env, SharedMemory::lock));
+  exports.Set(Napi::String::New(env, "tryLock"),
+              Napi::Function::New(env, SharedMemory::try_lock));
+  exports.Set(Napi::String::New(env, "unlock"),
+              Napi::Function::New(env, SharedMemory::unlock));
+  exports.Set(Napi::String::New(env, "readLock"),
+              Napi::Function::New(env, SharedMemory::read_lock));
+  exports.Set(Napi::String::New(env, "readUnlock"),
+              Napi::Function::New(env, SharedMemory::read_unlock));
+  exports.Set(Napi::String::New(env, "writeLock"),
+              Napi::Function::New(env, SharedMemory::write_lock));
+  exports.Set(Napi::String::New(env, "writeUnlock"),
+              Napi::Function::New(env, SharedMemory::write_unlock));
   exports.Set(Napi::String::New(env, "version"),
               Napi::Function::New(env, version));
 
-  // 注册程序退出时的清理函数
-  std::atexit(Cleanup);
-
   return exports;
 }
 
@@ -3,83 +3,131 @@
 #ifndef MEMORY_HH
 #define MEMORY_HH
 #include "napi.h"
-#include <memory>
-#include <string>
-
-// 平台特定的头文件
-#ifdef _WIN32
-#include <windows.h>
-#else
-#include <fcntl.h>
-#include <sys/mman.h>
-#include <sys/stat.h>
-#include <unistd.h>
-#include <semaphore.h>
-#endif
+#include "core/shared_memory.hh"
+#include "core/logging.hh"
 
 namespace SharedMemory {
-    // 全局回调函数
-    extern Napi::FunctionReference console_callback;
+    // 每个 JS 环境（主线程或各个 worker_threads）各自的实例数据，通过 SetInstanceData 保存，环境销毁时释放
+    struct AddonData {
+        Napi::FunctionReference heap_constructor;       // Heap 类
+        Napi::FunctionReference ring_constructor;       // RingChannel 类
+        Napi::FunctionReference map_constructor;        // HashMap 类
+        Napi::ThreadSafeFunction console;               // setConsole 设置的回调
+    };
 
-    // 日志辅助函数
-    void log(const std::string& message);
-    void log(const char* format, ...);
+    /**
+     * 为当前环境创建实例数据，环境销毁时释放控制台回调
+     * @param env 运行环境
+     * @return 实例数据
+     */
+    AddonData& init_addon_data(Napi::Env env);
 
-    // 清理控制台回调函数
-    void cleanup_console();
+    /**
+     * 获取当前环境的实例数据
+     * @param env 运行环境
+     * @return 实例数据
+     */
+    AddonData& addon_data(Napi::Env env);
 
-    // 共享内存头部结构
-    struct SharedMemoryHeader {
-        size_t size;          // 用户数据大小
-        int version;          // 版本号
-    };
+    /**
+     * 释放环境的控制台回调；该环境正在接收日志时，交给之前设置过回调且仍存活的环境
+     * @param data 实例数据
+     */
+    void cleanup_console(AddonData& data);
 
-    // 共享内存管理器类
-    class SharedMemoryManager : public std::enable_shared_from_this<SharedMemoryManager> {
-    public:
-        // 构造函数
-        SharedMemoryManager(const std::string& key, bool create = false, size_t size = 0);
-        
-        // 析构函数
-        ~SharedMemoryManager();
-        
-        // 获取共享内存地址
-        void* get_address() const { return address_; }
-        
-        // 获取共享内存大小
-        size_t get_size() const { return size_; }
-        
-        // 获取文件路径
-        const std::string& get_file_path() const { return file_path_; }
-        
-        // 获取版本号
-        int get_version() const { 
-            if (address_) {
-                return static_cast<SharedMemoryHeader*>(address_)->version;
-            }
-            return 0;
-        }
-        
-    private:
-        std::string key_;           // 共享内存键名
-        size_t size_;               // 数据区大小
-        void* address_;             // 共享内存地址
-        std::string file_path_;     // 文件路径
-
-#ifdef _WIN32
-        HANDLE file_mapping_;       // 文件映射句柄
-        HANDLE mutex_;              // 互斥锁句柄
-        
-        // 创建文件映射
-        bool create_mapping(HANDLE file_handle, size_t mapping_size);
-#else
-        sem_t* mutex_;              // 互斥锁
-#endif
-    };
+    /**
+     * 创建指向共享内存数据区的 ArrayBuffer，ArrayBuffer 被回收前映射保持有效
+     * @param env 运行环境
+     * @param manager 共享内存管理器
+     * @param copy 返回当前内容的副本而不是指向映射的视图，用于只读映射上需要可写 ArrayBuffer 的场合
+     * @return 共享内存的视图
+     */
+    Napi::ArrayBuffer wrap_buffer(Napi::Env env, const std::shared_ptr<SharedMemoryManager>& manager, bool copy = false);
+
+    /**
+     * 创建指向数据区 [offset, offset + length) 的 ArrayBuffer，用于超出单个 ArrayBuffer 上限的大共享内存
+     * @param env 运行环境
+     * @param manager 共享内存管理器
+     * @param offset 数据区偏移
+     * @param length 窗口长度
+     * @param copy 同 wrap_buffer
+     * @return 共享内存的视图，copy 为 true 时为副本
+     */
+    Napi::ArrayBuffer wrap_window(Napi::Env env, const std::shared_ptr<SharedMemoryManager>& manager, size_t offset, size_t length,
+                                  bool copy = false);
+
+    /**
+     * 创建指向共享内存数据区的 SharedArrayBuffer，可直接用于 Atomics，传给 worker 时不拷贝；
+     * 通过 node_api 的外部 SharedArrayBuffer 创建，回收时释放管理器的引用
+     * @param env 运行环境
+     * @param manager 共享内存管理器
+     * @return 共享内存的视图，构建时关闭 SHARED_MEMORY_SHARED_ARRAY_BUFFER 或 node_api 不提供外部 SharedArrayBuffer 时抛出异常
+     */
+    Napi::Value wrap_shared_buffer(Napi::Env env, const std::shared_ptr<SharedMemoryManager>& manager);
+
+    /**
+     * shared 为 true 时返回 SharedArrayBuffer，否则返回 ArrayBuffer；copy 为 true 时返回当前内容的副本，
+     * SharedArrayBuffer 不能是副本，两者同时传入时抛出异常
+     * @param env 运行环境
+     * @param manager 共享内存管理器
+     * @param shared 是否返回 SharedArrayBuffer
+     * @param copy 是否返回副本
+     * @return 共享内存的视图
+     */
+    Napi::Value wrap_memory(Napi::Env env, const std::shared_ptr<SharedMemoryManager>& manager, bool shared, bool copy);
+
+    /**
+     * 按选项中的 shared 和 copy 创建视图，见上
+     * @param env 运行环境
+     * @param manager 共享内存管理器
+     * @param options 选项对象，可为 undefined
+     * @return 共享内存的视图
+     */
+    Napi::Value wrap_memory(Napi::Env env, const std::shared_ptr<SharedMemoryManager>& manager, const Napi::Value& options);
+
+    /**
+     * 选项中是否要求 SharedArrayBuffer（{ shared: true }）
+     * @param options 选项对象，可为 undefined
+     * @return 是否返回 SharedArrayBuffer
+     */
+    bool shared_arg(const Napi::Value& options);
+
+    /**
+     * 读取选项中的 copy：返回当前内容的副本而不是指向映射的视图
+     * @param options 选项对象，可为 undefined
+     * @return 是否返回副本
+     */
+    bool copy_arg(const Napi::Value& options);
+
+    /**
+     * 读取 64 位大小参数，接受 BigInt 或安全整数范围内的 Number
+     * @param env 运行环境
+     * @param value JS 值
+     * @param name 参数名，用于错误信息
+     * @return 大小
+     */
+    uint64_t size_arg(Napi::Env env, const Napi::Value& value, const char* name);
+
+    /**
+     * 从 ArrayBuffer / TypedArray / Buffer 中取出字节区间
+     * @param value JS 值
+     * @param data 字节起始地址
+     * @param length 字节长度
+     * @return 类型不支持时返回 false
+     */
+    bool get_bytes(const Napi::Value& value, uint8_t*& data, size_t& length);
+
+    /**
+     * 读取映射选项 { hugePages, populate, lock, mode, trackDirty }
+     * @param env 运行环境
+     * @param value JS 值，undefined 表示使用默认值
+     * @return 映射选项
+     */
+    MapOptions map_options_arg(Napi::Env env, const Napi::Value& value);
 
     /**
      * 设置控制台回调函数
-     * @param info 回调信息
+     * @param info 回调信息 (callback | null[, level])
      * @return undefined
      */
     Napi::Value set_console(const Napi::CallbackInfo &info);
@@ -92,17 +140,378 @@ namespace SharedMemory {
     Napi::Value set_memory(const Napi::CallbackInfo &info);
 
     /**
-     * 获取共享内存
-     * @param info 回调信息
+     * 获取共享内存；mode 为 'readonly' 时以只读方式映射，返回不拷贝的视图，ArrayBuffer 无法设为只读，
+     * 经视图写入会使进程崩溃；需要可写的 ArrayBuffer 时传入 copy: true 得到当前内容的副本（不随共享内存变化，
+     * 也不保持映射）。为 'private' 时为写时复制映射，写入只在本进程可见，未写过的页面仍随共享内存变化
+     * @param info 回调信息 (key[, { mode, copy, hugePages, populate, lock, shared }])
      * @return 共享内存的视图
      */
     Napi::Value get_memory(const Napi::CallbackInfo &info);
 
+    /**
+     * 获取共享内存的一段窗口，映射为只读（已封印写入的 memfd）时与只读的 getMemory 相同，写入会使进程崩溃；
+     * 传入 copy: true 时返回这段内容的副本
+     * @param info 回调信息 (key, offset, length[, { copy }])
+     * @return 共享内存窗口的视图
+     */
+    Napi::Value get_window(const Napi::CallbackInfo &info);
+
+    /**
+     * 在共享内存之间复制一段数据，同一共享内存内的区间可以重叠，目标启用变更跟踪时标记写入的区间；
+     * 不加锁，需要一致性时在 beginWrite/lock 之内调用
+     * @param info 回调信息 (srcKey, srcOffset, dstKey, dstOffset, length)
+     * @return undefined
+     */
+    Napi::Value copy_region(const Napi::CallbackInfo &info);
+
+    /**
+     * 填充一段数据，启用变更跟踪时标记填充的区间
+     * @param info 回调信息 (key, offset, length[, value = 0])
+     * @return undefined
+     */
+    Napi::Value fill_region(const Napi::CallbackInfo &info);
+
+    /**
+     * 比较两段数据
+     * @param info 回调信息 (keyA, offsetA, keyB, offsetB, length)
+     * @return 第一个不同字节相对区间起点的下标，完全相同时为 -1
+     */
+    Napi::Value compare_regions(const Napi::CallbackInfo &info);
+
+    /**
+     * 查找字节
+     * @param info 回调信息 (key, offset, length, value)
+     * @return 第一个等于 value 的字节在数据区中的偏移，没有时为 -1
+     */
+    Napi::Value find_byte_in(const Napi::CallbackInfo &info);
+
+    /**
+     * 计算一段数据的校验和
+     * @param info 回调信息 (key, offset, length[, algorithm = 'crc32c' | 'xxh3'])
+     * @return crc32c 为无符号 32 位数字，xxh3 为 64 位 BigInt
+     */
+    Napi::Value checksum(const Napi::CallbackInfo &info);
+
+    /**
+     * 批量操作使用的实现
+     * @return 'avx2' | 'sse4.2' | 'scalar'
+     */
+    Napi::Value get_bulk_kernels(const Napi::CallbackInfo &info);
+
+    /**
+     * 标记被修改的区间，以 setMemory(key, length, { trackDirty }) 创建的共享内存在视图中写入后调用；
+     * 标记不加锁，收集时仍在写入的块会在下一次收集中再次出现
+     * @param info 回调信息 (key, offset, length)
+     * @return undefined
+     */
+    Napi::Value mark_dirty(const Napi::CallbackInfo &info);
+
+    /**
+     * 收集 sinceEpoch 之后被标记的区间，返回的 epoch 作为下一次收集的 sinceEpoch，0 表示全部
+     * @param info 回调信息 (key, sinceEpoch[, { data }])
+     * @return { key, epoch, size, blockSize, ranges: [{ offset, length }], bytes, data? }，
+     *         data 为 true 时附带各区间首尾相接的 ArrayBuffer
+     */
+    Napi::Value collect_delta(const Napi::CallbackInfo &info);
+
+    /**
+     * 把 collectDelta 的结果写入目标共享内存，有 data 时从 data 复制，否则从 delta.key 复制；目标较小时先扩展
+     * @param info 回调信息 (targetKey, delta)
+     * @return 写入的字节数
+     */
+    Napi::Value apply_delta_to(const Napi::CallbackInfo &info);
+
     /**
      * 删除共享内存
      * @param info 回调信息
      * @return 是否成功
      */
     Napi::Boolean remove_memory(const Napi::CallbackInfo &info);
+
+    /**
+     * setMemory 的异步版本，在线程池中创建共享内存
+     * @param info 回调信息 (key, length[, timeoutMs])
+     * @return Promise<ArrayBuffer>
+     */
+    Napi::Value set_memory_async(const Napi::CallbackInfo &info);
+
+    /**
+     * getMemory 的异步版本，在线程池中打开共享内存
+     * @param info 回调信息 (key[, timeoutMs])
+     * @return Promise<ArrayBuffer>
+     */
+    Napi::Value get_memory_async(const Napi::CallbackInfo &info);
+
+    /**
+     * 在工作线程中并行预取共享内存的全部页面
+     * @param info 回调信息 (key[, { threads }])
+     * @return Promise<number> 预取的字节数
+     */
+    Napi::Value warm(const Napi::CallbackInfo &info);
+
+    /**
+     * removeMemory 的异步版本
+     * @param info 回调信息 (key)
+     * @return Promise<boolean>
+     */
+    Napi::Value remove_memory_async(const Napi::CallbackInfo &info);
+
+    /**
+     * 扩展共享内存
+     * @param info 回调信息 (key, newSize[, { shared }])
+     * @return 新大小的共享内存视图
+     */
+    Napi::Value resize_memory(const Napi::CallbackInfo &info);
+
+    /**
+     * 检查代数，其他进程扩展过共享内存时重新映射
+     * @param info 回调信息 (key)
+     * @return 是否重新映射
+     */
+    Napi::Value refresh_memory(const Napi::CallbackInfo &info);
+
+    /**
+     * 获取共享内存的映射信息
+     * @param info 回调信息 (key)
+     * @return { size, dataOffset, legacy, hugePages, hugePageSize, populated, locked, backend, mode, readOnly, dirtyBlockSize, dirtyEpoch, seals, attached, removed }
+     */
+    Napi::Value get_memory_info(const Napi::CallbackInfo &info);
+
+    /**
+     * 固定共享内存的映射，返回可经 postMessage/workerData 传给 worker_threads 的句柄
+     * @param info 回调信息 (key)
+     * @return 句柄
+     */
+    Napi::Value share_memory(const Napi::CallbackInfo &info);
+
+    /**
+     * 在当前环境中取出句柄对应的映射，与 shareMemory 的调用方共用同一个 mmap，每个句柄只能取出一次
+     * @param info 回调信息 (handle[, { shared }])
+     * @return 共享内存的 ArrayBuffer，shared 为 true 时为 SharedArrayBuffer
+     */
+    Napi::Value attach_memory(const Napi::CallbackInfo &info);
+
+    /**
+     * 创建一对相连的 Unix 套接字，可经 child_process 的 stdio 交给子进程，用于 exportFd/importFd
+     * @param info 回调信息
+     * @return [fd, fd]，用 fs.closeSync 关闭
+     */
+    Napi::Value socket_pair(const Napi::CallbackInfo &info);
+
+    /**
+     * 经 Unix 套接字把共享内存的文件描述符和键名发给其他进程（memfd 和命名对象均可）
+     * @param info 回调信息 (key, socket)
+     */
+    Napi::Value export_fd(const Napi::CallbackInfo &info);
+
+    /**
+     * 从 Unix 套接字接收 exportFd 发送的共享内存并放入缓存，之后可按发送方的键名（或 key）getMemory；
+     * 本进程中该键名已有映射时报错，不覆盖。在 JS 线程中等待，timeoutMs 缺省为 0 且必须是有限值；
+     * 已封印写入的对象以只读方式映射，buffer 与只读的 getMemory 相同，经其写入会使进程崩溃，传入 copy 时为副本
+     * @param info 回调信息 (socket[, { timeoutMs, key, shared, copy, hugePages, populate, lock }])
+     * @return { key, buffer }
+     */
+    Napi::Value import_fd(const Napi::CallbackInfo &info);
+
+    /**
+     * 同 importFd，在线程池中等待，timeoutMs 缺省为无限等待
+     * @param info 回调信息 (socket[, { timeoutMs, key, shared, copy, hugePages, populate, lock }])
+     * @return Promise<{ key, buffer }>
+     */
+    Napi::Value import_fd_async(const Napi::CallbackInfo &info);
+
+    /**
+     * 封印 memfd 共享内存：总是禁止缩小，write 为 true 时同时禁止写入和扩展，本进程的映射变为只读；
+     * 本进程中仍有可写的视图（未被回收的 ArrayBuffer）时报错
+     * @param info 回调信息 (key[, { write }])
+     */
+    Napi::Value seal_memory(const Napi::CallbackInfo &info);
+
+    /**
+     * 列出本机上的共享内存对象及其附加进程；创建者在其他 PID 命名空间中时 foreignNamespace 为 true，不判断为孤立
+     * @param info 回调信息
+     * @return [{ key, path, size, legacy, tracked, removed, creatorPid, attached, owners, foreignNamespace, orphaned }]
+     */
+    Napi::Value list_memory(const Napi::CallbackInfo &info);
+
+    /**
+     * 回收创建者和所有附加进程均已退出的共享内存，删除前在头部互斥锁内重新检查
+     * @param info 回调信息 ([{ dryRun }])
+     * @return 回收的共享内存，格式同 listSegments
+     */
+    Napi::Value gc_memory(const Napi::CallbackInfo &info);
+
+    /**
+     * 获取共享内存头部记录的代数
+     * @param info 回调信息 (key)
+     * @return 代数
+     */
+    Napi::Value get_generation(const Napi::CallbackInfo &info);
+
+    /**
+     * 获取映射缓存统计
+     * @param info 回调信息
+     * @return { hits, misses, entries }
+     */
+    Napi::Value cache_stats(const Napi::CallbackInfo &info);
+
+    /**
+     * 获取全局统计和各共享内存的统计
+     * @param info 回调信息 ([key])，缺省时返回本进程缓存中的全部共享内存
+     * @return { global, segments: { [key]: {...} } }
+     */
+    Napi::Value get_stats(const Napi::CallbackInfo &info);
+
+    /**
+     * 注册环形缓冲区通道类
+     * @param env 运行环境
+     * @param exports 模块导出对象
+     */
+    void init_ring_channel(Napi::Env env, Napi::Object exports);
+
+    /**
+     * 阻塞等待数据区 offset 处的 32 位值被修改并唤醒
+     * @param info 回调信息 (key, offset, expected, timeoutMs)
+     * @return "ok" | "not-equal" | "timed-out"
+     */
+    Napi::Value wait(const Napi::CallbackInfo &info);
+
+    /**
+     * wait 的异步版本，在线程池中等待
+     * @param info 回调信息 (key, offset, expected, timeoutMs)
+     * @return Promise<"ok" | "not-equal" | "timed-out">
+     */
+    Napi::Value wait_async(const Napi::CallbackInfo &info);
+
+    /**
+     * 唤醒在数据区 offset 处等待的进程
+     * @param info 回调信息 (key, offset, count)
+     * @return 唤醒的数量
+     */
+    Napi::Value notify(const Napi::CallbackInfo &info);
+
+    /**
+     * 开始写入数据区，版本号变为奇数；上一个写入者退出而未结束写入时自动恢复，
+     * 无法判断写入者是否存活（其他 PID 命名空间、旧版头部）时等待 timeoutMs（默认 1000，Infinity 表示无限等待）后抛出错误
+     * @param info 回调信息 (key[, timeoutMs])
+     * @return 当前版本号
+     */
+    Napi::Value begin_write(const Napi::CallbackInfo &info);
+
+    /**
+     * 结束写入数据区，版本号推进为偶数
+     * @param info 回调信息 (key)
+     * @return 新的版本号
+     */
+    Napi::Value end_write(const Napi::CallbackInfo &info);
+
+    /**
+     * 无锁读取数据区的一致快照
+     * @param info 回调信息 (key, offset, length, target[, timeoutMs])
+     * @return 快照对应的版本号
+     */
+    Napi::Value read_consistent(const Napi::CallbackInfo &info);
+
+    /**
+     * 获取共享内存的互斥锁，持有者退出后自动恢复
+     * @param info 回调信息 (key[, timeoutMs])
+     * @return "ok" | "recovered" | "busy"
+     */
+    Napi::Value lock(const Napi::CallbackInfo &info);
+
+    /**
+     * 尝试获取共享内存的互斥锁，不等待
+     * @param info 回调信息 (key)
+     * @return "ok" | "recovered" | "busy"
+     */
+    Napi::Value try_lock(const Napi::CallbackInfo &info);
+
+    /**
+     * 释放共享内存的互斥锁
+     * @param info 回调信息 (key)
+     */
+    Napi::Value unlock(const Napi::CallbackInfo &info);
+
+    /**
+     * 获取数据区读锁
+     * @param info 回调信息 (key[, timeoutMs])
+     * @return 是否获取成功，超时返回 false
+     */
+    Napi::Value read_lock(const Napi::CallbackInfo &info);
+
+    /**
+     * 释放数据区读锁
+     * @param info 回调信息 (key)
+     */
+    Napi::Value read_unlock(const Napi::CallbackInfo &info);
+
+    /**
+     * 获取数据区写锁
+     * @param info 回调信息 (key[, timeoutMs])
+     * @return 是否获取成功，超时返回 false
+     */
+    Napi::Value write_lock(const Napi::CallbackInfo &info);
+
+    /**
+     * 释放数据区写锁
+     * @param info 回调信息 (key)
+     */
+    Napi::Value write_unlock(const Napi::CallbackInfo &info);
+
+    /**
+     * 注册共享堆类
+     * @param env 运行环境
+     * @param exports 模块导出对象
+     */
+    void init_heap(Napi::Env env, Napi::Object exports);
+
+    /**
+     * 创建共享堆
+     * @param info 回调信息 (key, size)
+     * @return 堆对象
+     */
+    Napi::Value create_heap(const Napi::CallbackInfo &info);
+
+    /**
+     * 打开已有的共享堆
+     * @param info 回调信息 (key)
+     * @return 堆对象
+     */
+    Napi::Value open_heap(const Napi::CallbackInfo &info);
+
+    /**
+     * 注册共享哈希表类
+     * @param env 运行环境
+     * @param exports 模块导出对象
+     */
+    void init_hash_map(Napi::Env env, Napi::Object exports);
+
+    /**
+     * 创建共享哈希表
+     * @param info 回调信息 (key, capacity[, { keySize, valueSize }])
+     * @return 哈希表对象
+     */
+    Napi::Value create_map(const Napi::CallbackInfo &info);
+
+    /**
+     * 打开已有的共享哈希表
+     * @param info 回调信息 (key)
+     * @return 哈希表对象
+     */
+    Napi::Value open_map(const Napi::CallbackInfo &info);
+
+    /**
+     * 创建环形缓冲区通道
+     * @param info 回调信息
+     * @return 通道对象
+     */
+    Napi::Value create_ring(const Napi::CallbackInfo &info);
+
+    /**
+     * 打开已有的环形缓冲区通道
+     * @param info 回调信息
+     * @return 通道对象
+     */
+    Napi::Value open_ring(const Napi::CallbackInfo &info);
 }
 #endif
\ No newline at end of file
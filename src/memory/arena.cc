@@ -0,0 +1,129 @@
+#include "napi.h"
+#include "../memory.hh"
+#include <memory>
+
+namespace SharedMemory {
+    // 共享堆：多个小对象共用一个共享内存，以数据区偏移量互相引用
+    class Heap : public Napi::ObjectWrap<Heap> {
+    public:
+        static Napi::Function define(Napi::Env env) {
+            return DefineClass(env, "Heap", {
+                InstanceMethod("alloc", &Heap::alloc),
+                InstanceMethod("free", &Heap::free),
+                InstanceMethod("view", &Heap::view),
+            });
+        }
+
+        // new Heap(key) 打开，new Heap(key, size) 创建
+        Heap(const Napi::CallbackInfo &info) : Napi::ObjectWrap<Heap>(info) {
+            Napi::Env env = info.Env();
+
+            if (info.Length() < 1 || !info[0].IsString()) {
+                throw Napi::Error::New(env, "第一个参数必须是字符串类型的key");
+            }
+            std::string key = info[0].As<Napi::String>().Utf8Value();
+            bool create = info.Length() >= 2;
+
+            try {
+                if (create) {
+                    uint64_t size = size_arg(env, info[1], "size");
+                    if (size == 0) {
+                        throw Napi::Error::New(env, "size必须大于0");
+                    }
+                    auto manager = create_manager(key, SharedHeap::segment_size(static_cast<size_t>(size)));
+                    heap_ = std::make_unique<SharedHeap>(manager, true);
+                }
+                else {
+                    heap_ = std::make_unique<SharedHeap>(acquire_manager(key), false);
+                }
+                LOG_DEBUG("Heap %s: key=%s", create ? "created" : "opened", key.c_str());
+            } catch (const Napi::Error&) {
+                throw;
+            } catch (const std::exception& e) {
+                LOG_ERROR("Error: %s", e.what());
+                throw Napi::Error::New(env, e.what());
+            }
+        }
+
+    private:
+        // alloc(size) 返回数据区偏移，空间不足时返回 null
+        Napi::Value alloc(const Napi::CallbackInfo &info) {
+            Napi::Env env = info.Env();
+            if (info.Length() < 1) {
+                throw Napi::Error::New(env, "需要一个参数: size");
+            }
+            uint64_t size = size_arg(env, info[0], "size");
+            try {
+                uint64_t offset = heap_->alloc(static_cast<size_t>(size));
+                if (!offset) {
+                    return env.Null();
+                }
+                return Napi::Number::New(env, static_cast<double>(offset));
+            } catch (const std::exception& e) {
+                throw Napi::Error::New(env, e.what());
+            }
+        }
+
+        Napi::Value free(const Napi::CallbackInfo &info) {
+            Napi::Env env = info.Env();
+            if (info.Length() < 1) {
+                throw Napi::Error::New(env, "需要一个参数: offset");
+            }
+            uint64_t offset = size_arg(env, info[0], "offset");
+            try {
+                heap_->free(offset);
+            } catch (const std::exception& e) {
+                throw Napi::Error::New(env, e.what());
+            }
+            return env.Undefined();
+        }
+
+        // view(offset[, length]) 返回块的 ArrayBuffer 窗口，length 缺省为块的可用大小
+        Napi::Value view(const Napi::CallbackInfo &info) {
+            Napi::Env env = info.Env();
+            if (info.Length() < 1) {
+                throw Napi::Error::New(env, "需要一个参数: offset");
+            }
+            uint64_t offset = size_arg(env, info[0], "offset");
+            try {
+                size_t usable = heap_->usable_size(offset);
+                size_t length = usable;
+                if (info.Length() >= 2 && !info[1].IsUndefined()) {
+                    length = static_cast<size_t>(size_arg(env, info[1], "length"));
+                    if (length > usable) {
+                        throw Napi::RangeError::New(env, "length超过块的可用大小");
+                    }
+                }
+                return wrap_window(env, heap_->manager(), offset, length);
+            } catch (const Napi::Error&) {
+                throw;
+            } catch (const std::exception& e) {
+                throw Napi::Error::New(env, e.what());
+            }
+        }
+
+        std::unique_ptr<SharedHeap> heap_;
+    };
+
+    void init_heap(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = Heap::define(env);
+        addon_data(env).heap_constructor = Napi::Persistent(ctor);
+        exports.Set(Napi::String::New(env, "Heap"), ctor);
+    }
+
+    Napi::Value create_heap(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 2) {
+            throw Napi::Error::New(env, "需要两个参数: key和size");
+        }
+        return addon_data(env).heap_constructor.New({info[0], info[1]});
+    }
+
+    Napi::Value open_heap(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1) {
+            throw Napi::Error::New(env, "需要一个参数: key");
+        }
+        return addon_data(env).heap_constructor.New({info[0]});
+    }
+}
@@ -0,0 +1,170 @@
+#include "napi.h"
+#include "../memory.hh"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <memory>
+
+namespace SharedMemory {
+    // 在 libuv 线程池中执行打开/创建/删除/预取，结果通过 Promise 返回
+    class MemoryWorker : public Napi::AsyncWorker {
+    public:
+        enum class Action {
+            Set,
+            Get,
+            Remove,
+            Warm
+        };
+
+        MemoryWorker(Napi::Env env, Action action, std::string key, size_t length, int timeout_ms)
+            : Napi::AsyncWorker(env), deferred_(Napi::Promise::Deferred::New(env)),
+              action_(action), key_(std::move(key)), length_(length), timeout_ms_(timeout_ms),
+              removed_(false) {}
+
+        Napi::Promise promise() const { return deferred_.Promise(); }
+
+    protected:
+        void Execute() override {
+            try {
+                switch (action_) {
+                    case Action::Set:
+                        manager_ = create_segment(key_, length_, timeout_ms_);
+                        break;
+                    case Action::Get:
+                        manager_ = acquire_manager(key_, timeout_ms_);
+                        manager_->refresh();
+                        break;
+                    case Action::Remove:
+                        removed_ = remove_segment(key_);
+                        break;
+                    case Action::Warm: {
+                        // length_ 为线程数；预取的映射被重新映射移入 retired_ 后仍保留到管理器销毁，不需要持有映射锁
+                        manager_ = acquire_manager(key_, timeout_ms_);
+                        manager_->refresh();
+                        manager_->prefault(static_cast<unsigned>(length_));
+                        break;
+                    }
+                }
+            } catch (const std::exception& e) {
+                SetError(e.what());
+            }
+        }
+
+        // 仅在主线程包装 ArrayBuffer
+        void OnOK() override {
+            Napi::Env env = Env();
+            if (action_ == Action::Remove) {
+                deferred_.Resolve(Napi::Boolean::New(env, removed_));
+                return;
+            }
+            if (action_ == Action::Warm) {
+                size_t size;
+                {
+                    MappingLock mapping_lock = manager_->lock_mapping();
+                    size = manager_->get_size();
+                }
+                deferred_.Resolve(Napi::Number::New(env, static_cast<double>(size)));
+                manager_.reset();
+                return;
+            }
+            deferred_.Resolve(wrap_buffer(env, manager_));
+            manager_.reset();
+        }
+
+        void OnError(const Napi::Error& error) override {
+            deferred_.Reject(error.Value());
+        }
+
+    private:
+        Napi::Promise::Deferred deferred_;
+        Action action_;
+        std::string key_;
+        size_t length_;
+        int timeout_ms_;
+        bool removed_;
+        std::shared_ptr<SharedMemoryManager> manager_;
+    };
+
+    // 可选的超时参数，缺省、Infinity 或 NaN 时无限等待，超过 INT_MAX 的按 INT_MAX 处理
+    static int timeout_arg(const Napi::CallbackInfo &info, size_t index) {
+        if (info.Length() <= index || info[index].IsUndefined()) {
+            return -1;
+        }
+        if (!info[index].IsNumber()) {
+            throw Napi::Error::New(info.Env(), "timeoutMs必须是数字");
+        }
+        double timeout_ms = info[index].As<Napi::Number>().DoubleValue();
+        if (!std::isfinite(timeout_ms)) {
+            return timeout_ms < 0 ? 0 : -1;
+        }
+        if (timeout_ms < 0) {
+            return 0;
+        }
+        return timeout_ms >= static_cast<double>(INT_MAX) ? INT_MAX : static_cast<int>(timeout_ms);
+    }
+
+    static std::string key_arg(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1) {
+            throw Napi::Error::New(env, "需要一个参数: key");
+        }
+        if (!info[0].IsString()) {
+            throw Napi::Error::New(env, "第一个参数必须是字符串类型的key");
+        }
+        return info[0].As<Napi::String>().Utf8Value();
+    }
+
+    Napi::Value set_memory_async(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        std::string key = key_arg(info);
+        if (info.Length() < 2) {
+            throw Napi::Error::New(env, "需要两个参数: key和length");
+        }
+        size_t length = static_cast<size_t>(size_arg(env, info[1], "length"));
+        if (length <= 0) {
+            throw Napi::Error::New(env, "length必须大于0");
+        }
+
+        auto worker = new MemoryWorker(env, MemoryWorker::Action::Set, key, length, timeout_arg(info, 2));
+        Napi::Promise promise = worker->promise();
+        worker->Queue();
+        return promise;
+    }
+
+    Napi::Value get_memory_async(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        std::string key = key_arg(info);
+
+        auto worker = new MemoryWorker(env, MemoryWorker::Action::Get, key, 0, timeout_arg(info, 1));
+        Napi::Promise promise = worker->promise();
+        worker->Queue();
+        return promise;
+    }
+
+    Napi::Value remove_memory_async(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        std::string key = key_arg(info);
+
+        auto worker = new MemoryWorker(env, MemoryWorker::Action::Remove, key, 0, -1);
+        Napi::Promise promise = worker->promise();
+        worker->Queue();
+        return promise;
+    }
+
+    Napi::Value warm(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        std::string key = key_arg(info);
+        size_t threads = 0;
+        if (info.Length() >= 2 && info[1].IsObject()) {
+            Napi::Value value = info[1].As<Napi::Object>().Get("threads");
+            if (!value.IsUndefined()) {
+                threads = static_cast<size_t>(std::min<uint64_t>(size_arg(env, value, "threads"), 64));
+            }
+        }
+
+        auto worker = new MemoryWorker(env, MemoryWorker::Action::Warm, key, threads, -1);
+        Napi::Promise promise = worker->promise();
+        worker->Queue();
+        return promise;
+    }
+}
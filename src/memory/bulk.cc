@@ -0,0 +1,184 @@
+#include "napi.h"
+#include "../memory.hh"
+#include <memory>
+#include <stdexcept>
+
+namespace SharedMemory {
+    // 参数中的 key
+    static std::string key_at(const Napi::CallbackInfo &info, size_t index, const char* name) {
+        if (!info[index].IsString()) {
+            throw Napi::Error::New(info.Env(), std::string(name) + "必须是字符串类型的key");
+        }
+        return info[index].As<Napi::String>().Utf8Value();
+    }
+
+    // 打开共享内存并检查代数，其他进程扩展过则重新映射；write 为 true 时拒绝只读映射，避免写入时进程崩溃
+    static std::shared_ptr<SharedMemoryManager> open_region(const std::string& key, bool write) {
+        auto manager = acquire_manager(key);
+        manager->refresh();
+        if (write && manager->is_read_only()) {
+            throw std::runtime_error("Shared memory is mapped read-only");
+        }
+        return manager;
+    }
+
+    // 同时锁定两个管理器的映射锁，同一管理器时映射锁可重入
+    static void lock_pair(MappingLock& first_lock, MappingLock& second_lock,
+                          const std::shared_ptr<SharedMemoryManager>& first, const std::shared_ptr<SharedMemoryManager>& second) {
+        first_lock = MappingLock(first->mapping_mutex(), std::defer_lock);
+        second_lock = MappingLock(second->mapping_mutex(), std::defer_lock);
+        std::lock(first_lock, second_lock);
+    }
+
+    // 数据区中 [offset, offset + length) 的起始地址，调用方持有映射锁
+    static uint8_t* region_at(Napi::Env env, const std::shared_ptr<SharedMemoryManager>& manager,
+                              uint64_t offset, uint64_t length) {
+        if (offset > manager->get_size() || length > manager->get_size() - offset) {
+            throw Napi::RangeError::New(env, "区间超出共享内存范围");
+        }
+        return manager->get_data() + offset;
+    }
+
+    // 下标结果：找到时为数字，没有时为 -1
+    static Napi::Value index_result(Napi::Env env, size_t index, size_t length, uint64_t base) {
+        return Napi::Number::New(env, index == length ? -1.0 : static_cast<double>(base + index));
+    }
+
+    Napi::Value copy_region(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 5) {
+            throw Napi::Error::New(env, "需要五个参数: srcKey、srcOffset、dstKey、dstOffset和length");
+        }
+        std::string source_key = key_at(info, 0, "srcKey");
+        uint64_t source_offset = size_arg(env, info[1], "srcOffset");
+        std::string target_key = key_at(info, 2, "dstKey");
+        uint64_t target_offset = size_arg(env, info[3], "dstOffset");
+        uint64_t length = size_arg(env, info[4], "length");
+
+        try {
+            auto source = open_region(source_key, false);
+            auto target = open_region(target_key, true);
+            MappingLock source_lock, target_lock;
+            lock_pair(source_lock, target_lock, source, target);
+            // 同一共享内存内的区间可以重叠
+            copy_bytes(region_at(env, target, target_offset, length), region_at(env, source, source_offset, length),
+                       static_cast<size_t>(length));
+            target->mark_dirty(static_cast<size_t>(target_offset), static_cast<size_t>(length));
+            return env.Undefined();
+        } catch (const Napi::Error&) {
+            throw;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    Napi::Value fill_region(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 3) {
+            throw Napi::Error::New(env, "需要三个参数: key、offset和length");
+        }
+        std::string key = key_at(info, 0, "key");
+        uint64_t offset = size_arg(env, info[1], "offset");
+        uint64_t length = size_arg(env, info[2], "length");
+        uint32_t value = info.Length() >= 4 ? info[3].ToNumber().Uint32Value() : 0;
+
+        try {
+            auto manager = open_region(key, true);
+            MappingLock mapping_lock = manager->lock_mapping();
+            fill_bytes(region_at(env, manager, offset, length), static_cast<uint8_t>(value), static_cast<size_t>(length));
+            manager->mark_dirty(static_cast<size_t>(offset), static_cast<size_t>(length));
+            return env.Undefined();
+        } catch (const Napi::Error&) {
+            throw;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    Napi::Value compare_regions(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 5) {
+            throw Napi::Error::New(env, "需要五个参数: keyA、offsetA、keyB、offsetB和length");
+        }
+        std::string first_key = key_at(info, 0, "keyA");
+        uint64_t first_offset = size_arg(env, info[1], "offsetA");
+        std::string second_key = key_at(info, 2, "keyB");
+        uint64_t second_offset = size_arg(env, info[3], "offsetB");
+        uint64_t length = size_arg(env, info[4], "length");
+
+        try {
+            auto first = open_region(first_key, false);
+            auto second = open_region(second_key, false);
+            MappingLock first_lock, second_lock;
+            lock_pair(first_lock, second_lock, first, second);
+            size_t index = compare_bytes(region_at(env, first, first_offset, length),
+                                         region_at(env, second, second_offset, length), static_cast<size_t>(length));
+            return index_result(env, index, static_cast<size_t>(length), 0);
+        } catch (const Napi::Error&) {
+            throw;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    Napi::Value find_byte_in(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 4) {
+            throw Napi::Error::New(env, "需要四个参数: key、offset、length和value");
+        }
+        std::string key = key_at(info, 0, "key");
+        uint64_t offset = size_arg(env, info[1], "offset");
+        uint64_t length = size_arg(env, info[2], "length");
+        uint32_t value = info[3].ToNumber().Uint32Value();
+
+        try {
+            auto manager = open_region(key, false);
+            MappingLock mapping_lock = manager->lock_mapping();
+            size_t index = find_byte(region_at(env, manager, offset, length), static_cast<size_t>(length),
+                                     static_cast<uint8_t>(value));
+            return index_result(env, index, static_cast<size_t>(length), offset);
+        } catch (const Napi::Error&) {
+            throw;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    Napi::Value checksum(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 3) {
+            throw Napi::Error::New(env, "需要三个参数: key、offset和length");
+        }
+        std::string key = key_at(info, 0, "key");
+        uint64_t offset = size_arg(env, info[1], "offset");
+        uint64_t length = size_arg(env, info[2], "length");
+        ChecksumAlgorithm algorithm = ChecksumAlgorithm::Crc32c;
+        if (info.Length() >= 4 && !info[3].IsUndefined() &&
+            (!info[3].IsString() || !parse_checksum(info[3].As<Napi::String>().Utf8Value(), algorithm))) {
+            throw Napi::Error::New(env, "algorithm必须是'crc32c'或'xxh3'");
+        }
+
+        try {
+            auto manager = open_region(key, false);
+            MappingLock mapping_lock = manager->lock_mapping();
+            const uint8_t* data = region_at(env, manager, offset, length);
+            if (algorithm == ChecksumAlgorithm::Xxh3) {
+                return Napi::BigInt::New(env, xxh3_64(data, static_cast<size_t>(length)));
+            }
+            return Napi::Number::New(env, crc32c(data, static_cast<size_t>(length)));
+        } catch (const Napi::Error&) {
+            throw;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    Napi::Value get_bulk_kernels(const Napi::CallbackInfo &info) {
+        return Napi::String::New(info.Env(), bulk_kernels());
+    }
+}
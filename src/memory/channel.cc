@@ -0,0 +1,146 @@
+#include "napi.h"
+#include "../memory.hh"
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace SharedMemory {
+    // 环形缓冲区通道：一端只调用 push/pushBatch，另一端只调用 pop
+    class RingChannel : public Napi::ObjectWrap<RingChannel> {
+    public:
+        static Napi::Function define(Napi::Env env) {
+            return DefineClass(env, "RingChannel", {
+                InstanceMethod("push", &RingChannel::push),
+                InstanceMethod("pushBatch", &RingChannel::push_batch),
+                InstanceMethod("pop", &RingChannel::pop),
+                InstanceAccessor("capacity", &RingChannel::capacity, nullptr),
+            });
+        }
+
+        // new RingChannel(key) 打开，new RingChannel(key, capacity) 创建
+        RingChannel(const Napi::CallbackInfo &info) : Napi::ObjectWrap<RingChannel>(info) {
+            Napi::Env env = info.Env();
+
+            if (info.Length() < 1 || !info[0].IsString()) {
+                throw Napi::Error::New(env, "第一个参数必须是字符串类型的key");
+            }
+            std::string key = info[0].As<Napi::String>().Utf8Value();
+            bool create = info.Length() >= 2;
+
+            try {
+                if (create) {
+                    uint64_t capacity = size_arg(env, info[1], "capacity");
+                    if (capacity == 0) {
+                        throw Napi::Error::New(env, "capacity必须大于0");
+                    }
+                    auto manager = create_manager(key, RingBuffer::segment_size(static_cast<size_t>(capacity)));
+                    ring_ = std::make_unique<RingBuffer>(manager, true);
+                }
+                else {
+                    ring_ = std::make_unique<RingBuffer>(acquire_manager(key), false);
+                }
+                LOG_DEBUG("Ring channel %s: key=%s, capacity=%zu",
+                    create ? "created" : "opened", key.c_str(), ring_->capacity());
+            } catch (const Napi::Error&) {
+                throw;
+            } catch (const std::exception& e) {
+                LOG_ERROR("Error: %s", e.what());
+                throw Napi::Error::New(env, e.what());
+            }
+        }
+
+    private:
+        Napi::Value push(const Napi::CallbackInfo &info) {
+            Napi::Env env = info.Env();
+            uint8_t* data;
+            size_t length;
+            if (info.Length() < 1 || !get_bytes(info[0], data, length)) {
+                throw Napi::Error::New(env, "参数必须是 ArrayBuffer 或 TypedArray");
+            }
+            try {
+                return Napi::Boolean::New(env, ring_->push(data, length));
+            } catch (const std::exception& e) {
+                throw Napi::Error::New(env, e.what());
+            }
+        }
+
+        Napi::Value push_batch(const Napi::CallbackInfo &info) {
+            Napi::Env env = info.Env();
+            if (info.Length() < 1 || !info[0].IsArray()) {
+                throw Napi::Error::New(env, "参数必须是由 ArrayBuffer 或 TypedArray 组成的数组");
+            }
+
+            Napi::Array array = info[0].As<Napi::Array>();
+            std::vector<RingBuffer::Frame> frames(array.Length());
+            for (uint32_t i = 0; i < array.Length(); i++) {
+                uint8_t* data;
+                size_t length;
+                if (!get_bytes(array.Get(i), data, length)) {
+                    throw Napi::Error::New(env, "数组元素必须是 ArrayBuffer 或 TypedArray");
+                }
+                frames[i].data = data;
+                frames[i].length = length;
+            }
+
+            try {
+                size_t pushed = ring_->push_batch(frames.data(), frames.size());
+                return Napi::Number::New(env, static_cast<double>(pushed));
+            } catch (const std::exception& e) {
+                throw Napi::Error::New(env, e.what());
+            }
+        }
+
+        // pop() 返回新的 Buffer；pop(target) 复制到 target 并返回长度；为空时返回 null
+        Napi::Value pop(const Napi::CallbackInfo &info) {
+            Napi::Env env = info.Env();
+            size_t length;
+            const uint8_t* frame = ring_->peek(length);
+            if (!frame) {
+                return env.Null();
+            }
+
+            uint8_t* dest;
+            size_t dest_length;
+            if (info.Length() >= 1 && get_bytes(info[0], dest, dest_length)) {
+                if (dest_length < length) {
+                    throw Napi::RangeError::New(env, "目标缓冲区小于帧长度");
+                }
+                memcpy(dest, frame, length);
+                ring_->consume(length);
+                return Napi::Number::New(env, static_cast<double>(length));
+            }
+
+            auto buffer = Napi::Buffer<uint8_t>::Copy(env, frame, length);
+            ring_->consume(length);
+            return buffer;
+        }
+
+        Napi::Value capacity(const Napi::CallbackInfo &info) {
+            return Napi::Number::New(info.Env(), static_cast<double>(ring_->capacity()));
+        }
+
+        std::unique_ptr<RingBuffer> ring_;
+    };
+
+    void init_ring_channel(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = RingChannel::define(env);
+        addon_data(env).ring_constructor = Napi::Persistent(ctor);
+        exports.Set(Napi::String::New(env, "RingChannel"), ctor);
+    }
+
+    Napi::Value create_ring(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 2) {
+            throw Napi::Error::New(env, "需要两个参数: key和capacity");
+        }
+        return addon_data(env).ring_constructor.New({info[0], info[1]});
+    }
+
+    Napi::Value open_ring(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1) {
+            throw Napi::Error::New(env, "需要一个参数: key");
+        }
+        return addon_data(env).ring_constructor.New({info[0]});
+    }
+}
@@ -1,88 +1,85 @@
 #include "../memory.hh"
-#include <cstdarg>
-#include <cstdio>
+#include <algorithm>
+#include <mutex>
 #include <spdlog/spdlog.h>
+#include <string>
+#include <vector>
 
 namespace SharedMemory {
-    // 全局回调函数
-    Napi::FunctionReference console_callback;
+    // 设置过控制台回调的环境，日志是进程级的，由最后设置的环境通过线程安全函数在其 JS 线程上批量接收
+    static std::mutex console_mutex;
+    static std::vector<AddonData*> console_envs;
+
+    // 在 JS 线程上逐条投递一批日志
+    static void deliver_to_console(LogLevel level, const char* message, void* context) {
+        auto callback = static_cast<Napi::Function*>(context);
+        Napi::Env env = callback->Env();
+        std::string line = std::string("[") + log_level_name(level) + "] " + message;
+        try {
+            callback->Call({Napi::String::New(env, line)});
+        } catch (const Napi::Error& error) {
+            spdlog::error("回调函数执行失败: {}", error.Message());
+        }
+    }
+
+    // 日志入队后由任意线程调用，唤醒 JS 线程取走整批日志
+    static void notify_console() {
+        std::lock_guard<std::mutex> lock(console_mutex);
+        if (console_envs.empty()) {
+            return;
+        }
+        console_envs.back()->console.NonBlockingCall([](Napi::Env env, Napi::Function callback) {
+            Napi::HandleScope scope(env);
+            drain_log(deliver_to_console, &callback);
+        });
+    }
 
     // 设置控制台回调函数
     Napi::Value set_console(const Napi::CallbackInfo &info) {
         Napi::Env env = info.Env();
-        
-        if (info.Length() != 1) {
-            throw Napi::Error::New(env, "参数长度必须为1!");
+
+        if (info.Length() < 1 || info.Length() > 2) {
+            throw Napi::Error::New(env, "参数长度必须为1或2!");
         }
-        if (!info[0].IsFunction()) {
-            throw Napi::Error::New(env, "参数必须是函数!");
+        if (!info[0].IsFunction() && !info[0].IsNull()) {
+            throw Napi::Error::New(env, "第一个参数必须是函数或null!");
         }
 
-        // 保存回调函数
-        console_callback = Napi::Persistent(info[0].As<Napi::Function>());
-        
-        return env.Undefined();
-    }
-
-    // 清理控制台回调函数
-    void cleanup_console() {
-        if (!console_callback.IsEmpty()) {
-            console_callback.Reset();
+        LogLevel level = LogLevel::Info;
+        if (info.Length() == 2) {
+            if (!info[1].IsString() || !parse_log_level(info[1].As<Napi::String>().Utf8Value(), level)) {
+                throw Napi::Error::New(env, "日志级别必须是 trace/debug/info/warn/error/off 之一!");
+            }
         }
-    }
 
-    // 日志辅助函数 - 字符串版本
-    void log(const std::string& message) {
-        if (!console_callback.IsEmpty()) {
-            try {
-                Napi::Env env = console_callback.Env();
-                Napi::HandleScope scope(env);
-                
-                // 使用 try-catch 捕获可能的异常
-                try {
-                    console_callback.Call({Napi::String::New(env, message)});
-                } catch (const Napi::Error& error) {
-                    spdlog::error("回调函数执行失败: {}", error.Message());
-                }
-            } catch (const std::exception& e) {
-                spdlog::error("回调函数执行异常: {}", e.what());
-            } catch (...) {
-                spdlog::error("回调函数执行未知异常");
-            }
+        AddonData& data = addon_data(env);
+        cleanup_console(data);
+        set_log_level(level);
+        if (info[0].IsNull()) {
+            return env.Undefined();
         }
-    }
 
-    // 日志辅助函数 - 格式化版本
-    void log(const char* format, ...) {
-        char buffer[1024];
-        va_list args;
-        va_start(args, format);
-        
-        if (!console_callback.IsEmpty()) {
-            try {
-                vsnprintf(buffer, sizeof(buffer), format, args);
-                va_end(args);
+        // 保存回调函数，Unref 后不会阻止事件循环退出
+        data.console = Napi::ThreadSafeFunction::New(env, info[0].As<Napi::Function>(), "SharedMemoryConsole", 0, 1);
+        data.console.Unref(env);
+        std::lock_guard<std::mutex> lock(console_mutex);
+        console_envs.push_back(&data);
+        set_log_notifier(notify_console);
 
-                Napi::Env env = console_callback.Env();
-                Napi::HandleScope scope(env);
-                
-                // 使用 try-catch 捕获可能的异常
-                try {
-                    console_callback.Call({Napi::String::New(env, buffer)});
-                } catch (const Napi::Error& error) {
-                    spdlog::error("回调函数执行失败: {}", error.Message());
-                }
-            } catch (const std::exception& e) {
-                spdlog::error("回调函数执行异常: {}", e.what());
-            } catch (...) {
-                spdlog::error("回调函数执行未知异常");
-            }
+        return env.Undefined();
+    }
+
+    void cleanup_console(AddonData& data) {
+        std::lock_guard<std::mutex> lock(console_mutex);
+        auto it = std::find(console_envs.begin(), console_envs.end(), &data);
+        if (it != console_envs.end()) {
+            console_envs.erase(it);
+            // 重新设置通知函数会清除待投递标记，已入队的日志随下一条日志交给接手的环境
+            set_log_notifier(console_envs.empty() ? nullptr : notify_console);
         }
-        else {
-            char buffer[1024];
-            vsnprintf(buffer, sizeof(buffer), format, args);
-            va_end(args);
-            spdlog::info("{}", buffer);
+        if (data.console) {
+            data.console.Release();
+            data.console = Napi::ThreadSafeFunction();
         }
     }
-} 
\ No newline at end of file
+}
@@ -0,0 +1,168 @@
+#include "napi.h"
+#include "../memory.hh"
+#include <memory>
+#include <stdexcept>
+
+namespace SharedMemory {
+    // 打开启用了变更跟踪的共享内存，其他进程扩展过则重新映射
+    static std::shared_ptr<SharedMemoryManager> open_tracked(Napi::Env env, const std::string& key) {
+        auto manager = acquire_manager(key);
+        manager->refresh();
+        if (!manager->dirty_tracker()) {
+            throw Napi::Error::New(env, "共享内存未启用变更跟踪，或不是以读写方式映射");
+        }
+        return manager;
+    }
+
+    // delta.ranges 中的区间
+    static std::vector<DirtyRange> ranges_arg(Napi::Env env, const Napi::Value& value) {
+        if (!value.IsArray()) {
+            throw Napi::Error::New(env, "delta.ranges必须是数组");
+        }
+        Napi::Array array = value.As<Napi::Array>();
+        std::vector<DirtyRange> ranges;
+        ranges.reserve(array.Length());
+        for (uint32_t i = 0; i < array.Length(); i++) {
+            Napi::Value item = array.Get(i);
+            if (!item.IsObject()) {
+                throw Napi::Error::New(env, "delta.ranges的元素必须是 { offset, length }");
+            }
+            Napi::Object range = item.As<Napi::Object>();
+            ranges.push_back({size_arg(env, range.Get("offset"), "offset"), size_arg(env, range.Get("length"), "length")});
+        }
+        return ranges;
+    }
+
+    Napi::Value mark_dirty(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 3) {
+            throw Napi::Error::New(env, "需要三个参数: key、offset和length");
+        }
+        if (!info[0].IsString()) {
+            throw Napi::Error::New(env, "key必须是字符串类型");
+        }
+        std::string key = info[0].As<Napi::String>().Utf8Value();
+        uint64_t offset = size_arg(env, info[1], "offset");
+        uint64_t length = size_arg(env, info[2], "length");
+
+        try {
+            auto manager = open_tracked(env, key);
+            MappingLock mapping_lock = manager->lock_mapping();
+            if (offset > manager->get_size() || length > manager->get_size() - offset) {
+                throw Napi::RangeError::New(env, "区间超出共享内存范围");
+            }
+            manager->mark_dirty(static_cast<size_t>(offset), static_cast<size_t>(length));
+            return env.Undefined();
+        } catch (const Napi::Error&) {
+            throw;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    Napi::Value collect_delta(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 2) {
+            throw Napi::Error::New(env, "需要两个参数: key和sinceEpoch");
+        }
+        if (!info[0].IsString()) {
+            throw Napi::Error::New(env, "key必须是字符串类型");
+        }
+        if (!info[1].IsNumber()) {
+            throw Napi::Error::New(env, "sinceEpoch必须是数字");
+        }
+        std::string key = info[0].As<Napi::String>().Utf8Value();
+        uint32_t since = info[1].As<Napi::Number>().Uint32Value();
+        bool with_data = info.Length() >= 3 && info[2].IsObject() &&
+                         info[2].As<Napi::Object>().Get("data").ToBoolean().Value();
+
+        try {
+            auto manager = open_tracked(env, key);
+            // 收集与复制数据之间不重新映射，返回的大小与区间一致
+            MappingLock mapping_lock = manager->lock_mapping();
+            std::vector<DirtyRange> ranges;
+            uint32_t epoch = manager->collect_dirty(since, ranges);
+
+            Napi::Array list = Napi::Array::New(env, ranges.size());
+            uint64_t bytes = 0;
+            for (size_t i = 0; i < ranges.size(); i++) {
+                Napi::Object range = Napi::Object::New(env);
+                range.Set("offset", Napi::Number::New(env, static_cast<double>(ranges[i].offset)));
+                range.Set("length", Napi::Number::New(env, static_cast<double>(ranges[i].length)));
+                list.Set(static_cast<uint32_t>(i), range);
+                bytes += ranges[i].length;
+            }
+
+            Napi::Object result = Napi::Object::New(env);
+            result.Set("key", Napi::String::New(env, key));
+            result.Set("epoch", Napi::Number::New(env, epoch));
+            result.Set("size", Napi::Number::New(env, static_cast<double>(manager->get_size())));
+            result.Set("blockSize", Napi::Number::New(env, static_cast<double>(manager->get_dirty_block_size())));
+            result.Set("ranges", list);
+            result.Set("bytes", Napi::Number::New(env, static_cast<double>(bytes)));
+            if (with_data) {
+                // 复制时仍在写入的块由写入方之后的 markDirty 在下一次收集中重新带出
+                Napi::ArrayBuffer data = Napi::ArrayBuffer::New(env, static_cast<size_t>(bytes));
+                uint8_t* cursor = static_cast<uint8_t*>(data.Data());
+                for (const DirtyRange& range : ranges) {
+                    copy_bytes(cursor, manager->get_data() + range.offset, static_cast<size_t>(range.length));
+                    cursor += range.length;
+                }
+                result.Set("data", data);
+            }
+            return result;
+        } catch (const Napi::Error&) {
+            throw;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    Napi::Value apply_delta_to(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 2) {
+            throw Napi::Error::New(env, "需要两个参数: targetKey和delta");
+        }
+        if (!info[0].IsString()) {
+            throw Napi::Error::New(env, "targetKey必须是字符串类型");
+        }
+        if (!info[1].IsObject()) {
+            throw Napi::Error::New(env, "delta必须是collectDelta返回的对象");
+        }
+        std::string target_key = info[0].As<Napi::String>().Utf8Value();
+        Napi::Object delta = info[1].As<Napi::Object>();
+        std::vector<DirtyRange> ranges = ranges_arg(env, delta.Get("ranges"));
+        Napi::Value data = delta.Get("data");
+        Napi::Value source_key = delta.Get("key");
+        uint8_t* bytes = nullptr;
+        size_t length = 0;
+        if (!data.IsUndefined() && !get_bytes(data, bytes, length)) {
+            throw Napi::Error::New(env, "delta.data必须是ArrayBuffer或TypedArray");
+        }
+        if (data.IsUndefined() && !source_key.IsString()) {
+            throw Napi::Error::New(env, "delta需要data或字符串类型的key");
+        }
+
+        try {
+            auto target = acquire_manager(target_key);
+            target->refresh();
+            uint64_t applied;
+            if (!data.IsUndefined()) {
+                applied = apply_delta(target, bytes, length, ranges);
+            }
+            else {
+                auto source = acquire_manager(source_key.As<Napi::String>().Utf8Value());
+                source->refresh();
+                applied = apply_delta(target, source, ranges);
+            }
+            return Napi::Number::New(env, static_cast<double>(applied));
+        } catch (const Napi::Error&) {
+            throw;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+}
@@ -2,11 +2,45 @@
 #include "../memory.hh"
 #include <cstring>
 #include <memory>
-#include <map>
 
 namespace SharedMemory {
-    // 全局变量来保存共享内存资源
-    static std::map<std::string, std::shared_ptr<SharedMemoryManager>> managerMap;
+    MapOptions map_options_arg(Napi::Env env, const Napi::Value& value) {
+        MapOptions options;
+        if (value.IsUndefined() || value.IsNull()) {
+            return options;
+        }
+        if (!value.IsObject()) {
+            throw Napi::Error::New(env, "选项必须是对象");
+        }
+        Napi::Object object = value.As<Napi::Object>();
+        Napi::Value huge_pages = object.Get("hugePages");
+        if (huge_pages.IsBoolean()) {
+            options.huge_pages = huge_pages.As<Napi::Boolean>().Value() ? HugePages::Transparent : HugePages::None;
+        }
+        else if (!huge_pages.IsUndefined() &&
+                 (!huge_pages.IsString() || !parse_huge_pages(huge_pages.As<Napi::String>().Utf8Value(), options.huge_pages))) {
+            throw Napi::Error::New(env, "hugePages必须是'transparent'、'explicit'或'none'");
+        }
+        Napi::Value mode = object.Get("mode");
+        if (!mode.IsUndefined() &&
+            (!mode.IsString() || !parse_map_mode(mode.As<Napi::String>().Utf8Value(), options.mode))) {
+            throw Napi::Error::New(env, "mode必须是'readwrite'、'readonly'或'private'");
+        }
+        options.populate = object.Get("populate").ToBoolean().Value();
+        options.lock = object.Get("lock").ToBoolean().Value();
+        Napi::Value track_dirty = object.Get("trackDirty");
+        if (track_dirty.IsBoolean()) {
+            options.dirty_block = track_dirty.As<Napi::Boolean>().Value() ? DIRTY_BLOCK_MIN : 0;
+        }
+        else if (track_dirty.IsNumber() && valid_dirty_block(static_cast<size_t>(track_dirty.As<Napi::Number>().Int64Value()))) {
+            options.dirty_block = static_cast<size_t>(track_dirty.As<Napi::Number>().Int64Value());
+        }
+        else if (!track_dirty.IsUndefined()) {
+            throw Napi::Error::New(env, "trackDirty必须是布尔值或4096到65536之间的2的幂");
+        }
+        return options;
+    }
+
     Napi::Value get_memory(const Napi::CallbackInfo &info) {
         Napi::Env env = info.Env();
         
@@ -20,48 +54,133 @@ namespace SharedMemory {
         }
         
         std::string key = info[0].As<Napi::String>().Utf8Value();
+        MapOptions options = map_options_arg(env, info.Length() >= 2 ? info[1] : env.Undefined());
         
         try {
-            log("Get memory call.");
-            log("Creating SharedMemoryManager...");
-            
-            // 创建共享内存管理器
-            auto manager = managerMap[key] = std::make_shared<SharedMemoryManager>(key, false);
-            log("SharedMemoryManager created successfully.");
-            
-            // 获取共享内存的地址和大小
-            void* addr = manager->get_address();
-            size_t size = manager->get_size();
-            
-            log("Shared memory opened: key=%s, size=%zu, address=%p", 
-                key.c_str(), size, addr);
-            
-            // 读取头部信息
-            SharedMemoryHeader* header = static_cast<SharedMemoryHeader*>(addr);
-            size_t data_size = header->size;
-            
-            log("Header information: size=%zu", data_size);
-            
-            // 获取数据区域的地址
-            void* data_addr = static_cast<char*>(addr) + sizeof(SharedMemoryHeader);
-            
-            auto deleter = [](void* /*data*/, void* /*hint*/) {
-                log("Buffer cleanup callback called.");
-                // 这里不需要做任何事情，因为共享内存和互斥锁会在程序退出时自动清理
-            };
+            LOG_DEBUG("Get memory call.");
 
-            // 创建ArrayBuffer，直接映射到共享内存
-            auto buffer = Napi::ArrayBuffer::New(env, data_addr, data_size, deleter);
-            
-            
-            return buffer;
+            // 优先复用进程内缓存的映射，未命中时才打开共享内存，选项应用到已有映射
+            auto manager = acquire_manager(key, -1, options);
+
+            // 缓存命中时检查代数，其他进程扩展过则重新映射
+            manager->refresh();
+
+            LOG_DEBUG("Shared memory opened: key=%s, size=%zu, address=%p", 
+                key.c_str(), manager->get_size(), manager->get_address());
+
+            return wrap_memory(env, manager, info.Length() >= 2 ? info[1] : env.Undefined());
             
         } catch (const std::exception& e) {
-            log("Error: %s", e.what());
+            LOG_ERROR("Error: %s", e.what());
             throw Napi::Error::New(env, e.what());
         } catch (...) {
-            log("Unknown error occurred");
+            LOG_ERROR("Unknown error occurred");
             throw Napi::Error::New(env, "获取共享内存时发生未知错误");
         }
     }
-}
\ No newline at end of file
+
+    static std::string key_arg(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1) {
+            throw Napi::Error::New(env, "需要一个参数: key");
+        }
+        if (!info[0].IsString()) {
+            throw Napi::Error::New(env, "参数必须是字符串类型的key");
+        }
+        return info[0].As<Napi::String>().Utf8Value();
+    }
+
+    Napi::Value refresh_memory(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        std::string key = key_arg(info);
+        try {
+            return Napi::Boolean::New(env, acquire_manager(key)->refresh());
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    Napi::Value get_memory_info(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        std::string key = key_arg(info);
+        try {
+            auto manager = acquire_manager(key);
+            MappingLock mapping_lock = manager->lock_mapping();
+            const MapOptions& mapping = manager->get_mapping();
+            Napi::Object result = Napi::Object::New(env);
+            result.Set("size", Napi::Number::New(env, static_cast<double>(manager->get_size())));
+            result.Set("dataOffset", Napi::Number::New(env, static_cast<double>(manager->get_data_offset())));
+            result.Set("legacy", Napi::Boolean::New(env, manager->is_legacy()));
+            result.Set("hugePages", Napi::String::New(env, huge_pages_name(mapping.huge_pages)));
+            result.Set("hugePageSize", Napi::Number::New(env, static_cast<double>(manager->get_huge_page_size())));
+            result.Set("populated", Napi::Boolean::New(env, mapping.populate));
+            result.Set("locked", Napi::Boolean::New(env, mapping.lock));
+            result.Set("backend", Napi::String::New(env, backend_name(manager->get_backend())));
+            result.Set("mode", Napi::String::New(env, map_mode_name(manager->get_mode())));
+            result.Set("readOnly", Napi::Boolean::New(env, manager->is_read_only()));
+            DirtyTracker* tracker = manager->dirty_tracker();
+            result.Set("dirtyBlockSize", Napi::Number::New(env, static_cast<double>(manager->get_dirty_block_size())));
+            if (tracker) {
+                result.Set("dirtyEpoch", Napi::Number::New(env, tracker->epoch.load(std::memory_order_acquire)));
+            }
+            uint32_t seals = manager->get_seals();
+            Napi::Array sealed = Napi::Array::New(env);
+            if (seals & SEAL_SHRINK) {
+                sealed.Set(sealed.Length(), Napi::String::New(env, "shrink"));
+            }
+            if (seals & SEAL_GROW) {
+                sealed.Set(sealed.Length(), Napi::String::New(env, "grow"));
+            }
+            if (seals & SEAL_WRITE) {
+                sealed.Set(sealed.Length(), Napi::String::New(env, "write"));
+            }
+            result.Set("seals", sealed);
+            // 附加计数与删除标记，旧版头部没有附加记录
+            SegmentOwners* owners = manager->owners();
+            if (owners) {
+                result.Set("attached", Napi::Number::New(env, owners->attached.load(std::memory_order_acquire)));
+                result.Set("removed", Napi::Boolean::New(env, owners->removed.load(std::memory_order_acquire) != 0));
+            }
+            return result;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    Napi::Value share_memory(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        std::string key = key_arg(info);
+        try {
+            return Napi::Number::New(env, pin_manager(acquire_manager(key)));
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    Napi::Value attach_memory(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsNumber()) {
+            throw Napi::Error::New(env, "参数必须是shareMemory返回的句柄");
+        }
+        // 同一进程中的映射直接复用，不重新打开共享内存，也不拷贝数据
+        auto manager = take_pinned(info[0].As<Napi::Number>().Uint32Value());
+        if (!manager) {
+            throw Napi::Error::New(env, "句柄无效或已被取出");
+        }
+        return wrap_memory(env, manager, info.Length() >= 2 ? info[1] : env.Undefined());
+    }
+
+    Napi::Value get_generation(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        std::string key = key_arg(info);
+        try {
+            return Napi::Number::New(env, acquire_manager(key)->get_header_generation());
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+}
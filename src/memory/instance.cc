@@ -0,0 +1,20 @@
+#include "napi.h"
+#include "../memory.hh"
+
+namespace SharedMemory {
+    AddonData& init_addon_data(Napi::Env env) {
+        AddonData* data = new AddonData();
+        // 实例数据随环境销毁释放；线程安全函数须在此之前释放，放在清理钩子中
+        env.SetInstanceData<AddonData>(data);
+        env.AddCleanupHook([](AddonData* data) { cleanup_console(*data); }, data);
+        return *data;
+    }
+
+    AddonData& addon_data(Napi::Env env) {
+        AddonData* data = env.GetInstanceData<AddonData>();
+        if (!data) {
+            throw Napi::Error::New(env, "模块未在当前环境中初始化");
+        }
+        return *data;
+    }
+}
@@ -0,0 +1,134 @@
+#include "napi.h"
+#include "../memory.hh"
+#include <climits>
+#include <cmath>
+#include <memory>
+
+namespace SharedMemory {
+    static std::shared_ptr<SharedMemoryManager> manager_arg(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1) {
+            throw Napi::Error::New(env, "需要一个参数: key");
+        }
+        if (!info[0].IsString()) {
+            throw Napi::Error::New(env, "参数必须是字符串类型的key");
+        }
+        return acquire_manager(info[0].As<Napi::String>().Utf8Value());
+    }
+
+    // 可选的超时参数，缺省、Infinity 或 NaN 时无限等待，负数视为 0；
+    // 截断到 INT_MAX 毫秒，互斥锁转换为 int、读写锁换算为微秒时都不会溢出
+    static double timeout_arg(const Napi::CallbackInfo &info) {
+        if (info.Length() < 2 || info[1].IsUndefined()) {
+            return -1;
+        }
+        if (!info[1].IsNumber()) {
+            throw Napi::Error::New(info.Env(), "timeoutMs必须是数字");
+        }
+        double timeout_ms = info[1].As<Napi::Number>().DoubleValue();
+        if (!std::isfinite(timeout_ms)) {
+            return timeout_ms < 0 ? 0 : -1;
+        }
+        if (timeout_ms < 0) {
+            return 0;
+        }
+        return timeout_ms > static_cast<double>(INT_MAX) ? static_cast<double>(INT_MAX) : timeout_ms;
+    }
+
+    Napi::Value lock(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        int timeout_ms = static_cast<int>(timeout_arg(info));
+        try {
+            auto manager = manager_arg(info);
+            return Napi::String::New(env, lock_result_name(manager->lock(timeout_ms)));
+        } catch (const Napi::Error&) {
+            throw;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    Napi::Value try_lock(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        try {
+            auto manager = manager_arg(info);
+            return Napi::String::New(env, lock_result_name(manager->try_lock()));
+        } catch (const Napi::Error&) {
+            throw;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    Napi::Value unlock(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        try {
+            auto manager = manager_arg(info);
+            manager->unlock();
+            return env.Undefined();
+        } catch (const Napi::Error&) {
+            throw;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    Napi::Value read_lock(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        double timeout_ms = timeout_arg(info);
+        try {
+            auto manager = manager_arg(info);
+            return Napi::Boolean::New(env, manager->read_lock(timeout_ms));
+        } catch (const Napi::Error&) {
+            throw;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    Napi::Value read_unlock(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        try {
+            auto manager = manager_arg(info);
+            manager->read_unlock();
+            return env.Undefined();
+        } catch (const Napi::Error&) {
+            throw;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    Napi::Value write_lock(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        double timeout_ms = timeout_arg(info);
+        try {
+            auto manager = manager_arg(info);
+            return Napi::Boolean::New(env, manager->write_lock(timeout_ms));
+        } catch (const Napi::Error&) {
+            throw;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    Napi::Value write_unlock(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        try {
+            auto manager = manager_arg(info);
+            manager->write_unlock();
+            return env.Undefined();
+        } catch (const Napi::Error&) {
+            throw;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+}
@@ -0,0 +1,181 @@
+#include "napi.h"
+#include "../memory.hh"
+#include <climits>
+#include <cmath>
+#include <memory>
+
+namespace SharedMemory {
+    static int fd_arg(Napi::Env env, const Napi::Value& value, const char* name) {
+        if (!value.IsNumber() || value.As<Napi::Number>().Int32Value() < 0) {
+            throw Napi::Error::New(env, std::string(name) + "必须是文件描述符");
+        }
+        return value.As<Napi::Number>().Int32Value();
+    }
+
+    Napi::Value socket_pair(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        try {
+            int first = -1;
+            int second = -1;
+            create_socket_pair(first, second);
+            Napi::Array result = Napi::Array::New(env, 2);
+            result.Set(0u, Napi::Number::New(env, first));
+            result.Set(1u, Napi::Number::New(env, second));
+            return result;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    Napi::Value export_fd(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 2 || !info[0].IsString()) {
+            throw Napi::Error::New(env, "需要两个参数: key和socket");
+        }
+        std::string key = info[0].As<Napi::String>().Utf8Value();
+        int socket = fd_arg(env, info[1], "socket");
+        try {
+            export_segment(socket, acquire_manager(key));
+            return env.Undefined();
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    // importFd/importFdAsync 的参数：套接字、映射选项、超时（缺省为 default_timeout，Infinity 为 -1）和本地键名
+    struct ImportArgs {
+        int socket;
+        MapOptions mapping;
+        int timeout_ms;
+        std::string key;
+        bool shared;
+        bool copy;
+    };
+
+    static ImportArgs import_args(const Napi::CallbackInfo &info, int default_timeout) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1) {
+            throw Napi::Error::New(env, "需要一个参数: socket");
+        }
+        ImportArgs args;
+        args.socket = fd_arg(env, info[0], "socket");
+        Napi::Value options = info.Length() >= 2 ? info[1] : env.Undefined();
+        args.mapping = map_options_arg(env, options);
+        args.timeout_ms = default_timeout;
+        args.shared = shared_arg(options);
+        args.copy = copy_arg(options);
+        if (options.IsObject()) {
+            Napi::Object object = options.As<Napi::Object>();
+            Napi::Value timeout = object.Get("timeoutMs");
+            if (!timeout.IsUndefined()) {
+                if (!timeout.IsNumber()) {
+                    throw Napi::Error::New(env, "timeoutMs必须是数字");
+                }
+                double timeout_ms = timeout.As<Napi::Number>().DoubleValue();
+                if (std::isnan(timeout_ms)) {
+                    throw Napi::Error::New(env, "timeoutMs必须是数字");
+                }
+                args.timeout_ms = timeout_ms >= static_cast<double>(INT_MAX) ? -1 :
+                                  timeout_ms < 0 ? 0 : static_cast<int>(timeout_ms);
+            }
+            Napi::Value key = object.Get("key");
+            if (!key.IsUndefined()) {
+                if (!key.IsString() || key.As<Napi::String>().Utf8Value().empty()) {
+                    throw Napi::Error::New(env, "key必须是非空字符串");
+                }
+                args.key = key.As<Napi::String>().Utf8Value();
+            }
+        }
+        return args;
+    }
+
+    // 在 libuv 线程池中等待并接收描述符，不阻塞 JS 线程
+    class ImportWorker : public Napi::AsyncWorker {
+    public:
+        ImportWorker(Napi::Env env, ImportArgs args)
+            : Napi::AsyncWorker(env), deferred_(Napi::Promise::Deferred::New(env)), args_(std::move(args)) {}
+
+        Napi::Promise promise() const { return deferred_.Promise(); }
+
+    protected:
+        void Execute() override {
+            try {
+                manager_ = import_segment(args_.socket, args_.timeout_ms, args_.mapping, args_.key);
+            } catch (const std::exception& e) {
+                SetError(e.what());
+            }
+        }
+
+        // 仅在主线程包装 ArrayBuffer
+        void OnOK() override {
+            Napi::Env env = Env();
+            try {
+                Napi::Object result = Napi::Object::New(env);
+                result.Set("key", Napi::String::New(env, manager_->get_key()));
+                result.Set("buffer", wrap_memory(env, manager_, args_.shared, args_.copy));
+                deferred_.Resolve(result);
+            } catch (const Napi::Error& error) {
+                deferred_.Reject(error.Value());
+            }
+            manager_.reset();
+        }
+
+        void OnError(const Napi::Error& error) override {
+            deferred_.Reject(error.Value());
+        }
+
+    private:
+        Napi::Promise::Deferred deferred_;
+        ImportArgs args_;
+        std::shared_ptr<SharedMemoryManager> manager_;
+    };
+
+    Napi::Value import_fd(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        // 同步接收在 JS 线程中等待，只允许有限的超时，缺省只取已到达的消息
+        ImportArgs args = import_args(info, 0);
+        if (args.timeout_ms < 0) {
+            throw Napi::Error::New(env, "importFd的timeoutMs必须是有限值，需要一直等待时使用importFdAsync");
+        }
+        Napi::Value options = info.Length() >= 2 ? info[1] : env.Undefined();
+        try {
+            auto manager = import_segment(args.socket, args.timeout_ms, args.mapping, args.key);
+            Napi::Object result = Napi::Object::New(env);
+            result.Set("key", Napi::String::New(env, manager->get_key()));
+            result.Set("buffer", wrap_memory(env, manager, options));
+            return result;
+        } catch (const Napi::Error&) {
+            throw;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    Napi::Value import_fd_async(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        auto worker = new ImportWorker(env, import_args(info, -1));
+        Napi::Promise promise = worker->promise();
+        worker->Queue();
+        return promise;
+    }
+
+    Napi::Value seal_memory(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsString()) {
+            throw Napi::Error::New(env, "参数必须是字符串类型的key");
+        }
+        std::string key = info[0].As<Napi::String>().Utf8Value();
+        bool write = info.Length() >= 2 && info[1].IsObject() &&
+                     info[1].As<Napi::Object>().Get("write").ToBoolean().Value();
+        try {
+            acquire_manager(key)->seal(write);
+            return env.Undefined();
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+}
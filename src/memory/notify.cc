@@ -0,0 +1,158 @@
+#include "napi.h"
+#include "../memory.hh"
+#include <climits>
+#include <cmath>
+#include <memory>
+
+namespace SharedMemory {
+    // 解析数据区内的 32 位等待字，offset 必须 4 字节对齐且不越界
+    static std::atomic<uint32_t>* wait_word(Napi::Env env, const std::shared_ptr<SharedMemoryManager>& manager, const Napi::Value& value) {
+        if (!value.IsNumber()) {
+            throw Napi::Error::New(env, "offset必须是数字");
+        }
+        int64_t offset = value.As<Napi::Number>().Int64Value();
+        MappingLock mapping_lock = manager->lock_mapping();
+        if (offset < 0 || offset % 4 != 0 || static_cast<uint64_t>(offset) + 4 > manager->get_size()) {
+            throw Napi::RangeError::New(env, "offset必须4字节对齐且位于数据区内");
+        }
+        char* data_addr = reinterpret_cast<char*>(manager->get_data());
+        return reinterpret_cast<std::atomic<uint32_t>*>(data_addr + offset);
+    }
+
+    // 超时参数缺省、为 Infinity 或 NaN 时无限等待，负数不等待，超过 INT_MAX 的按 INT_MAX 处理，避免换算纳秒时溢出
+    static double wait_timeout(const Napi::CallbackInfo &info, size_t index) {
+        if (info.Length() <= index || info[index].IsUndefined()) {
+            return -1;
+        }
+        if (!info[index].IsNumber()) {
+            throw Napi::Error::New(info.Env(), "timeoutMs必须是数字");
+        }
+        double timeout_ms = info[index].As<Napi::Number>().DoubleValue();
+        if (!std::isfinite(timeout_ms)) {
+            return timeout_ms < 0 ? 0 : -1;
+        }
+        if (timeout_ms < 0) {
+            return 0;
+        }
+        return timeout_ms > static_cast<double>(INT_MAX) ? static_cast<double>(INT_MAX) : timeout_ms;
+    }
+
+    static void check_wait_args(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 3) {
+            throw Napi::Error::New(env, "需要参数: key, offset, expected[, timeoutMs]");
+        }
+        if (!info[0].IsString()) {
+            throw Napi::Error::New(env, "第一个参数必须是字符串类型的key");
+        }
+        if (!info[2].IsNumber()) {
+            throw Napi::Error::New(env, "expected必须是数字");
+        }
+    }
+
+    Napi::Value wait(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        check_wait_args(info);
+
+        try {
+            auto manager = acquire_manager(info[0].As<Napi::String>().Utf8Value());
+            auto word = wait_word(env, manager, info[1]);
+            uint32_t expected = info[2].As<Napi::Number>().Uint32Value();
+            WaitResult result = futex_wait(word, expected, wait_timeout(info, 3));
+            return Napi::String::New(env, wait_result_name(result));
+        } catch (const Napi::Error&) {
+            throw;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    // 在 libuv 线程池中等待，不阻塞事件循环
+    class WaitWorker : public Napi::AsyncWorker {
+    public:
+        WaitWorker(Napi::Env env, std::shared_ptr<SharedMemoryManager> manager,
+                   std::atomic<uint32_t>* word, uint32_t expected, double timeout_ms)
+            : Napi::AsyncWorker(env), deferred_(Napi::Promise::Deferred::New(env)),
+              manager_(std::move(manager)), word_(word), expected_(expected),
+              timeout_ms_(timeout_ms), result_(WaitResult::Ok) {}
+
+        Napi::Promise promise() const { return deferred_.Promise(); }
+
+    protected:
+        void Execute() override {
+            try {
+                result_ = futex_wait(word_, expected_, timeout_ms_);
+            } catch (const std::exception& e) {
+                SetError(e.what());
+            }
+        }
+
+        void OnOK() override {
+            deferred_.Resolve(Napi::String::New(Env(), wait_result_name(result_)));
+        }
+
+        void OnError(const Napi::Error& error) override {
+            deferred_.Reject(error.Value());
+        }
+
+    private:
+        Napi::Promise::Deferred deferred_;
+        std::shared_ptr<SharedMemoryManager> manager_;  // 等待期间保持映射有效
+        std::atomic<uint32_t>* word_;
+        uint32_t expected_;
+        double timeout_ms_;
+        WaitResult result_;
+    };
+
+    Napi::Value wait_async(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        check_wait_args(info);
+
+        try {
+            auto manager = acquire_manager(info[0].As<Napi::String>().Utf8Value());
+            auto word = wait_word(env, manager, info[1]);
+            uint32_t expected = info[2].As<Napi::Number>().Uint32Value();
+            auto worker = new WaitWorker(env, manager, word, expected, wait_timeout(info, 3));
+            Napi::Promise promise = worker->promise();
+            worker->Queue();
+            return promise;
+        } catch (const Napi::Error&) {
+            throw;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    Napi::Value notify(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 2) {
+            throw Napi::Error::New(env, "需要参数: key, offset[, count]");
+        }
+        if (!info[0].IsString()) {
+            throw Napi::Error::New(env, "第一个参数必须是字符串类型的key");
+        }
+
+        // count 缺省或为 Infinity 时唤醒全部等待者
+        int count = INT_MAX;
+        if (info.Length() >= 3 && !info[2].IsUndefined()) {
+            if (!info[2].IsNumber()) {
+                throw Napi::Error::New(env, "count必须是数字");
+            }
+            double value = info[2].As<Napi::Number>().DoubleValue();
+            count = std::isnan(value) || value >= INT_MAX ? INT_MAX : (value < 0 ? 0 : static_cast<int>(value));
+        }
+
+        try {
+            auto manager = acquire_manager(info[0].As<Napi::String>().Utf8Value());
+            auto word = wait_word(env, manager, info[1]);
+            return Napi::Number::New(env, futex_wake(word, count));
+        } catch (const Napi::Error&) {
+            throw;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#include "napi.h"
+#include "../memory.hh"
+
+namespace SharedMemory {
+    static Napi::Object segment_object(Napi::Env env, const SegmentInfo& info) {
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("key", Napi::String::New(env, info.key));
+        result.Set("path", Napi::String::New(env, info.path));
+        result.Set("size", Napi::Number::New(env, static_cast<double>(info.object_size)));
+        result.Set("legacy", Napi::Boolean::New(env, info.legacy));
+        result.Set("tracked", Napi::Boolean::New(env, info.tracked));
+        result.Set("removed", Napi::Boolean::New(env, info.removed));
+        result.Set("creatorPid", Napi::Number::New(env, info.creator_pid));
+        result.Set("attached", Napi::Number::New(env, info.attached));
+        Napi::Array owners = Napi::Array::New(env, info.owners.size());
+        for (size_t i = 0; i < info.owners.size(); i++) {
+            owners.Set(static_cast<uint32_t>(i), Napi::Number::New(env, info.owners[i]));
+        }
+        result.Set("owners", owners);
+        result.Set("foreignNamespace", Napi::Boolean::New(env, info.foreign));
+        result.Set("orphaned", Napi::Boolean::New(env, info.orphaned));
+        return result;
+    }
+
+    static Napi::Array segment_array(Napi::Env env, const std::vector<SegmentInfo>& segments) {
+        Napi::Array result = Napi::Array::New(env, segments.size());
+        for (size_t i = 0; i < segments.size(); i++) {
+            result.Set(static_cast<uint32_t>(i), segment_object(env, segments[i]));
+        }
+        return result;
+    }
+
+    Napi::Value list_memory(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        try {
+            return segment_array(env, list_segments());
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    Napi::Value gc_memory(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        bool dry_run = info.Length() >= 1 && info[0].IsObject() &&
+                       info[0].As<Napi::Object>().Get("dryRun").ToBoolean().Value();
+        try {
+            return segment_array(env, collect_orphans(dry_run));
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#ifdef SHARED_MEMORY_SHARED_ARRAY_BUFFER
+// 外部 SharedArrayBuffer 是 node_api 的实验接口
+#define NAPI_EXPERIMENTAL
+#endif
+#include "napi.h"
+#include "../memory.hh"
+
+namespace SharedMemory {
+    bool shared_arg(const Napi::Value& options) {
+        return options.IsObject() && options.As<Napi::Object>().Get("shared").ToBoolean().Value();
+    }
+
+#if defined(SHARED_MEMORY_SHARED_ARRAY_BUFFER) && defined(NODE_API_EXPERIMENTAL_HAS_EXTERNAL_SHAREDARRAYBUFFER)
+    // SharedArrayBuffer 回收时调用，释放其持有的管理器引用
+    static void release_shared_buffer(napi_env /*env*/, void* /*data*/, void* hint) {
+        delete static_cast<ViewReference*>(hint);
+    }
+
+    Napi::Value wrap_shared_buffer(Napi::Env env, const std::shared_ptr<SharedMemoryManager>& manager) {
+        // 与 ArrayBuffer 视图相同：地址和大小在锁内读取，旧映射保留到管理器销毁
+        MappingLock mapping_lock = manager->lock_mapping();
+        auto holder = new ViewReference(manager);
+        napi_value value;
+        napi_status status = node_api_create_external_sharedarraybuffer(env, manager->get_data(), manager->get_size(),
+                                                                         release_shared_buffer, holder, &value);
+        if (status != napi_ok) {
+            delete holder;
+            throw Napi::Error::New(env);
+        }
+        return Napi::Value(env, value);
+    }
+#else
+    Napi::Value wrap_shared_buffer(Napi::Env env, const std::shared_ptr<SharedMemoryManager>& /*manager*/) {
+        throw Napi::Error::New(env, "当前构建或 Node.js 版本不支持SharedArrayBuffer（需要 SHARED_MEMORY_SHARED_ARRAY_BUFFER=ON 且 node_api 提供外部 SharedArrayBuffer）");
+    }
+#endif
+
+    Napi::Value wrap_memory(Napi::Env env, const std::shared_ptr<SharedMemoryManager>& manager, bool shared, bool copy) {
+        if (shared) {
+            if (copy) {
+                throw Napi::Error::New(env, "SharedArrayBuffer不能是副本，shared 与 copy 不能同时使用");
+            }
+            return wrap_shared_buffer(env, manager);
+        }
+        return wrap_buffer(env, manager, copy);
+    }
+
+    Napi::Value wrap_memory(Napi::Env env, const std::shared_ptr<SharedMemoryManager>& manager, const Napi::Value& options) {
+        return wrap_memory(env, manager, shared_arg(options), copy_arg(options));
+    }
+}
@@ -0,0 +1,91 @@
+#include "napi.h"
+#include "../memory.hh"
+#include <memory>
+
+namespace SharedMemory {
+    // 写入者异常退出时顺序锁会停留在奇数，读者默认最多等待 1 秒
+    static const double DEFAULT_READ_TIMEOUT_MS = 1000;
+    // 写入者等待上一个写入结束的默认超时，与读者一致；同一命名空间内退出的写入者会被自动恢复
+    static const double DEFAULT_WRITE_TIMEOUT_MS = 1000;
+
+    static std::shared_ptr<SharedMemoryManager> manager_arg(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1) {
+            throw Napi::Error::New(env, "需要一个参数: key");
+        }
+        if (!info[0].IsString()) {
+            throw Napi::Error::New(env, "参数必须是字符串类型的key");
+        }
+        return acquire_manager(info[0].As<Napi::String>().Utf8Value());
+    }
+
+    Napi::Value begin_write(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        try {
+            double timeout_ms = DEFAULT_WRITE_TIMEOUT_MS;
+            if (info.Length() >= 2 && info[1].IsNumber()) {
+                timeout_ms = info[1].As<Napi::Number>().DoubleValue();
+            }
+            auto manager = manager_arg(info);
+            return Napi::Number::New(env, manager->begin_write(timeout_ms));
+        } catch (const Napi::Error&) {
+            throw;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    Napi::Value end_write(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        try {
+            auto manager = manager_arg(info);
+            return Napi::Number::New(env, manager->end_write());
+        } catch (const Napi::Error&) {
+            throw;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    Napi::Value read_consistent(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 4) {
+            throw Napi::Error::New(env, "需要参数: key, offset, length, target[, timeoutMs]");
+        }
+        if (!info[1].IsNumber() || !info[2].IsNumber()) {
+            throw Napi::Error::New(env, "offset和length必须是数字");
+        }
+        int64_t offset = info[1].As<Napi::Number>().Int64Value();
+        int64_t length = info[2].As<Napi::Number>().Int64Value();
+        if (offset < 0 || length < 0) {
+            throw Napi::RangeError::New(env, "offset和length不能为负数");
+        }
+
+        uint8_t* target;
+        size_t target_length;
+        if (!get_bytes(info[3], target, target_length)) {
+            throw Napi::Error::New(env, "target必须是 ArrayBuffer 或 TypedArray");
+        }
+        if (target_length < static_cast<uint64_t>(length)) {
+            throw Napi::RangeError::New(env, "target小于length");
+        }
+
+        double timeout_ms = DEFAULT_READ_TIMEOUT_MS;
+        if (info.Length() >= 5 && info[4].IsNumber()) {
+            timeout_ms = info[4].As<Napi::Number>().DoubleValue();
+        }
+
+        try {
+            auto manager = manager_arg(info);
+            uint32_t version = manager->read_consistent(static_cast<size_t>(offset), static_cast<size_t>(length), target, timeout_ms);
+            return Napi::Number::New(env, version);
+        } catch (const Napi::Error&) {
+            throw;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+}
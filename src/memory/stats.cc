@@ -0,0 +1,118 @@
+#include "napi.h"
+#include "../memory.hh"
+#include <string>
+
+namespace SharedMemory {
+    Napi::Value cache_stats(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+
+        CacheStats stats = get_cache_stats();
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("hits", Napi::Number::New(env, static_cast<double>(stats.hits)));
+        result.Set("misses", Napi::Number::New(env, static_cast<double>(stats.misses)));
+        result.Set("entries", Napi::Number::New(env, static_cast<double>(stats.entries)));
+        return result;
+    }
+
+    static Napi::Number number(Napi::Env env, uint64_t value) {
+        return Napi::Number::New(env, static_cast<double>(value));
+    }
+
+    static Napi::Object lock_counts(Napi::Env env, uint64_t acquisitions, uint64_t contended) {
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("acquisitions", number(env, acquisitions));
+        result.Set("contended", number(env, contended));
+        return result;
+    }
+
+    // 锁等待统计：分位数取所在桶的上界，直方图只列出非空桶 [上界纳秒, 次数]
+    static Napi::Object lock_wait(Napi::Env env, const SegmentStats& stats) {
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("count", number(env, stats.wait_count.load(std::memory_order_relaxed)));
+        result.Set("totalNs", number(env, stats.wait_total_ns.load(std::memory_order_relaxed)));
+        result.Set("maxNs", number(env, stats.wait_max_ns.load(std::memory_order_relaxed)));
+        result.Set("p50", number(env, lock_wait_percentile(stats, 0.5)));
+        result.Set("p90", number(env, lock_wait_percentile(stats, 0.9)));
+        result.Set("p99", number(env, lock_wait_percentile(stats, 0.99)));
+        result.Set("p999", number(env, lock_wait_percentile(stats, 0.999)));
+
+        Napi::Array histogram = Napi::Array::New(env);
+        uint32_t index = 0;
+        for (size_t i = 0; i < LOCK_WAIT_BUCKETS; i++) {
+            uint64_t count = stats.wait_histogram[i].load(std::memory_order_relaxed);
+            if (count) {
+                Napi::Array bucket = Napi::Array::New(env, 2);
+                bucket.Set(0u, number(env, lock_wait_bucket_bound(i)));
+                bucket.Set(1u, number(env, count));
+                histogram.Set(index++, bucket);
+            }
+        }
+        result.Set("histogram", histogram);
+        return result;
+    }
+
+    static Napi::Object segment_stats(Napi::Env env, const SharedMemoryManager& manager) {
+        Napi::Object result = Napi::Object::New(env);
+        MappingLock mapping_lock = manager.lock_mapping();
+        result.Set("size", number(env, manager.get_size()));
+        result.Set("mappedBytes", number(env, manager.get_mapped_bytes()));
+        result.Set("generation", number(env, manager.get_header_generation()));
+
+        // 旧版共享内存的头部没有统计
+        const SegmentStats* stats = manager.stats();
+        if (!stats) {
+            return result;
+        }
+        result.Set("opens", number(env, stats->opens.load(std::memory_order_relaxed)));
+        result.Set("closes", number(env, stats->closes.load(std::memory_order_relaxed)));
+        result.Set("remaps", number(env, stats->remaps.load(std::memory_order_relaxed)));
+
+        Napi::Object mutex = lock_counts(env, stats->lock_acquisitions.load(std::memory_order_relaxed),
+            stats->lock_contended.load(std::memory_order_relaxed));
+        mutex.Set("recoveries", number(env, stats->lock_recoveries.load(std::memory_order_relaxed)));
+        result.Set("lock", mutex);
+        result.Set("readLock", lock_counts(env, manager.read_acquisitions(),
+            stats->read_contended.load(std::memory_order_relaxed)));
+        result.Set("writeLock", lock_counts(env, stats->write_acquisitions.load(std::memory_order_relaxed),
+            stats->write_contended.load(std::memory_order_relaxed)));
+        result.Set("lockWait", lock_wait(env, *stats));
+        return result;
+    }
+
+    Napi::Value get_stats(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+
+        try {
+            ProcessStats process = get_process_stats();
+            CacheStats cache = get_cache_stats();
+            Napi::Object global = Napi::Object::New(env);
+            global.Set("mappings", number(env, process.mappings));
+            global.Set("mappedBytes", number(env, process.mapped_bytes));
+            global.Set("handles", number(env, process.handles));
+            global.Set("opens", number(env, process.opens));
+            global.Set("closes", number(env, process.closes));
+            global.Set("remaps", number(env, process.remaps));
+            global.Set("cacheHits", number(env, cache.hits));
+            global.Set("cacheMisses", number(env, cache.misses));
+
+            Napi::Object segments = Napi::Object::New(env);
+            if (info.Length() >= 1 && info[0].IsString()) {
+                std::string key = info[0].As<Napi::String>().Utf8Value();
+                segments.Set(key, segment_stats(env, *acquire_manager(key)));
+            }
+            else {
+                for (const auto& item : cached_managers()) {
+                    segments.Set(item.first, segment_stats(env, *item.second));
+                }
+            }
+
+            Napi::Object result = Napi::Object::New(env);
+            result.Set("global", global);
+            result.Set("segments", segments);
+            return result;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+}
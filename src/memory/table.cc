@@ -0,0 +1,203 @@
+#include "napi.h"
+#include "../memory.hh"
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace SharedMemory {
+    // 键和值可以是字符串（按 UTF-8 存储）、ArrayBuffer 或 TypedArray
+    static bool entry_bytes(const Napi::Value& value, std::string& storage, const uint8_t*& data, size_t& length) {
+        if (value.IsString()) {
+            storage = value.As<Napi::String>().Utf8Value();
+            data = reinterpret_cast<const uint8_t*>(storage.data());
+            length = storage.size();
+            return true;
+        }
+        uint8_t* bytes;
+        if (!get_bytes(value, bytes, length)) {
+            return false;
+        }
+        data = bytes;
+        return true;
+    }
+
+    // 共享哈希表：多个进程直接在共享内存中查找，无需反序列化
+    class HashMap : public Napi::ObjectWrap<HashMap> {
+    public:
+        static Napi::Function define(Napi::Env env) {
+            return DefineClass(env, "HashMap", {
+                InstanceMethod("get", &HashMap::get),
+                InstanceMethod("put", &HashMap::put),
+                InstanceMethod("delete", &HashMap::remove),
+                InstanceMethod("iterate", &HashMap::iterate),
+                InstanceAccessor("size", &HashMap::size, nullptr),
+                InstanceAccessor("capacity", &HashMap::capacity, nullptr),
+            });
+        }
+
+        // new HashMap(key) 打开，new HashMap(key, capacity[, { keySize, valueSize }]) 创建
+        HashMap(const Napi::CallbackInfo &info) : Napi::ObjectWrap<HashMap>(info) {
+            Napi::Env env = info.Env();
+
+            if (info.Length() < 1 || !info[0].IsString()) {
+                throw Napi::Error::New(env, "第一个参数必须是字符串类型的key");
+            }
+            std::string key = info[0].As<Napi::String>().Utf8Value();
+            bool create = info.Length() >= 2;
+
+            try {
+                if (create) {
+                    uint64_t capacity = size_arg(env, info[1], "capacity");
+                    if (capacity == 0) {
+                        throw Napi::Error::New(env, "capacity必须大于0");
+                    }
+                    uint64_t key_size = 64;
+                    uint64_t value_size = 256;
+                    if (info.Length() >= 3 && info[2].IsObject()) {
+                        Napi::Object options = info[2].As<Napi::Object>();
+                        if (options.Has("keySize")) {
+                            key_size = size_arg(env, options.Get("keySize"), "keySize");
+                        }
+                        if (options.Has("valueSize")) {
+                            value_size = size_arg(env, options.Get("valueSize"), "valueSize");
+                        }
+                    }
+                    auto manager = create_manager(key, SharedMap::segment_size(
+                        static_cast<size_t>(capacity), static_cast<size_t>(key_size), static_cast<size_t>(value_size)));
+                    map_ = std::make_unique<SharedMap>(manager, true, static_cast<size_t>(capacity),
+                        static_cast<size_t>(key_size), static_cast<size_t>(value_size));
+                }
+                else {
+                    map_ = std::make_unique<SharedMap>(acquire_manager(key), false);
+                }
+                value_.resize(map_->value_size());
+                LOG_DEBUG("Hash map %s: key=%s, capacity=%zu",
+                    create ? "created" : "opened", key.c_str(), map_->capacity());
+            } catch (const Napi::Error&) {
+                throw;
+            } catch (const std::exception& e) {
+                LOG_ERROR("Error: %s", e.what());
+                throw Napi::Error::New(env, e.what());
+            }
+        }
+
+    private:
+        // get(key) 返回值的 Buffer 副本，不存在时返回 null
+        Napi::Value get(const Napi::CallbackInfo &info) {
+            Napi::Env env = info.Env();
+            std::string storage;
+            const uint8_t* key;
+            size_t key_length;
+            if (info.Length() < 1 || !entry_bytes(info[0], storage, key, key_length)) {
+                throw Napi::Error::New(env, "键必须是字符串、ArrayBuffer 或 TypedArray");
+            }
+            try {
+                size_t value_length;
+                if (!map_->get(key, key_length, value_.data(), value_length)) {
+                    return env.Null();
+                }
+                return Napi::Buffer<uint8_t>::Copy(env, value_.data(), value_length);
+            } catch (const std::exception& e) {
+                throw Napi::Error::New(env, e.what());
+            }
+        }
+
+        // put(key, value) 插入或更新，表满时返回 false
+        Napi::Value put(const Napi::CallbackInfo &info) {
+            Napi::Env env = info.Env();
+            std::string key_storage;
+            std::string value_storage;
+            const uint8_t* key;
+            const uint8_t* value;
+            size_t key_length;
+            size_t value_length;
+            if (info.Length() < 2 || !entry_bytes(info[0], key_storage, key, key_length) ||
+                !entry_bytes(info[1], value_storage, value, value_length)) {
+                throw Napi::Error::New(env, "键和值必须是字符串、ArrayBuffer 或 TypedArray");
+            }
+            try {
+                return Napi::Boolean::New(env, map_->put(key, key_length, value, value_length));
+            } catch (const std::length_error& e) {
+                throw Napi::RangeError::New(env, e.what());
+            } catch (const std::exception& e) {
+                throw Napi::Error::New(env, e.what());
+            }
+        }
+
+        Napi::Value remove(const Napi::CallbackInfo &info) {
+            Napi::Env env = info.Env();
+            std::string storage;
+            const uint8_t* key;
+            size_t key_length;
+            if (info.Length() < 1 || !entry_bytes(info[0], storage, key, key_length)) {
+                throw Napi::Error::New(env, "键必须是字符串、ArrayBuffer 或 TypedArray");
+            }
+            try {
+                return Napi::Boolean::New(env, map_->remove(key, key_length));
+            } catch (const std::exception& e) {
+                throw Napi::Error::New(env, e.what());
+            }
+        }
+
+        // iterate(fn) 依次以 (key, value) 两个 Buffer 调用 fn，fn 返回 false 时停止
+        Napi::Value iterate(const Napi::CallbackInfo &info) {
+            Napi::Env env = info.Env();
+            if (info.Length() < 1 || !info[0].IsFunction()) {
+                throw Napi::Error::New(env, "参数必须是函数");
+            }
+            Napi::Function visit = info[0].As<Napi::Function>();
+            try {
+                map_->iterate([&](const uint8_t* key, size_t key_length, const uint8_t* value, size_t value_length) {
+                    Napi::HandleScope scope(env);
+                    Napi::Value result = visit.Call({
+                        Napi::Buffer<uint8_t>::Copy(env, key, key_length),
+                        Napi::Buffer<uint8_t>::Copy(env, value, value_length)
+                    });
+                    return !(result.IsBoolean() && !result.As<Napi::Boolean>().Value());
+                });
+            } catch (const Napi::Error&) {
+                throw;
+            } catch (const std::exception& e) {
+                throw Napi::Error::New(env, e.what());
+            }
+            return env.Undefined();
+        }
+
+        Napi::Value size(const Napi::CallbackInfo &info) {
+            return Napi::Number::New(info.Env(), static_cast<double>(map_->size()));
+        }
+
+        Napi::Value capacity(const Napi::CallbackInfo &info) {
+            return Napi::Number::New(info.Env(), static_cast<double>(map_->capacity()));
+        }
+
+        std::unique_ptr<SharedMap> map_;
+        std::vector<uint8_t> value_;    // get 的值缓冲区
+    };
+
+    void init_hash_map(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = HashMap::define(env);
+        addon_data(env).map_constructor = Napi::Persistent(ctor);
+        exports.Set(Napi::String::New(env, "HashMap"), ctor);
+    }
+
+    Napi::Value create_map(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 2) {
+            throw Napi::Error::New(env, "需要两个参数: key和capacity");
+        }
+        if (info.Length() >= 3) {
+            return addon_data(env).map_constructor.New({info[0], info[1], info[2]});
+        }
+        return addon_data(env).map_constructor.New({info[0], info[1]});
+    }
+
+    Napi::Value open_map(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1) {
+            throw Napi::Error::New(env, "需要一个参数: key");
+        }
+        return addon_data(env).map_constructor.New({info[0]});
+    }
+}
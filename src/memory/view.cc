@@ -0,0 +1,114 @@
+#include "napi.h"
+#include "../memory.hh"
+#include <cstdint>
+
+namespace SharedMemory {
+    bool copy_arg(const Napi::Value& options) {
+        return options.IsObject() && options.As<Napi::Object>().Get("copy").ToBoolean().Value();
+    }
+
+    Napi::ArrayBuffer wrap_window(Napi::Env env, const std::shared_ptr<SharedMemoryManager>& manager, size_t offset, size_t length,
+                                  bool copy) {
+        // 其他线程可能正在重新映射，地址和大小在锁内读取；旧映射保留到管理器销毁，视图之后仍然有效
+        MappingLock mapping_lock = manager->lock_mapping();
+        if (offset > manager->get_size() || length > manager->get_size() - offset) {
+            throw Napi::RangeError::New(env, "窗口超出共享内存范围");
+        }
+
+        // ArrayBuffer 总是可写的，只读映射上需要可写的缓冲区时由调用方要求副本
+        if (copy) {
+            Napi::ArrayBuffer copy = Napi::ArrayBuffer::New(env, length);
+            copy_bytes(copy.Data(), manager->get_data() + offset, length);
+            return copy;
+        }
+
+        // 获取数据区域的地址
+        void* data_addr = manager->get_data() + offset;
+
+        // ArrayBuffer 持有管理器的一份引用，回收时释放，最后一个引用释放时解除映射；可写视图存活期间不能封印写入
+        auto holder = new ViewReference(manager);
+        auto deleter = [](Napi::Env /*env*/, void* /*data*/, ViewReference* hint) {
+            delete hint;
+        };
+
+        // 创建ArrayBuffer，直接映射到共享内存
+        try {
+            return Napi::ArrayBuffer::New(env, data_addr, length, deleter, holder);
+        } catch (...) {
+            delete holder;
+            throw;
+        }
+    }
+
+    Napi::ArrayBuffer wrap_buffer(Napi::Env env, const std::shared_ptr<SharedMemoryManager>& manager, bool copy) {
+        MappingLock mapping_lock = manager->lock_mapping();
+        return wrap_window(env, manager, 0, manager->get_size(), copy);
+    }
+
+    uint64_t size_arg(Napi::Env env, const Napi::Value& value, const char* name) {
+        // 超过 4 GiB 的大小可以用 BigInt 或不超过 2^53-1 的整数 Number 传入
+        if (value.IsBigInt()) {
+            bool lossless = false;
+            uint64_t result = value.As<Napi::BigInt>().Uint64Value(&lossless);
+            if (!lossless) {
+                throw Napi::RangeError::New(env, std::string(name) + "必须是非负的64位整数");
+            }
+            return result;
+        }
+        if (!value.IsNumber()) {
+            throw Napi::Error::New(env, std::string(name) + "必须是数字或BigInt");
+        }
+        double number = value.As<Napi::Number>().DoubleValue();
+        if (!(number >= 0) || number > 9007199254740991.0 || number != static_cast<double>(static_cast<uint64_t>(number))) {
+            throw Napi::RangeError::New(env, std::string(name) + "必须是非负安全整数");
+        }
+        uint64_t result = static_cast<uint64_t>(number);
+        if (result > SIZE_MAX - PAGE_SIZE_BYTES) {
+            throw Napi::RangeError::New(env, std::string(name) + "超出平台可寻址范围");
+        }
+        return result;
+    }
+
+    Napi::Value get_window(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 3) {
+            throw Napi::Error::New(env, "需要三个参数: key、offset和length");
+        }
+        if (!info[0].IsString()) {
+            throw Napi::Error::New(env, "第一个参数必须是字符串类型的key");
+        }
+
+        std::string key = info[0].As<Napi::String>().Utf8Value();
+        uint64_t offset = size_arg(env, info[1], "offset");
+        uint64_t length = size_arg(env, info[2], "length");
+        bool copy = copy_arg(info.Length() >= 4 ? info[3] : env.Undefined());
+
+        try {
+            auto manager = acquire_manager(key);
+            manager->refresh();
+            return wrap_window(env, manager, static_cast<size_t>(offset), static_cast<size_t>(length), copy);
+        } catch (const Napi::Error&) {
+            throw;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error: %s", e.what());
+            throw Napi::Error::New(env, e.what());
+        }
+    }
+
+    bool get_bytes(const Napi::Value& value, uint8_t*& data, size_t& length) {
+        if (value.IsTypedArray()) {
+            Napi::TypedArray array = value.As<Napi::TypedArray>();
+            data = static_cast<uint8_t*>(array.ArrayBuffer().Data()) + array.ByteOffset();
+            length = array.ByteLength();
+            return true;
+        }
+        if (value.IsArrayBuffer()) {
+            Napi::ArrayBuffer buffer = value.As<Napi::ArrayBuffer>();
+            data = static_cast<uint8_t*>(buffer.Data());
+            length = buffer.ByteLength();
+            return true;
+        }
+        return false;
+    }
+}
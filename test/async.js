@@ -0,0 +1,22 @@
+const sharedMemory = require('../build/sharedMemory.node');
+const key = "async_2124";
+
+(async () => {
+    try {
+        sharedMemory.setConsole(console.info)
+        console.info('-------set async--------')
+        const created = await sharedMemory.setMemoryAsync(key, 64 * 1024 * 1024, 1000);
+        new Uint8Array(created).fill(7);
+
+        console.info('-------get async--------')
+        const opened = await sharedMemory.getMemoryAsync(key, 1000);
+        const view = new Uint8Array(opened);
+        console.log('Buffer length:', view.length, 'last byte:', view[view.length - 1]);
+
+        console.info('-------remove async--------')
+        console.log('共享内存已清理:', await sharedMemory.removeMemoryAsync(key));
+    } catch (error) {
+        console.error('操作失败:', error);
+        process.exit(1);
+    }
+})();
@@ -0,0 +1,49 @@
+const sharedMemory = require('../build/sharedMemory.node');
+
+const source = "bulk_a_2124";
+const target = "bulk_b_2124";
+const size = 32 << 20;
+
+(async () => {
+    try {
+        console.log('批量操作实现:', sharedMemory.bulkKernels());
+        const a = new Uint8Array(sharedMemory.setMemory(source, size));
+        const b = new Uint8Array(sharedMemory.setMemory(target, size));
+        for (let i = 0; i < size; i++) {
+            a[i] = i % 256;
+        }
+
+        // 大块复制使用非临时存储
+        sharedMemory.copyRegion(source, 0, target, 0, size);
+        console.log('复制后比较:', sharedMemory.compareRegions(source, 0, target, 0, size));
+        b[12345678] ^= 1;
+        console.log('第一个不同的位置:', sharedMemory.compareRegions(source, 0, target, 0, size));
+
+        // 同一共享内存内重叠的复制，内容为 i % 256，后移一字节后 b[i] 为 (i - 1) & 0xff
+        sharedMemory.copyRegion(target, 0, target, 1, 1000);
+        console.log('重叠复制:', b[1] === 0 && b[1000] === (999 & 0xff));
+
+        sharedMemory.fillRegion(target, 100, 50, 0xee);
+        console.log('查找:', sharedMemory.findByte(target, 0, 4096, 0xee), sharedMemory.findByte(target, 200, 55, 0xee));
+
+        // CRC32C("123456789") = 0xe3069283
+        sharedMemory.fillRegion(target, 0, 16);
+        new TextEncoder().encodeInto('123456789', b);
+        console.log('crc32c:', sharedMemory.checksum(target, 0, 9).toString(16));
+        console.log('xxh3:', sharedMemory.checksum(source, 0, size, 'xxh3'));
+
+        try {
+            sharedMemory.fillRegion(target, size - 10, 11);
+            console.log('越界应当报错');
+            process.exit(1);
+        } catch (error) {
+            console.log('越界:', error.message);
+        }
+
+        sharedMemory.removeMemory(source);
+        sharedMemory.removeMemory(target);
+    } catch (error) {
+        console.error('操作失败:', error);
+        process.exit(1);
+    }
+})();
@@ -0,0 +1,55 @@
+const sharedMemory = require('../build/sharedMemory.node');
+
+const source = "delta_a_2125";
+const replica = "delta_b_2125";
+const remote = "delta_c_2125";
+const size = 16 << 20;
+
+(async () => {
+    try {
+        const a = new Uint8Array(sharedMemory.setMemory(source, size, { trackDirty: 8192 }));
+        sharedMemory.setMemory(replica, 4096);
+        sharedMemory.setMemory(remote, size);
+        console.log('块大小:', sharedMemory.getMemoryInfo(source).dirtyBlockSize);
+
+        // 从纪元 0 收集得到全部内容，副本较小时自动扩展
+        let delta = sharedMemory.collectDelta(source, 0);
+        console.log('首次同步:', delta.ranges, sharedMemory.applyDelta(replica, delta));
+        let epoch = delta.epoch;
+
+        // 写入后标记，只同步变更的块
+        a[100] = 1;
+        a[5 * 8192 + 10] = 2;
+        a[size - 1] = 3;
+        sharedMemory.markDirty(source, 100, 1);
+        sharedMemory.markDirty(source, 5 * 8192 + 10, 1);
+        sharedMemory.markDirty(source, size - 1, 1);
+        sharedMemory.fillRegion(source, 9 * 8192, 8192, 4);
+        delta = sharedMemory.collectDelta(source, epoch, { data: true });
+        console.log('变更区间:', delta.ranges, '字节数:', delta.bytes, delta.data.byteLength);
+        epoch = delta.epoch;
+
+        // 经 data 传输的副本不需要访问源共享内存
+        sharedMemory.applyDelta(replica, { ranges: delta.ranges, key: source });
+        sharedMemory.applyDelta(remote, { ranges: delta.ranges, data: delta.data });
+        console.log('副本一致:', sharedMemory.compareRegions(source, 0, replica, 0, size),
+            sharedMemory.compareRegions(source, 0, remote, 0, size));
+
+        console.log('没有变更:', sharedMemory.collectDelta(source, epoch).ranges.length);
+
+        try {
+            sharedMemory.markDirty(remote, 0, 1);
+            console.log('未启用跟踪应当报错');
+            process.exit(1);
+        } catch (error) {
+            console.log('未启用跟踪:', error.message);
+        }
+
+        sharedMemory.removeMemory(source);
+        sharedMemory.removeMemory(replica);
+        sharedMemory.removeMemory(remote);
+    } catch (error) {
+        console.error('操作失败:', error);
+        process.exit(1);
+    }
+})();
@@ -0,0 +1,43 @@
+const sharedMemory = require('../build/sharedMemory.node');
+const { fork } = require('child_process');
+const key = "heap_2124";
+
+// 子进程：打开同一个堆，读取父进程写入的对象后释放
+if (process.argv[2] === 'child') {
+    const heap = sharedMemory.openHeap(key);
+    process.on('message', (offsets) => {
+        const texts = offsets.map((offset) => {
+            const view = new Uint8Array(heap.view(offset));
+            const text = Buffer.from(view).toString('utf8', 0, view.indexOf(0));
+            heap.free(offset);
+            return text;
+        });
+        process.send(texts);
+    });
+    return;
+}
+
+try {
+    const heap = sharedMemory.createHeap(key, 1024 * 1024);
+    const offsets = [];
+    for (let i = 0; i < 100; i++) {
+        const offset = heap.alloc(32);
+        const view = new Uint8Array(heap.view(offset));
+        view.fill(0);
+        Buffer.from(`object-${i}`).copy(view);
+        offsets.push(offset);
+    }
+
+    const child = fork(__filename, ['child']);
+    child.send(offsets);
+    child.on('message', (texts) => {
+        console.log('子进程读取:', texts.length, texts[0], texts[texts.length - 1]);
+        // 子进程释放后可以在父进程中复用
+        console.log('复用偏移:', offsets.includes(heap.alloc(32)));
+        child.kill();
+        sharedMemory.removeMemory(key);
+    });
+} catch (error) {
+    console.error('操作失败:', error);
+    process.exit(1);
+}
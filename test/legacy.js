@@ -0,0 +1,87 @@
+const sharedMemory = require('../build/sharedMemory.node');
+const { fork } = require('child_process');
+const fs = require('fs');
+
+const key = "legacy_2124";
+const path = `/dev/shm/skyline_${key}.dat`;
+const legacySize = 100;
+const grownSize = 64 * 1024;
+
+if (process.argv[2] === 'child') {
+    // 子进程以重新创建前的小数据区偏移映射，父进程重新创建后按代数重新映射
+    const offset = sharedMemory.getMemoryInfo(key).dataOffset;
+    process.on('message', () => {
+        const refreshed = sharedMemory.refresh(key);
+        const info = sharedMemory.getMemoryInfo(key);
+        const view = new Uint8Array(sharedMemory.getMemory(key));
+        process.send({ offset, refreshed, dataOffset: info.dataOffset, length: view.length, tail: view[grownSize - 1] },
+            () => process.exit(0));
+    });
+    process.send('ready');
+    return;
+}
+
+(async () => {
+    try {
+        if (process.platform !== 'linux') {
+            console.log('跳过: 只在 Linux 上构造旧版头部');
+            return;
+        }
+        // 旧版本创建的共享内存：16 字节头部（size、version、generation）之后紧跟数据区
+        const object = Buffer.alloc(16 + legacySize);
+        object.writeBigUInt64LE(BigInt(legacySize), 0);
+        object.write(`key:${key}`, 16);
+        fs.writeFileSync(path, object);
+
+        const info = sharedMemory.getMemoryInfo(key);
+        console.log('旧版头部:', info.legacy, info.size, info.dataOffset);
+        if (!info.legacy || info.size !== legacySize || info.dataOffset !== 16) {
+            throw new Error('没有识别出旧版头部');
+        }
+        const view = new Uint8Array(sharedMemory.getMemory(key));
+        const text = Buffer.from(view.subarray(0, key.length + 4)).toString();
+        console.log('旧版数据:', text);
+        if (text !== `key:${key}`) {
+            throw new Error('旧版数据区偏移错误');
+        }
+        // 旧版头部没有互斥锁
+        try {
+            sharedMemory.lock(key);
+            throw new Error('旧版共享内存加锁应当失败');
+        } catch (error) {
+            console.log('加锁:', error.message);
+        }
+
+        // 以新版格式重新创建，小数据区从缓存行开始
+        sharedMemory.setMemory(key, legacySize);
+        const small = sharedMemory.getMemoryInfo(key);
+        console.log('重新创建:', small.legacy, small.dataOffset);
+        if (small.legacy || small.dataOffset % 64 !== 0 || small.dataOffset >= 4096) {
+            throw new Error('没有转换为新版格式');
+        }
+
+        // 以更大的大小重新创建时数据区改为从页边界开始，已映射的进程刷新后按新偏移访问
+        const child = fork(__filename, ['child']);
+        await new Promise(resolve => child.once('message', resolve));
+        const grown = new Uint8Array(sharedMemory.setMemory(key, grownSize));
+        grown[grownSize - 1] = 9;
+        const large = sharedMemory.getMemoryInfo(key);
+        console.log('以更大的大小重新创建:', large.dataOffset);
+        if (large.dataOffset !== 4096) {
+            throw new Error('重新创建时没有重新计算数据区偏移');
+        }
+
+        child.send('recreated');
+        const result = await new Promise(resolve => child.once('message', resolve));
+        console.log('子进程:', result);
+        if (result.offset !== small.dataOffset || !result.refreshed || result.dataOffset !== 4096 ||
+            result.length !== grownSize || result.tail !== 9) {
+            throw new Error('子进程没有按新的数据区偏移重新映射');
+        }
+        await new Promise(resolve => child.on('exit', resolve));
+        sharedMemory.removeMemory(key);
+    } catch (error) {
+        console.error('操作失败:', error);
+        process.exit(1);
+    }
+})();
@@ -0,0 +1,36 @@
+const sharedMemory = require('../build/sharedMemory.node');
+const { fork } = require('child_process');
+
+const key = "lifecycle_2124";
+
+if (process.argv[2] === 'child') {
+    // 子进程创建后直接退出，不调用 removeMemory
+    new Uint8Array(sharedMemory.setMemory(key, 4096)).fill(7);
+    process.exit(0);
+}
+
+(async () => {
+    try {
+        await new Promise(resolve => fork(__filename, ['child']).on('exit', resolve));
+
+        // 创建者和附加进程都已退出，gc 回收
+        const segment = sharedMemory.listSegments().find(item => item.key === key);
+        console.log('子进程退出后:', segment);
+        // 子进程与本进程在同一 PID 命名空间，才能判断其是否已退出
+        console.log('其他命名空间:', segment.foreignNamespace);
+        console.log('dryRun:', sharedMemory.gc({ dryRun: true }).map(item => item.key));
+        console.log('回收:', sharedMemory.gc().map(item => item.key));
+        console.log('回收后仍存在:', sharedMemory.listSegments().some(item => item.key === key));
+
+        // 仍在映射中的共享内存不会被回收，删除名称后已有映射照常可用
+        const view = new Uint8Array(sharedMemory.setMemory(key, 4096));
+        view.fill(3);
+        console.log('附加计数:', sharedMemory.getMemoryInfo(key).attached);
+        console.log('gc 跳过:', !sharedMemory.gc().some(item => item.key === key));
+        console.log('删除:', sharedMemory.removeMemory(key), '再次删除:', sharedMemory.removeMemory(key));
+        console.log('删除后读取:', view[4095]);
+    } catch (error) {
+        console.error('操作失败:', error);
+        process.exit(1);
+    }
+})();
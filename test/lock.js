@@ -0,0 +1,37 @@
+const sharedMemory = require('../build/sharedMemory.node');
+const { fork } = require('child_process');
+const key = "lock_2124";
+
+// 子进程：获取锁后直接退出，不释放
+if (process.argv[2] === 'child') {
+    sharedMemory.getMemory(key);
+    console.log('子进程加锁:', sharedMemory.lock(key));
+    process.exit(0);
+}
+
+try {
+    sharedMemory.setMemory(key, 1024);
+    const child = fork(__filename, ['child']);
+    child.on('exit', () => {
+        // 持有者已退出，下一次加锁会恢复
+        console.log('父进程加锁:', sharedMemory.lock(key, 1000));
+        console.log('再次尝试:', sharedMemory.tryLock(key));
+        // 持有锁时在同一线程中扩展或重新创建会自锁，直接报错
+        for (const action of [() => sharedMemory.resizeMemory(key, 2048), () => sharedMemory.setMemory(key, 1024)]) {
+            try {
+                action();
+                console.error('持有锁时未报错');
+                process.exit(1);
+            } catch (error) {
+                console.log('持有锁时:', error.message);
+            }
+        }
+        console.log('无限超时:', sharedMemory.tryLock(key), sharedMemory.readLock(key, Infinity));
+        sharedMemory.readUnlock(key);
+        sharedMemory.unlock(key);
+        sharedMemory.removeMemory(key);
+    });
+} catch (error) {
+    console.error('操作失败:', error);
+    process.exit(1);
+}
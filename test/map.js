@@ -0,0 +1,75 @@
+const sharedMemory = require('../build/sharedMemory.node');
+const { fork } = require('child_process');
+const key = "map_2124";
+
+// 子进程：直接在共享内存中查找父进程写入的键
+if (process.argv[2] === 'child') {
+    const map = sharedMemory.openMap(key);
+    const start = process.hrtime.bigint();
+    let hits = 0;
+    for (let i = 0; i < 100000; i++) {
+        if (map.get(`key-${i % 1000}`) !== null) {
+            hits++;
+        }
+    }
+    const elapsed = Number(process.hrtime.bigint() - start);
+    process.send({ hits, nsPerGet: Math.round(elapsed / 100000) });
+    return;
+}
+
+try {
+    const map = sharedMemory.createMap(key, 1000, { keySize: 32, valueSize: 64 });
+    for (let i = 0; i < 1000; i++) {
+        map.put(`key-${i}`, `value-${i}`);
+    }
+    console.log('size:', map.size, 'get:', map.get('key-42').toString());
+    console.log('delete:', map.delete('key-999'), map.get('key-999'));
+
+    let count = 0;
+    map.iterate(() => { count++; });
+    console.log('iterate:', count);
+
+    // 反复插入删除后，未命中的查找不应退化为扫描所有桶，仍在的键不受影响
+    const churnKey = `${key}_churn`;
+    const churn = sharedMemory.createMap(churnKey, 1000, { keySize: 32, valueSize: 64 });
+    for (let i = 0; i < 500; i++) {
+        churn.put(`live-${i}`, `value-${i}`);
+    }
+    const missTime = () => {
+        const start = process.hrtime.bigint();
+        for (let i = 0; i < 10000; i++) {
+            churn.get(`miss-${i}`);
+        }
+        return Number(process.hrtime.bigint() - start) / 10000;
+    };
+    const fresh = missTime();
+    for (let round = 0; round < 100; round++) {
+        for (let i = 0; i < 500; i++) {
+            churn.put(`churn-${round}-${i}`, 'x');
+        }
+        for (let i = 0; i < 500; i++) {
+            churn.delete(`churn-${round}-${i}`);
+        }
+    }
+    const churned = missTime();
+    console.log('churn miss ns:', Math.round(fresh), '->', Math.round(churned));
+    for (let i = 0; i < 500; i++) {
+        const value = churn.get(`live-${i}`);
+        if (value === null || value.toString() !== `value-${i}`) {
+            throw new Error(`反复插入删除后丢失键 live-${i}`);
+        }
+    }
+    if (churn.size !== 500 || churned > fresh * 4 + 1000) {
+        throw new Error(`反复插入删除后查找变慢: size ${churn.size}, ${fresh} -> ${churned} ns`);
+    }
+    sharedMemory.removeMemory(churnKey);
+
+    const child = fork(__filename, ['child']);
+    child.on('message', (result) => {
+        console.log(JSON.stringify(result));
+        sharedMemory.removeMemory(key);
+    });
+} catch (error) {
+    console.error('操作失败:', error);
+    process.exit(1);
+}
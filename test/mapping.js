@@ -0,0 +1,17 @@
+const sharedMemory = require('../build/sharedMemory.node');
+const key = "mapping_2124";
+
+try {
+    // 不可用的模式会降级，实际生效的选项由 getMemoryInfo 给出
+    const buffer = sharedMemory.setMemory(key, 8 * 1024 * 1024, { hugePages: 'explicit', populate: true, lock: true });
+    console.log('创建:', buffer.byteLength, sharedMemory.getMemoryInfo(key));
+
+    // 缓存命中时选项应用到已有映射
+    sharedMemory.getMemory(key, { hugePages: 'transparent', populate: true });
+    console.log('打开:', sharedMemory.getMemoryInfo(key));
+
+    sharedMemory.removeMemory(key);
+} catch (error) {
+    console.error('操作失败:', error);
+    process.exit(1);
+}
@@ -0,0 +1,101 @@
+const sharedMemory = require('../build/sharedMemory.node');
+const { spawn } = require('child_process');
+const fs = require('fs');
+const v8 = require('v8');
+const vm = require('vm');
+
+const key = "memfd_2124";
+
+if (process.argv[2] === 'child') {
+    // 子进程从继承的 fd 3 接收共享内存，没有经过 /dev/shm 中的名称；等待在线程池中进行
+    (async () => {
+        const first = await sharedMemory.importFdAsync(3);
+        console.log('子进程收到:', first.key, new Uint8Array(first.buffer)[0]);
+        const sealed = await sharedMemory.importFdAsync(3, { timeoutMs: 5000 });
+        console.log('子进程收到封印后的共享内存:', sharedMemory.getMemoryInfo(sealed.key));
+        // 只读映射返回不拷贝的视图，这里只读取；需要修改时取副本，写入副本不会使进程崩溃
+        console.log('只读视图:', new Uint8Array(sealed.buffer)[1]);
+        const copy = new Uint8Array(sharedMemory.getMemory(sealed.key, { copy: true }));
+        copy[1] = 0;
+        console.log('副本写入后视图不变:', new Uint8Array(sealed.buffer)[1]);
+        process.exit(0);
+    })().catch(error => {
+        console.error('子进程失败:', error);
+        process.exit(1);
+    });
+    return;
+}
+
+// 可写视图被回收后才能封印写入，这里强制垃圾回收并等待 ArrayBuffer 的回收回调
+v8.setFlagsFromString('--expose-gc');
+const gc = vm.runInNewContext('gc');
+async function collect() {
+    for (let i = 0; i < 3; i++) {
+        gc();
+        await new Promise(resolve => setImmediate(resolve));
+    }
+}
+
+(async () => {
+    try {
+        const view = new Uint8Array(sharedMemory.setMemory(key, 4096, { backend: 'memfd' }));
+        view[0] = 42;
+        view[1] = 7;
+        console.log('memfd:', sharedMemory.getMemoryInfo(key).backend);
+
+        const [parent, child] = sharedMemory.socketPair();
+        const worker = spawn(process.execPath, [__filename, 'child'], { stdio: ['inherit', 'inherit', 'inherit', child] });
+        fs.closeSync(child);
+        sharedMemory.exportFd(key, parent);
+
+        // 封印写入后本进程的映射变为只读，接收方不必担心发送方再修改；可写视图存活时拒绝封印
+        const sealedKey = key + "_sealed";
+        let writable = new Uint8Array(sharedMemory.setMemory(sealedKey, 4096, { backend: 'memfd' }));
+        writable.fill(7);
+        try {
+            sharedMemory.sealMemory(sealedKey, { write: true });
+            throw new Error('仍有可写视图时不应能封印');
+        } catch (error) {
+            console.log('有可写视图时封印失败:', error.message);
+        }
+        writable = null;
+        await collect();
+        sharedMemory.sealMemory(sealedKey, { write: true });
+        console.log('封印:', sharedMemory.getMemoryInfo(sealedKey).seals);
+        try {
+            sharedMemory.writeLock(sealedKey);
+            throw new Error('只读共享内存不应能加写锁');
+        } catch (error) {
+            console.log('加锁失败:', error.message);
+        }
+        sharedMemory.exportFd(sealedKey, parent);
+
+        await new Promise(resolve => worker.on('exit', resolve));
+        fs.closeSync(parent);
+
+        // 本地套接字对也可在同一进程中收发；键名已在本进程中映射时不覆盖，需另取键名
+        const [a, b] = sharedMemory.socketPair();
+        sharedMemory.exportFd(key, a);
+        try {
+            sharedMemory.importFd(b, { timeoutMs: 1000 });
+            throw new Error('同名映射不应被覆盖');
+        } catch (error) {
+            console.log('同名导入失败:', error.message);
+        }
+        try {
+            sharedMemory.importFd(b, { timeoutMs: Infinity });
+            throw new Error('importFd 不应接受无限超时');
+        } catch (error) {
+            console.log('无限超时:', error.message);
+        }
+        sharedMemory.exportFd(key, a);
+        const local = sharedMemory.importFd(b, { timeoutMs: 1000, key: key + "_local" });
+        console.log('本地收到:', local.key, new Uint8Array(local.buffer)[0]);
+        console.log('保留的描述符:', sharedMemory.getStats().global.handles);
+        fs.closeSync(a);
+        fs.closeSync(b);
+    } catch (error) {
+        console.error('操作失败:', error);
+        process.exit(1);
+    }
+})();
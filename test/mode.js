@@ -0,0 +1,47 @@
+const sharedMemory = require('../build/sharedMemory.node');
+
+const key = "mode_2323";
+
+(async () => {
+    try {
+        const writer = new Uint8Array(sharedMemory.setMemory(key, 1 << 16));
+        writer.fill(7, 100, 200);
+
+        // copy: true 返回当前内容的副本，写入副本不影响共享内存，也不会使进程崩溃
+        const snapshot = new Uint8Array(sharedMemory.getMemory(key, { mode: 'readonly', copy: true }));
+        snapshot[150] = 1;
+        console.log('只读副本:', snapshot[120], '共享内存:', writer[150]);
+        if (snapshot[120] !== 7 || writer[150] !== 7) {
+            throw new Error('只读副本内容错误');
+        }
+
+        // 只读映射默认返回不拷贝的视图，看得到写入方的修改，写入会使进程崩溃，这里只读取
+        const reader = new Uint8Array(sharedMemory.getMemory(key, { mode: 'readonly' }));
+        writer[150] = 9;
+        console.log('只读映射读取:', reader[150], '副本不变:', snapshot[150]);
+        if (reader[150] !== 9 || snapshot[150] !== 1) {
+            throw new Error('只读视图没有看到写入方的修改');
+        }
+        console.log('读写映射不受影响:', sharedMemory.getMemoryInfo(key).mode);
+
+        // 私有映射的写入只在本映射可见，未写过的页面仍随共享内存变化
+        const copy = new Uint8Array(sharedMemory.getMemory(key, { mode: 'private' }));
+        copy[150] = 42;
+        writer[30000] = 12;
+        console.log('私有写入后共享内存:', writer[150], '私有映射:', copy[150]);
+        console.log('未写过的页面:', copy[30000]);
+
+        try {
+            sharedMemory.getMemory(key, { mode: 'copy' });
+            console.log('无效的 mode 应当报错');
+            process.exit(1);
+        } catch (error) {
+            console.log('无效的 mode:', error.message);
+        }
+
+        sharedMemory.removeMemory(key);
+    } catch (error) {
+        console.error('操作失败:', error);
+        process.exit(1);
+    }
+})();
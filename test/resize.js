@@ -0,0 +1,67 @@
+const sharedMemory = require('../build/sharedMemory.node');
+const { fork } = require('child_process');
+
+const key = "resize_2124";
+const initialSize = 4096;
+const grownSize = 64 * 1024;
+// 数据区开头是 setMemory 写入的 "key:" + key，测试数据放在其后
+const marker = 100;
+
+if (process.argv[2] === 'child') {
+    // 子进程先映射原大小，等父进程扩展后按代数重新映射
+    const before = new Uint8Array(sharedMemory.getMemory(key));
+    const generation = sharedMemory.getGeneration(key);
+    process.on('message', () => {
+        const result = {
+            oldLength: before.length,
+            generationChanged: sharedMemory.getGeneration(key) !== generation,
+            refreshed: sharedMemory.refresh(key),
+            refreshedAgain: sharedMemory.refresh(key),
+            newLength: new Uint8Array(sharedMemory.getMemory(key)).length,
+            tail: new Uint8Array(sharedMemory.getMemory(key))[grownSize - 1],
+            // 旧视图在重新映射后仍然有效
+            oldMarker: before[marker],
+        };
+        process.send(result, () => process.exit(0));
+    });
+    process.send('ready');
+    return;
+}
+
+(async () => {
+    try {
+        const view = new Uint8Array(sharedMemory.setMemory(key, initialSize));
+        view[marker] = 42;
+
+        const child = fork(__filename, ['child']);
+        await new Promise(resolve => child.once('message', resolve));
+
+        const generation = sharedMemory.getGeneration(key);
+        const grown = new Uint8Array(sharedMemory.resizeMemory(key, grownSize));
+        grown[grownSize - 1] = 7;
+        console.log('扩展后:', grown.length, '代数增加:', sharedMemory.getGeneration(key) > generation);
+        console.log('扩展后的原有数据:', grown[marker]);
+
+        // 不支持缩小，请求的大小小于当前大小时报错
+        try {
+            sharedMemory.resizeMemory(key, initialSize);
+            throw new Error('缩小应当失败');
+        } catch (error) {
+            console.log('缩小:', error.message);
+        }
+
+        child.send('grown');
+        const result = await new Promise(resolve => child.once('message', resolve));
+        console.log('子进程:', result);
+        if (!result.generationChanged || !result.refreshed || result.refreshedAgain ||
+            result.oldLength !== initialSize || result.newLength !== grownSize ||
+            result.tail !== 7 || result.oldMarker !== 42) {
+            throw new Error('子进程没有看到扩展');
+        }
+        await new Promise(resolve => child.on('exit', resolve));
+        sharedMemory.removeMemory(key);
+    } catch (error) {
+        console.error('操作失败:', error);
+        process.exit(1);
+    }
+})();
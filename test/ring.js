@@ -0,0 +1,67 @@
+const sharedMemory = require('../build/sharedMemory.node');
+const { fork } = require('child_process');
+
+const key = "ring_2124";
+const capacity = 1 << 20;
+const count = 1000000;
+
+// 消费者：读取生产者写入的时间戳，统计单条消息延迟
+function consumer() {
+    const ring = sharedMemory.openRing(key);
+    const frame = new BigUint64Array(2);
+    const bytes = new Uint8Array(frame.buffer);
+    const latencies = new Float64Array(count);
+    let received = 0;
+    const start = process.hrtime.bigint();
+    while (received < count) {
+        if (ring.pop(bytes) === null) {
+            continue;
+        }
+        latencies[received++] = Number(process.hrtime.bigint() - frame[0]);
+    }
+    const elapsed = Number(process.hrtime.bigint() - start);
+
+    latencies.sort();
+    const result = {
+        messages: count,
+        messagesPerSecond: Math.round(count / (elapsed / 1e9)),
+        latencyNs: {
+            p50: latencies[Math.floor(count * 0.5)],
+            p99: latencies[Math.floor(count * 0.99)],
+            max: latencies[count - 1],
+        },
+    };
+    process.send(result);
+}
+
+// 生产者：每条消息携带写入时刻的单调时钟
+async function producer() {
+    const ring = sharedMemory.createRing(key, capacity);
+    const child = fork(__filename, ['consumer']);
+    const done = new Promise(resolve => child.on('message', resolve));
+
+    // 等待消费者就绪
+    await new Promise(resolve => setTimeout(resolve, 500));
+
+    const frame = new BigUint64Array(2);
+    for (let i = 0; i < count; i++) {
+        frame[1] = BigInt(i);
+        frame[0] = process.hrtime.bigint();
+        while (!ring.push(frame)) {
+            frame[0] = process.hrtime.bigint();
+        }
+    }
+
+    const result = await done;
+    console.log(JSON.stringify(result));
+    sharedMemory.removeMemory(key);
+}
+
+if (process.argv[2] === 'consumer') {
+    consumer();
+} else {
+    producer().catch(error => {
+        console.error('操作失败:', error);
+        process.exit(1);
+    });
+}
@@ -0,0 +1,55 @@
+const sharedMemory = require('../build/sharedMemory.node');
+const { fork } = require('child_process');
+const key = "rwlock_2124";
+const rounds = 100000;
+// 数据区开头是 setMemory 写入的 "key:" + key，计数放在其后
+const offset = 64;
+
+// 子进程：读写混合，读者校验两个计数始终一致
+function worker() {
+    const view = new Float64Array(sharedMemory.getMemory(key), offset, 2);
+    for (let i = 0; i < rounds; i++) {
+        if (i % 10 === 0) {
+            sharedMemory.writeLock(key);
+            view[0]++;
+            view[1]++;
+            sharedMemory.writeUnlock(key);
+        } else {
+            sharedMemory.readLock(key);
+            if (view[0] !== view[1]) {
+                throw new Error('读到不一致的数据');
+            }
+            sharedMemory.readUnlock(key);
+        }
+    }
+}
+
+if (process.argv[2] === 'child') {
+    worker();
+    return;
+}
+
+try {
+    const counters = new Float64Array(sharedMemory.setMemory(key, 1024), offset, 2);
+    counters.fill(0);
+    console.log('带超时的写锁:', sharedMemory.writeLock(key, 100));
+    console.log('写锁期间的读锁:', sharedMemory.readLock(key, 10));
+    sharedMemory.writeUnlock(key);
+
+    const children = [0, 1, 2, 3].map(() => fork(__filename, ['child']));
+    let exited = 0;
+    const start = process.hrtime.bigint();
+    children.forEach((child) => child.on('exit', (code) => {
+        if (code !== 0) {
+            process.exitCode = 1;
+        }
+        if (++exited === children.length) {
+            const elapsed = Number(process.hrtime.bigint() - start) / 1e6;
+            console.log(JSON.stringify({ writes: counters[0], elapsedMs: Math.round(elapsed) }));
+            sharedMemory.removeMemory(key);
+        }
+    }));
+} catch (error) {
+    console.error('操作失败:', error);
+    process.exit(1);
+}
@@ -0,0 +1,47 @@
+const sharedMemory = require('../build/sharedMemory.node');
+const { Worker } = require('worker_threads');
+
+const key = "shared_2124";
+
+(async () => {
+    try {
+        // { shared: true } 返回 SharedArrayBuffer，可直接使用 Atomics；
+        // 构建时未开启 SHARED_MEMORY_SHARED_ARRAY_BUFFER 或 node_api 不支持时报错，跳过测试
+        sharedMemory.setMemory(key, 4096);
+        let buffer;
+        try {
+            buffer = sharedMemory.getMemory(key, { shared: true });
+        } catch (error) {
+            console.log('跳过:', error.message);
+            sharedMemory.removeMemory(key);
+            return;
+        }
+        console.log('SharedArrayBuffer:', buffer instanceof SharedArrayBuffer, buffer.byteLength);
+        const view = new Int32Array(buffer);
+        Atomics.store(view, 0, 0);
+        console.log('compareExchange:', Atomics.compareExchange(view, 0, 0, 1), Atomics.load(view, 0));
+
+        // 同一映射再次获取时共用同一块内存
+        const again = new Int32Array(sharedMemory.getMemory(key, { shared: true }));
+        console.log('再次获取:', Atomics.load(again, 0));
+
+        // 传给 worker 不拷贝，worker 写入后用 Atomics.notify 唤醒主线程
+        const worker = new Worker(`
+            const { workerData } = require('worker_threads');
+            const view = new Int32Array(workerData);
+            Atomics.store(view, 1, 42);
+            Atomics.notify(view, 1);
+        `, { eval: true, workerData: buffer });
+        const result = await Atomics.waitAsync(view, 1, 0, 5000).value;
+        console.log('worker 唤醒:', result, Atomics.load(view, 1));
+        await new Promise(resolve => worker.on('exit', resolve));
+
+        // 默认仍返回 ArrayBuffer
+        console.log('默认 ArrayBuffer:', sharedMemory.getMemory(key) instanceof ArrayBuffer);
+
+        sharedMemory.removeMemory(key);
+    } catch (error) {
+        console.error('操作失败:', error);
+        process.exit(1);
+    }
+})();
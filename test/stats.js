@@ -0,0 +1,32 @@
+const sharedMemory = require('../build/sharedMemory.node');
+const { fork } = require('child_process');
+const key = "stats_2124";
+
+// 子进程：与父进程争用写锁
+if (process.argv[2] === 'child') {
+    sharedMemory.getMemory(key);
+    for (let i = 0; i < 10000; i++) {
+        sharedMemory.writeLock(key);
+        sharedMemory.writeUnlock(key);
+    }
+    process.exit(0);
+}
+
+try {
+    sharedMemory.setMemory(key, 1024);
+    const child = fork(__filename, ['child']);
+    for (let i = 0; i < 10000; i++) {
+        sharedMemory.readLock(key);
+        sharedMemory.readUnlock(key);
+    }
+    child.on('exit', () => {
+        // 头部中的统计包含子进程的计数
+        const stats = sharedMemory.getStats(key);
+        console.log('全局:', stats.global);
+        console.log('共享内存:', JSON.stringify(stats.segments[key], null, 2));
+        sharedMemory.removeMemory(key);
+    });
+} catch (error) {
+    console.error('操作失败:', error);
+    process.exit(1);
+}
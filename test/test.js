@@ -10,6 +10,8 @@ try {
     console.info('\n-------get--------')
     sharedMemory.getMemory(key);
     console.info('\nGet result:', result)
+    sharedMemory.getMemory(key);
+    console.info('\nCache stats:', sharedMemory.getCacheStats())
     
 } catch (error) {
     console.error('操作失败:', error.message);
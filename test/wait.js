@@ -0,0 +1,55 @@
+const sharedMemory = require('../build/sharedMemory.node');
+const { fork } = require('child_process');
+
+const key = "wait_2124";
+const rounds = 1000;
+
+// 子进程：等待父进程写入序号，记录唤醒延迟
+async function waiter() {
+    const view = new Int32Array(sharedMemory.getMemory(key));
+    const stamp = new BigUint64Array(sharedMemory.getMemory(key), 8, 1);
+    const latencies = [];
+    for (let i = 1; i <= rounds; i++) {
+        while (Atomics.load(view, 0) < i) {
+            await sharedMemory.waitAsync(key, 0, i - 1, 1000);
+        }
+        latencies.push(Number(process.hrtime.bigint() - stamp[0]));
+        Atomics.store(view, 1, i);
+        sharedMemory.notify(key, 4, 1);
+    }
+    latencies.sort((a, b) => a - b);
+    process.send({ rounds, p50: latencies[rounds >> 1], p99: latencies[Math.floor(rounds * 0.99)] });
+}
+
+async function main() {
+    const buffer = sharedMemory.setMemory(key, 64);
+    const view = new Int32Array(buffer);
+    const stamp = new BigUint64Array(buffer, 8, 1);
+    view.fill(0);
+
+    const child = fork(__filename, ['waiter']);
+    const done = new Promise(resolve => child.on('message', resolve));
+    await new Promise(resolve => setTimeout(resolve, 500));
+
+    for (let i = 1; i <= rounds; i++) {
+        stamp[0] = process.hrtime.bigint();
+        Atomics.store(view, 0, i);
+        sharedMemory.notify(key, 0);
+        // 等待子进程确认
+        while (sharedMemory.wait(key, 4, i - 1, 1000) === 'timed-out') {
+            console.error('等待确认超时', i);
+        }
+    }
+
+    console.log(JSON.stringify(await done));
+    sharedMemory.removeMemory(key);
+}
+
+if (process.argv[2] === 'waiter') {
+    waiter();
+} else {
+    main().catch(error => {
+        console.error('操作失败:', error);
+        process.exit(1);
+    });
+}
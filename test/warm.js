@@ -0,0 +1,30 @@
+const sharedMemory = require('../build/sharedMemory.node');
+const key = "warm_2124";
+const size = 512 * 1024 * 1024;
+
+(async () => {
+    try {
+        // 新建的共享内存不再逐页清零，立即返回
+        let start = process.hrtime.bigint();
+        const buffer = sharedMemory.setMemory(key, size);
+        console.log('创建耗时(ms):', Number(process.hrtime.bigint() - start) / 1e6);
+
+        // 在工作线程中并行预取全部页面
+        start = process.hrtime.bigint();
+        const bytes = await sharedMemory.warm(key, { threads: 4 });
+        console.log('预取:', bytes, '耗时(ms):', Number(process.hrtime.bigint() - start) / 1e6);
+
+        // 预取后首次访问不再缺页
+        const view = new Uint8Array(buffer);
+        start = process.hrtime.bigint();
+        for (let i = 0; i < size; i += 4096) {
+            view[i] = 1;
+        }
+        console.log('逐页写入耗时(ms):', Number(process.hrtime.bigint() - start) / 1e6);
+
+        sharedMemory.removeMemory(key);
+    } catch (error) {
+        console.error('操作失败:', error);
+        process.exit(1);
+    }
+})();
@@ -0,0 +1,55 @@
+const sharedMemory = require('../build/sharedMemory.node');
+const { Worker, isMainThread, parentPort, workerData } = require('worker_threads');
+
+const key = "worker_2124";
+const size = 64 * 1024 * 1024;
+const workers = 4;
+
+if (!isMainThread) {
+    // 每个 worker 各自加载模块，取出主线程交来的映射，并行填充自己的分片
+    sharedMemory.setConsole(message => parentPort.postMessage({ log: message }), 'warn');
+    const view = new Uint8Array(sharedMemory.attachMemory(workerData.handle));
+    const chunk = size / workers;
+    view.fill(workerData.index + 1, workerData.index * chunk, (workerData.index + 1) * chunk);
+    parentPort.postMessage({ done: true, mappings: sharedMemory.getStats().global.mappings });
+    return;
+}
+
+(async () => {
+    try {
+        sharedMemory.setConsole(message => console.log('主线程日志:', message), 'warn');
+        const view = new Uint8Array(sharedMemory.setMemory(key, size));
+
+        const results = await Promise.all(Array.from({ length: workers }, (_, index) => new Promise((resolve, reject) => {
+            // 句柄只是数字，传给 worker 时不拷贝共享内存
+            const worker = new Worker(__filename, { workerData: { index, handle: sharedMemory.shareMemory(key) } });
+            worker.on('message', message => message.done ? resolve(message) : console.log('worker 日志:', message.log));
+            worker.on('error', reject);
+        })));
+
+        // 所有环境共用同一个 mmap
+        console.log('worker 中的映射数:', results.map(result => result.mappings));
+        const chunk = size / workers;
+        for (let i = 0; i < workers; i++) {
+            if (view[i * chunk] !== i + 1 || view[(i + 1) * chunk - 1] !== i + 1) {
+                throw new Error(`分片 ${i} 内容不正确`);
+            }
+        }
+        console.log('映射数:', sharedMemory.getStats().global.mappings);
+
+        // 句柄只能取出一次
+        const handle = sharedMemory.shareMemory(key);
+        sharedMemory.attachMemory(handle);
+        try {
+            sharedMemory.attachMemory(handle);
+            throw new Error('重复取出句柄应当失败');
+        } catch (error) {
+            console.log('重复取出:', error.message);
+        }
+
+        sharedMemory.removeMemory(key);
+    } catch (error) {
+        console.error('操作失败:', error);
+        process.exit(1);
+    }
+})();